@@ -33,10 +33,32 @@
  * */
 
 #include <stdint.h>
+#include <stddef.h>
 
 /** block cipher block size in bytes */
 #define AES_BLOCK_SIZE  16U
 
+/** alignment in bytes of the round keys in struct aes_ctxt
+ *
+ * Must be a power of two no less than 8. Use 64 to keep every
+ * schedule on as few cache lines as possible.
+ *
+ * */
+#ifndef MODA_AES_ALIGN
+    #define MODA_AES_ALIGN 16
+#endif
+
+/** compiler specific attribute to align an object to N bytes */
+#ifndef MODA_ALIGN
+    #if defined(__GNUC__) || defined(__clang__)
+        #define MODA_ALIGN(N) __attribute__((aligned(N)))
+    #elif defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L)
+        #define MODA_ALIGN(N) _Alignas(N)
+    #else
+        #error "define MODA_ALIGN(N) for this compiler"
+    #endif
+#endif
+
 /** Supported key sizes */
 enum aes_key_size {
 
@@ -45,10 +67,36 @@ enum aes_key_size {
     AES_KEY_256 = 32U   /**< AES-256 */
 };
 
-/** Stores the expanded key */
+/** Stores the expanded key
+ *
+ * Round keys are #MODA_AES_ALIGN aligned so they may be accessed as
+ * native words and no round key straddles a cache line. Contexts that
+ * are allocated dynamically must respect this alignment.
+ *
+ * With MODA_AES_OTF only the key is stored (33 bytes, no alignment
+ * requirement) and round keys are derived as each block is processed.
+ *
+ * */
 struct aes_ctxt {
 
-    uint8_t k[240U];    /**< expanded key */
+#if defined(MODA_AES_OTF)
+    uint8_t k[32U];     /**< key */
+#else
+    MODA_ALIGN(MODA_AES_ALIGN) uint8_t k[240U];     /**< expanded key */
+#endif
+#if defined(MODA_AES_DECRYPT_SCHEDULE)
+    MODA_ALIGN(MODA_AES_ALIGN) uint8_t dk[240U];    /**< equivalent inverse cipher expanded key */
+#endif
+#if defined(MODA_AES_BITSLICE)
+    uint64_t sk[30U];   /**< compressed bitsliced expanded key */
+#endif
+#if defined(MODA_AES_SBOX_COMPUTED) && !defined(MODA_AES_OTF)
+#if defined(MODA_WORD_SIZE) && (MODA_WORD_SIZE == 8U)
+    uint64_t sk[120U];  /**< sliced expanded key (moda_slice_t) */
+#else
+    uint32_t sk[120U];  /**< sliced expanded key (moda_slice_t) */
+#endif
+#endif
     uint8_t r;          /**< number of rounds */
 };
 
@@ -62,6 +110,21 @@ struct aes_ctxt {
  * */
 void MODA_AES_Init(struct aes_ctxt *aes, enum aes_key_size keySize, const uint8_t *key);
 
+/**
+ * Initialise several AES block ciphers with keys of the same size
+ *
+ * Equivalent to calling MODA_AES_Init() for each key, but schedules are
+ * expanded side by side so that SubWord can use SIMD or the bitsliced
+ * S-box where the engine allows.
+ *
+ * @param[out] aes array of `n` contexts
+ * @param[in] keySize enumerated size of every key
+ * @param[in] key `n` * `keySize` bytes of consecutive keys (any alignment)
+ * @param[in] n number of keys
+ *
+ * */
+void MODA_AES_InitMany(struct aes_ctxt *aes, enum aes_key_size keySize, const uint8_t *key, size_t n);
+
 /**
  * Encrypt a block of memory called state
  *
@@ -80,5 +143,120 @@ void MODA_AES_Encrypt(const struct aes_ctxt *aes, uint8_t *s);
  * */
 void MODA_AES_Decrypt(const struct aes_ctxt *aes, uint8_t *s);
 
+/**
+ * Encrypt consecutive blocks (ECB)
+ *
+ * Independent blocks are pipelined by engines that can (AES-NI, SSSE3,
+ * bitsliced).
+ *
+ * @note `out` may equal `in` but the buffers must not otherwise overlap
+ *
+ * @param[in] aes expanded key
+ * @param[out] out `nblocks` * #AES_BLOCK_SIZE bytes (any alignment)
+ * @param[in] in `nblocks` * #AES_BLOCK_SIZE bytes (any alignment)
+ * @param[in] nblocks number of blocks
+ *
+ * */
+void MODA_AES_EncryptBlocks(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in, size_t nblocks);
+
+/**
+ * Decrypt consecutive blocks (ECB)
+ *
+ * @note `out` may equal `in` but the buffers must not otherwise overlap
+ *
+ * @param[in] aes expanded key
+ * @param[out] out `nblocks` * #AES_BLOCK_SIZE bytes (any alignment)
+ * @param[in] in `nblocks` * #AES_BLOCK_SIZE bytes (any alignment)
+ * @param[in] nblocks number of blocks
+ *
+ * */
+void MODA_AES_DecryptBlocks(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in, size_t nblocks);
+
+/**
+ * Encrypt one block under each of several keys (key agile ECB)
+ *
+ * Block `i` of `in` is encrypted under `aes[i]` into block `i` of `out`.
+ * Engines that can (AES-NI, SSSE3, bitsliced) gather the round keys of
+ * neighbouring entries with the same key size and run those blocks
+ * together.
+ *
+ * @note `out` may equal `in` but the buffers must not otherwise overlap
+ *
+ * @param[in] aes `n` pointers to expanded keys (may repeat, sizes may differ)
+ * @param[out] out `n` * #AES_BLOCK_SIZE bytes (any alignment)
+ * @param[in] in `n` * #AES_BLOCK_SIZE bytes (any alignment)
+ * @param[in] n number of blocks
+ *
+ * */
+void MODA_AES_EncryptMany(const struct aes_ctxt *const *aes, uint8_t *out, const uint8_t *in, size_t n);
+
+#if defined(MODA_AES_UNROLL)
+
+/**
+ * @defgroup moda_aes_unroll Fixed Key Size Variants
+ *
+ * Fully unrolled byte or T-table code for one key size, available with
+ * `-DMODA_AES_UNROLL`
+ *
+ * MODA_AES_Init(), MODA_AES_Encrypt() and MODA_AES_Decrypt() dispatch
+ * to these by key size. Calling them directly also skips that dispatch
+ * along with any run time engine selection (MODA_AES_NI, MODA_AES_VPERM),
+ * so they always run the portable engine.
+ *
+ * The expanded key is interchangeable with one from MODA_AES_Init() of
+ * the same size.
+ *
+ * @{
+ * */
+
+/**
+ * Initialise an AES-128 block cipher
+ *
+ * @param[in] aes expanded key
+ * @param[in] key pointer to #AES_KEY_128 bytes of key (any alignment)
+ *
+ * */
+void MODA_AES128_Init(struct aes_ctxt *aes, const uint8_t *key);
+
+/**
+ * Encrypt a block of memory called state with AES-128
+ *
+ * @param[in] aes expanded AES-128 key
+ * @param[in] s pointer to #AES_BLOCK_SIZE bytes of state (any alignment)
+ *
+ * */
+void MODA_AES128_Encrypt(const struct aes_ctxt *aes, uint8_t *s);
+
+/**
+ * Decrypt a block of memory called state with AES-128
+ *
+ * @param[in] aes expanded AES-128 key
+ * @param[in] s pointer to #AES_BLOCK_SIZE bytes of state (any alignment)
+ *
+ * */
+void MODA_AES128_Decrypt(const struct aes_ctxt *aes, uint8_t *s);
+
+/** @see MODA_AES128_Init() */
+void MODA_AES192_Init(struct aes_ctxt *aes, const uint8_t *key);
+
+/** @see MODA_AES128_Encrypt() */
+void MODA_AES192_Encrypt(const struct aes_ctxt *aes, uint8_t *s);
+
+/** @see MODA_AES128_Decrypt() */
+void MODA_AES192_Decrypt(const struct aes_ctxt *aes, uint8_t *s);
+
+/** @see MODA_AES128_Init() */
+void MODA_AES256_Init(struct aes_ctxt *aes, const uint8_t *key);
+
+/** @see MODA_AES128_Encrypt() */
+void MODA_AES256_Encrypt(const struct aes_ctxt *aes, uint8_t *s);
+
+/** @see MODA_AES128_Decrypt() */
+void MODA_AES256_Decrypt(const struct aes_ctxt *aes, uint8_t *s);
+
+/** @} */
+
+#endif
+
 /** @} */
 #endif
@@ -0,0 +1,162 @@
+/* Copyright (c) 2013-2016 Cameron Harper
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * */
+#ifndef AES_CACHE_H
+#define AES_CACHE_H
+
+/**
+ * @defgroup moda_aes_cache Expanded Key Cache
+ * @ingroup moda
+ *
+ * Bounded cache of expanded keys shared by many threads
+ *
+ * Each entry is a whole GCM key (expanded key, hash subkey and, on hosts
+ * with PCLMULQDQ, its powers), so a hit with MODA_AES_CacheGetGCM() skips
+ * both the key expansion and the encryption of H.
+ *
+ * The cache lives in memory supplied by the caller and holds as many
+ * entries as fit. It is split into #MODA_AES_CACHE_SHARDS shards, each
+ * with its own lock, hash chains and least recently used list, so
+ * threads working on different keys rarely meet. Entries are copied out
+ * on lookup, so eviction never pulls state from under a reader, and are
+ * zeroised when evicted or removed.
+ *
+ * @{
+ * */
+
+#include "aes.h"
+#include "aes_gcm.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/** largest key identifier in bytes (a key may be its own identifier) */
+#define AES_CACHE_ID_SIZE 32U
+
+/** number of independently locked shards */
+#ifndef MODA_AES_CACHE_SHARDS
+    #define MODA_AES_CACHE_SHARDS 16U
+#endif
+
+/** One cached key */
+struct aes_cache_entry {
+
+    struct aes_gcm_ctxt gcm;        /**< expanded key and GCM hash subkey (table-less) */
+    uint8_t id[AES_CACHE_ID_SIZE];  /**< key identifier */
+    uint8_t idSize;                 /**< byte size of `id` (0 if unused) */
+    uint32_t hash;                  /**< hash of `id` */
+    uint32_t chain;                 /**< next entry in the same bucket (or unused entry) */
+    uint32_t prev;                  /**< next more recently used entry */
+    uint32_t next;                  /**< next less recently used entry */
+};
+
+/** One independently locked part of the cache */
+struct aes_cache_shard {
+
+    MODA_ALIGN(64) uint8_t lock;    /**< spinlock (own cache line) */
+    struct aes_cache_entry *entry;  /**< `size` entries */
+    uint32_t *bucket;               /**< `size` hash chain heads */
+    uint32_t size;                  /**< capacity */
+    uint32_t free;                  /**< first unused entry */
+    uint32_t head;                  /**< most recently used entry */
+    uint32_t tail;                  /**< least recently used entry */
+};
+
+/** Cache state */
+struct aes_cache {
+
+    struct aes_cache_shard shard[MODA_AES_CACHE_SHARDS];    /**< shards */
+};
+
+/**
+ * Initialise a cache in caller supplied memory
+ *
+ * @note `mem` must be #MODA_AES_ALIGN aligned and must outlive the cache
+ *
+ * @param[out] cache
+ * @param[in] mem memory for entries
+ * @param[in] memSize byte size of `mem`
+ *
+ * @return number of keys the cache can hold
+ *
+ * */
+size_t MODA_AES_CacheInit(struct aes_cache *cache, void *mem, size_t memSize);
+
+/**
+ * Fetch the expanded key for an identifier, expanding and caching it on a miss
+ *
+ * The identifier must name exactly one key: remove it with
+ * MODA_AES_CacheRemove() before reusing it for another key. If `id` is
+ * NULL the key itself is the identifier.
+ *
+ * @param[in] cache
+ * @param[in] id key identifier (NULL to use `key`)
+ * @param[in] idSize byte size of `id` (1..#AES_CACHE_ID_SIZE)
+ * @param[in] keySize enumerated size of `key`
+ * @param[in] key pointer to the key (any alignment)
+ * @param[out] aes expanded key
+ *
+ * @return true if the key was found in the cache
+ *
+ * */
+bool MODA_AES_CacheGet(struct aes_cache *cache, const uint8_t *id, uint8_t idSize, enum aes_key_size keySize, const uint8_t *key, struct aes_ctxt *aes);
+
+/**
+ * Fetch the GCM key for an identifier, initialising and caching it on a miss
+ *
+ * Same as MODA_AES_CacheGet() but copies out a table-less GCM key ready
+ * for MODA_AES_GCM_Seal() and the rest of the GCM API. Add a GHASH table
+ * to the copy with MODA_AES_GCM_InitTable() if wanted.
+ *
+ * @param[in] cache
+ * @param[in] id key identifier (NULL to use `key`)
+ * @param[in] idSize byte size of `id` (1..#AES_CACHE_ID_SIZE)
+ * @param[in] keySize enumerated size of `key`
+ * @param[in] key pointer to the key (any alignment)
+ * @param[out] gcm GCM key
+ *
+ * @return true if the key was found in the cache
+ *
+ * */
+bool MODA_AES_CacheGetGCM(struct aes_cache *cache, const uint8_t *id, uint8_t idSize, enum aes_key_size keySize, const uint8_t *key, struct aes_gcm_ctxt *gcm);
+
+/**
+ * Zeroise and drop the entry for an identifier
+ *
+ * @param[in] cache
+ * @param[in] id key identifier
+ * @param[in] idSize byte size of `id`
+ *
+ * @return true if an entry was removed
+ *
+ * */
+bool MODA_AES_CacheRemove(struct aes_cache *cache, const uint8_t *id, uint8_t idSize);
+
+/**
+ * Zeroise and drop every entry
+ *
+ * @param[in] cache
+ *
+ * */
+void MODA_AES_CacheClear(struct aes_cache *cache);
+
+/** @} */
+#endif
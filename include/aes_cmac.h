@@ -31,10 +31,21 @@
  * */
 
 #include <stdint.h>
+#include <stddef.h>
 
 /** forward declaration */
 struct aes_ctxt;
 
+/** One message of MODA_AES_CMAC_Many() */
+struct aes_cmac_msg {
+
+    const struct aes_ctxt *aes;     /**< block cipher expanded key */
+    const uint8_t *in;              /**< input buffer to CMAC */
+    uint32_t inLen;                 /**< byte length of `in` */
+    uint8_t *t;                     /**< authentication tag output buffer */
+    uint8_t tSize;                  /**< byte length of `t` in range (0..16) */
+};
+
 /**
  * Produce a CMAC in one step starting with an initialised block cipher
  *
@@ -47,5 +58,21 @@ struct aes_ctxt;
  * */
 void MODA_AES_CMAC(const struct aes_ctxt *aes, const uint8_t *in, uint32_t inLen, uint8_t *t, uint8_t tSize);
 
+/**
+ * Produce the CMACs of several independent messages
+ *
+ * Same as MODA_AES_CMAC() for each message. CMAC chains the blocks of
+ * one message, so engines that pipeline independent blocks (AES-NI,
+ * SSSE3, bitsliced) sit mostly idle on a single message. Here up to 8
+ * messages advance in lockstep, one block each per call to
+ * MODA_AES_EncryptMany(), or MODA_AES_EncryptBlocks() when they all share
+ * one key. Keys may differ or repeat.
+ *
+ * @param[in] msg `n` messages
+ * @param[in] n number of messages
+ *
+ * */
+void MODA_AES_CMAC_Many(const struct aes_cmac_msg *msg, size_t n);
+
 /** @} */
 #endif
@@ -30,11 +30,408 @@
 #ifndef AES_GCM_H
 #define AES_GCM_H
 
+#include "aes.h"
+
 #include <stdint.h>
+#include <stddef.h>
 #include <stdbool.h>
 
-/** forward declaration */
-struct aes_ctxt;
+/** GHASH table sizes accepted by MODA_AES_GCM_InitTable()
+ *
+ * @{
+ * */
+#define AES_GCM_TABLE_4BIT  256U    /**< 4bit Shoup (16 multiples of H), 32 lookups per block */
+#define AES_GCM_TABLE_8BIT  4096U   /**< 8bit Shoup (256 multiples of H), 16 lookups per block */
+#define AES_GCM_TABLE_64K   65536U  /**< 8bit table per byte position, 16 lookups and no reduction per block */
+/** @} */
+
+#if defined(MODA_GCM_PCLMUL)
+/** number of powers of H kept for PCLMULQDQ GHASH (blocks per reduction) */
+#define MODA_GCM_PCLMUL_POWERS 8U
+#endif
+
+/** GCM key: expanded block cipher key and hash subkey
+ *
+ * Initialise once with MODA_AES_GCM_Init() and reuse for any number of
+ * messages with MODA_AES_GCM_Seal() and MODA_AES_GCM_Open().
+ *
+ * */
+struct aes_gcm_ctxt {
+
+    struct aes_ctxt aes;                    /**< block cipher expanded key */
+    MODA_ALIGN(8) uint8_t h[AES_BLOCK_SIZE];    /**< hash subkey (in the word order used by GHASH) */
+    const void *table;                      /**< GHASH table (NULL for table-less GHASH) */
+    size_t tableSize;                       /**< byte size of `table` */
+#if defined(MODA_GCM_PCLMUL)
+    uint8_t hpow[MODA_GCM_PCLMUL_POWERS * AES_BLOCK_SIZE];  /**< H^1..H^8 for PCLMULQDQ (valid if the host has it) */
+#endif
+};
+
+/**
+ * Initialise a GCM key
+ *
+ * @param[out] gcm
+ * @param[in] keySize enumerated size of `key`
+ * @param[in] key pointer to the key (any alignment)
+ *
+ * */
+void MODA_AES_GCM_Init(struct aes_gcm_ctxt *gcm, enum aes_key_size keySize, const uint8_t *key);
+
+/** Incremental GCM state
+ *
+ * Begin with MODA_AES_GCM_StreamInit(), pass all AAD to
+ * MODA_AES_GCM_StreamAAD() and then all text to
+ * MODA_AES_GCM_StreamUpdate(), in pieces of any size, and finish with
+ * MODA_AES_GCM_StreamFinal() or MODA_AES_GCM_StreamCheck().
+ *
+ * Tags are the same as from the single pass interface for the same
+ * concatenated AAD and text.
+ *
+ * */
+struct aes_gcm_stream {
+
+    const struct aes_gcm_ctxt *gcm;                 /**< GCM key */
+    MODA_ALIGN(8) uint8_t x[AES_BLOCK_SIZE];        /**< GHASH state */
+    MODA_ALIGN(8) uint8_t counter[AES_BLOCK_SIZE];  /**< last counter block used */
+    MODA_ALIGN(8) uint8_t ek0[AES_BLOCK_SIZE];      /**< encrypted initial counter block */
+    MODA_ALIGN(8) uint8_t ks[AES_BLOCK_SIZE];       /**< key stream of a partial text block */
+    MODA_ALIGN(8) uint8_t part[AES_BLOCK_SIZE];     /**< partial AAD or cipher text block */
+    uint64_t aadSize;                               /**< bytes of AAD so far */
+    uint64_t textSize;                              /**< bytes of text so far */
+    bool encrypt;                                   /**< encrypt or decrypt */
+};
+
+/** Parallel GCM state
+ *
+ * Begin with MODA_AES_GCM_ParallelInit(), which takes the AAD and cuts
+ * the text into shares of whole blocks. Each share has its own counter
+ * range, so MODA_AES_GCM_ParallelShare() may be called for every share
+ * from any thread, in any order. Finish with MODA_AES_GCM_ParallelFinal()
+ * or MODA_AES_GCM_ParallelCheck() once all shares are done. These merge
+ * the partial GHASH of each share by multiplying with powers of H.
+ *
+ * Tags are the same as from the single pass interface.
+ *
+ * ~~~ c
+ * n = MODA_AES_GCM_ParallelInit(&p, &gcm, iv, sizeof(iv), aad, sizeof(aad), size, threads, true);
+ *
+ * // on a pool of threads
+ * for(i=0; i < n; i++){ MODA_AES_GCM_ParallelShare(&p, i, out, in, &share[i]); }
+ *
+ * // after joining
+ * MODA_AES_GCM_ParallelFinal(&p, share, tag, sizeof(tag));
+ * ~~~
+ *
+ * */
+struct aes_gcm_parallel {
+
+    const struct aes_gcm_ctxt *gcm;                 /**< GCM key */
+    MODA_ALIGN(8) uint8_t x[AES_BLOCK_SIZE];        /**< GHASH of the AAD */
+    MODA_ALIGN(8) uint8_t counter[AES_BLOCK_SIZE];  /**< initial counter block */
+    MODA_ALIGN(8) uint8_t ek0[AES_BLOCK_SIZE];      /**< encrypted initial counter block */
+    uint64_t aadSize;                               /**< bytes of AAD */
+    size_t textSize;                                /**< bytes of text */
+    size_t shareSize;                               /**< bytes per share (whole blocks, the last share may be shorter) */
+    size_t shares;                                  /**< number of shares */
+    bool encrypt;                                   /**< encrypt or decrypt */
+};
+
+/** One message of a burst
+ *
+ * @see MODA_AES_GCM_SealBurst() and MODA_AES_GCM_OpenBurst()
+ *
+ * */
+struct aes_gcm_packet {
+
+    const uint8_t *iv;      /**< initialisation vector */
+    uint32_t ivSize;        /**< byte size of `iv` */
+    const uint8_t *aad;     /**< additional data */
+    uint32_t aadSize;       /**< byte size of `aad` */
+    const uint8_t *in;      /**< input buffer */
+    uint8_t *out;           /**< output buffer (may equal `in`) */
+    uint32_t textSize;      /**< byte size of `in` and `out` */
+    uint8_t *t;             /**< authentication tag (output when sealing, input when opening) */
+    uint8_t tSize;          /**< byte size of `t` (0..16) */
+    bool valid;             /**< set by MODA_AES_GCM_OpenBurst() if the tag is valid */
+};
+
+/** Partial GHASH of one share of a parallel operation
+ *
+ * Aligned to a cache line so that neighbouring shares written by
+ * different threads do not share one.
+ *
+ * */
+struct aes_gcm_share {
+
+    MODA_ALIGN(64) uint8_t x[AES_BLOCK_SIZE];       /**< GHASH of the share's cipher text */
+};
+
+/**
+ * Attach a precomputed GHASH table to an initialised GCM key
+ *
+ * The table is built from the hash subkey and trades memory for GHASH
+ * speed. Lookups are indexed by secret dependent data, so the table is
+ * not suitable where cache timing can be observed.
+ *
+ * With MODA_GCM_PCLMUL the table is not used on hosts that have
+ * PCLMULQDQ.
+ *
+ * @note `table` must be 8 byte aligned and must outlive `gcm`
+ *
+ * @param[in] gcm initialised GCM key
+ * @param[out] table memory for the table
+ * @param[in] tableSize #AES_GCM_TABLE_4BIT, #AES_GCM_TABLE_8BIT or #AES_GCM_TABLE_64K
+ *
+ * */
+void MODA_AES_GCM_InitTable(struct aes_gcm_ctxt *gcm, void *table, size_t tableSize);
+
+/**
+ * AES GCM Encrypt with a GCM key
+ *
+ * Same as MODA_AES_GCM_Encrypt() without deriving the hash subkey.
+ *
+ * @param gcm GCM key
+ *
+ * @param iv initialisation vector
+ * @param ivSize byte size of `iv`
+ *
+ * @param out output buffer
+ * @param in input buffer
+ * @param textSize byte size of `in`
+ *
+ * @param aad additional data authenticated but not encrypted/decrypted
+ * @param aadSize byte size of `aad`
+ *
+ * @param t authentication tag output buffer
+ * @param tSize byte size of `t`
+ *
+ * */
+void MODA_AES_GCM_Seal(const struct aes_gcm_ctxt *gcm, const uint8_t *iv, uint32_t ivSize, uint8_t *out, const uint8_t *in, uint32_t textSize, const uint8_t *aad, uint32_t aadSize, uint8_t *t, uint8_t tSize);
+
+/**
+ * AES GCM Decrypt with a GCM key
+ *
+ * Same as MODA_AES_GCM_Decrypt() without deriving the hash subkey.
+ *
+ * @param gcm GCM key
+ *
+ * @param iv initialisation vector
+ * @param ivSize byte size of `iv`
+ *
+ * @param out output buffer
+ * @param in input buffer
+ * @param textSize byte size of `in`
+ *
+ * @param aad additional data authenticated but not encrypted/decrypted
+ * @param aadSize byte size of `aad`
+ *
+ * @param t authentication tag input buffer
+ * @param tSize byte size of `t`
+ *
+ * @return true if input is valid
+ *
+ * */
+bool MODA_AES_GCM_Open(const struct aes_gcm_ctxt *gcm, const uint8_t *iv, uint32_t ivSize, uint8_t *out, const uint8_t *in, uint32_t textSize, const uint8_t *aad, uint32_t aadSize, const uint8_t *t, uint8_t tSize);
+
+/**
+ * AES GCM Decrypt with a GCM key, verifying the tag first
+ *
+ * Same result as MODA_AES_GCM_Open(), but the tag is computed from the
+ * cipher text before anything is decrypted. A forgery costs one block
+ * encryption and GHASH, and `out` is not written unless the tag is
+ * valid. A valid message costs a second pass over the text.
+ *
+ * Rejections are counted, see MODA_AES_GCM_Rejected().
+ *
+ * @param gcm GCM key
+ *
+ * @param iv initialisation vector
+ * @param ivSize byte size of `iv`
+ *
+ * @param out output buffer (untouched if the tag is not valid)
+ * @param in input buffer
+ * @param textSize byte size of `in`
+ *
+ * @param aad additional data authenticated but not encrypted/decrypted
+ * @param aadSize byte size of `aad`
+ *
+ * @param t authentication tag input buffer
+ * @param tSize byte size of `t` (0..16)
+ *
+ * @return true if input is valid
+ *
+ * */
+bool MODA_AES_GCM_OpenVerified(const struct aes_gcm_ctxt *gcm, const uint8_t *iv, uint32_t ivSize, uint8_t *out, const uint8_t *in, uint32_t textSize, const uint8_t *aad, uint32_t aadSize, const uint8_t *t, uint8_t tSize);
+
+/**
+ * Number of tags rejected by MODA_AES_GCM_OpenVerified() since start up
+ *
+ * Shared by all GCM keys and threads, wraps at 2^32.
+ *
+ * @return rejections
+ *
+ * */
+uint32_t MODA_AES_GCM_Rejected(void);
+
+/**
+ * Start an incremental encryption or decryption
+ *
+ * @param[out] s stream
+ * @param[in] gcm GCM key (must outlive `s`)
+ * @param[in] iv initialisation vector
+ * @param[in] ivSize byte size of `iv`
+ * @param[in] encrypt true to encrypt, false to decrypt
+ *
+ * */
+void MODA_AES_GCM_StreamInit(struct aes_gcm_stream *s, const struct aes_gcm_ctxt *gcm, const uint8_t *iv, uint32_t ivSize, bool encrypt);
+
+/**
+ * Authenticate the next piece of additional data
+ *
+ * @note all AAD must be passed before the first text
+ *
+ * @param[in] s stream
+ * @param[in] aad additional data
+ * @param[in] aadSize byte size of `aad` (may be zero)
+ *
+ * */
+void MODA_AES_GCM_StreamAAD(struct aes_gcm_stream *s, const uint8_t *aad, size_t aadSize);
+
+/**
+ * Encrypt or decrypt the next piece of text
+ *
+ * @note if `in` == `out` then the operation is performed in place
+ * @note text is limited to 2^36 - 32 bytes in total
+ *
+ * @param[in] s stream
+ * @param[out] out output buffer
+ * @param[in] in input buffer
+ * @param[in] textSize byte size of `in` (may be zero)
+ *
+ * */
+void MODA_AES_GCM_StreamUpdate(struct aes_gcm_stream *s, uint8_t *out, const uint8_t *in, size_t textSize);
+
+/**
+ * Finish a stream and output the authentication tag
+ *
+ * @param[in] s stream
+ * @param[out] t authentication tag output buffer
+ * @param[in] tSize byte size of `t` (0..16)
+ *
+ * */
+void MODA_AES_GCM_StreamFinal(struct aes_gcm_stream *s, uint8_t *t, uint8_t tSize);
+
+/**
+ * Finish a stream and compare the authentication tag
+ *
+ * @note text output by a decrypting stream must not be used unless
+ * this returns true
+ *
+ * @param[in] s stream
+ * @param[in] t authentication tag input buffer
+ * @param[in] tSize byte size of `t` (0..16)
+ *
+ * @return true if input is valid
+ *
+ * */
+bool MODA_AES_GCM_StreamCheck(struct aes_gcm_stream *s, const uint8_t *t, uint8_t tSize);
+
+/**
+ * Seal a burst of messages under one GCM key
+ *
+ * Same as MODA_AES_GCM_Seal() for each packet, except that the counter
+ * blocks of neighbouring packets (initial counters included) are
+ * gathered into #MODA_GCM_BATCH block calls to
+ * MODA_AES_EncryptBlocks() so that many short messages keep a
+ * pipelined engine as busy as one long message does.
+ *
+ * @param[in] gcm GCM key
+ * @param[in] pkt `n` packets
+ * @param[in] n number of packets
+ *
+ * */
+void MODA_AES_GCM_SealBurst(const struct aes_gcm_ctxt *gcm, struct aes_gcm_packet *pkt, size_t n);
+
+/**
+ * Open a burst of messages under one GCM key
+ *
+ * Same as MODA_AES_GCM_Open() for each packet, with the counter blocks
+ * of neighbouring packets encrypted together as in
+ * MODA_AES_GCM_SealBurst(). The result for each packet is written to
+ * its `valid` member.
+ *
+ * @note text output for a packet must not be used unless it is valid
+ *
+ * @param[in] gcm GCM key
+ * @param[in] pkt `n` packets
+ * @param[in] n number of packets
+ *
+ * @return number of valid packets
+ *
+ * */
+size_t MODA_AES_GCM_OpenBurst(const struct aes_gcm_ctxt *gcm, struct aes_gcm_packet *pkt, size_t n);
+
+/**
+ * Start a parallel encryption or decryption
+ *
+ * @note text is limited to 2^36 - 32 bytes
+ *
+ * @param[out] p parallel state
+ * @param[in] gcm GCM key (must outlive `p`)
+ * @param[in] iv initialisation vector
+ * @param[in] ivSize byte size of `iv`
+ * @param[in] aad additional data
+ * @param[in] aadSize byte size of `aad`
+ * @param[in] textSize byte size of the text
+ * @param[in] shares maximum number of shares (e.g. number of threads, at least 1)
+ * @param[in] encrypt true to encrypt, false to decrypt
+ *
+ * @return number of shares the text was cut into (0 if there is no text)
+ *
+ * */
+size_t MODA_AES_GCM_ParallelInit(struct aes_gcm_parallel *p, const struct aes_gcm_ctxt *gcm, const uint8_t *iv, uint32_t ivSize, const uint8_t *aad, size_t aadSize, size_t textSize, size_t shares, bool encrypt);
+
+/**
+ * Encrypt or decrypt one share of the text
+ *
+ * Safe to call concurrently for different shares of the same `p`.
+ *
+ * @note if `in` == `out` then the operation is performed in place
+ *
+ * @param[in] p parallel state
+ * @param[in] i share index (less than the number returned by MODA_AES_GCM_ParallelInit())
+ * @param[out] out output buffer for the whole text
+ * @param[in] in input buffer for the whole text
+ * @param[out] share partial GHASH of share `i`
+ *
+ * */
+void MODA_AES_GCM_ParallelShare(const struct aes_gcm_parallel *p, size_t i, uint8_t *out, const uint8_t *in, struct aes_gcm_share *share);
+
+/**
+ * Combine the shares of a parallel operation and output the authentication tag
+ *
+ * @param[in] p parallel state
+ * @param[in] share partial GHASH of every share, in share order
+ * @param[out] t authentication tag output buffer
+ * @param[in] tSize byte size of `t` (0..16)
+ *
+ * */
+void MODA_AES_GCM_ParallelFinal(const struct aes_gcm_parallel *p, const struct aes_gcm_share *share, uint8_t *t, uint8_t tSize);
+
+/**
+ * Combine the shares of a parallel operation and compare the authentication tag
+ *
+ * @note decrypted text must not be used unless this returns true
+ *
+ * @param[in] p parallel state
+ * @param[in] share partial GHASH of every share, in share order
+ * @param[in] t authentication tag input buffer
+ * @param[in] tSize byte size of `t` (0..16)
+ *
+ * @return true if input is valid
+ *
+ * */
+bool MODA_AES_GCM_ParallelCheck(const struct aes_gcm_parallel *p, const struct aes_gcm_share *share, const uint8_t *t, uint8_t tSize);
 
 /**
  * AES GCM Encrypt
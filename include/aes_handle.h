@@ -0,0 +1,140 @@
+/* Copyright (c) 2013-2016 Cameron Harper
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * */
+#ifndef AES_HANDLE_H
+#define AES_HANDLE_H
+
+/**
+ * @defgroup moda_aes_handle Rotating Key Handle
+ * @ingroup moda
+ *
+ * Expanded key shared by many threads that can be replaced while in use
+ *
+ * A handle keeps the last #MODA_AES_HANDLE_VERSIONS expanded keys, each
+ * numbered by an epoch. Readers enter the handle to borrow a key and exit
+ * when done; entering costs a load, a store and a fence, with no atomic
+ * read-modify-write and no lock. A single writer publishes a new key with
+ * MODA_AES_HandleRotate(), which reuses (and zeroises) the slot of the
+ * oldest epoch once no reader still holds it.
+ *
+ * Older epochs stay available through MODA_AES_HandleEnterEpoch() until
+ * their slot is reused, so data protected under the previous key can
+ * still be opened during a rotation.
+ *
+ * Each reader thread owns one struct aes_handle_reader.
+ *
+ * @note requires the GCC/Clang __atomic builtins
+ *
+ * @{
+ * */
+
+#include "aes.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/** number of expanded keys kept (the current one and those before it) */
+#ifndef MODA_AES_HANDLE_VERSIONS
+    #define MODA_AES_HANDLE_VERSIONS 2U
+#endif
+
+/** Per thread reader state */
+struct aes_handle_reader {
+
+    MODA_ALIGN(64) uint32_t epoch;  /**< epoch held (0 when outside the handle) */
+};
+
+/** Rotating key handle */
+struct aes_handle {
+
+    struct aes_ctxt aes[MODA_AES_HANDLE_VERSIONS];  /**< expanded key of epoch `e` is at `e` % #MODA_AES_HANDLE_VERSIONS */
+    MODA_ALIGN(64) uint32_t current;                /**< newest epoch */
+    uint32_t oldest;                                /**< oldest epoch that may be entered */
+    struct aes_handle_reader *reader;               /**< reader states */
+    size_t readers;                                 /**< number of reader states */
+};
+
+/**
+ * Initialise a handle with its first key (epoch 1)
+ *
+ * @param[out] handle
+ * @param[in] reader one state per reader thread (must outlive `handle`)
+ * @param[in] readers number of reader states
+ * @param[in] keySize enumerated size of `key`
+ * @param[in] key pointer to the key (any alignment)
+ *
+ * */
+void MODA_AES_HandleInit(struct aes_handle *handle, struct aes_handle_reader *reader, size_t readers, enum aes_key_size keySize, const uint8_t *key);
+
+/**
+ * Borrow the newest key
+ *
+ * The key stays valid until MODA_AES_HandleExit(). A reader holds at most
+ * one epoch at a time.
+ *
+ * @param[in] handle
+ * @param[in] reader this thread's state
+ * @param[out] epoch epoch of the returned key (may be NULL)
+ *
+ * @return expanded key
+ *
+ * */
+const struct aes_ctxt *MODA_AES_HandleEnter(struct aes_handle *handle, struct aes_handle_reader *reader, uint32_t *epoch);
+
+/**
+ * Borrow the key of a given epoch
+ *
+ * @param[in] handle
+ * @param[in] reader this thread's state
+ * @param[in] epoch
+ *
+ * @return expanded key, or NULL (reader not entered) if `epoch` is not held
+ *
+ * */
+const struct aes_ctxt *MODA_AES_HandleEnterEpoch(struct aes_handle *handle, struct aes_handle_reader *reader, uint32_t epoch);
+
+/**
+ * Return a borrowed key
+ *
+ * @param[in] handle
+ * @param[in] reader this thread's state
+ *
+ * */
+void MODA_AES_HandleExit(struct aes_handle *handle, struct aes_handle_reader *reader);
+
+/**
+ * Publish a new key as the next epoch
+ *
+ * Never waits: if a reader still holds the epoch whose slot is needed,
+ * that epoch is retired (no new readers) and false is returned so the
+ * caller can try again later. Calls must not overlap.
+ *
+ * @param[in] handle
+ * @param[in] keySize enumerated size of `key`
+ * @param[in] key pointer to the key (any alignment)
+ *
+ * @return true if published
+ *
+ * */
+bool MODA_AES_HandleRotate(struct aes_handle *handle, enum aes_key_size keySize, const uint8_t *key);
+
+/** @} */
+#endif
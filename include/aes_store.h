@@ -0,0 +1,189 @@
+/* Copyright (c) 2013-2016 Cameron Harper
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * */
+#ifndef AES_STORE_H
+#define AES_STORE_H
+
+/**
+ * @defgroup moda_aes_store Expanded Key Store
+ * @ingroup moda
+ *
+ * Image of pre-expanded keys that can be mapped and used in place
+ *
+ * An image is built once (MODA_AES_StoreFormat(), MODA_AES_StorePut(),
+ * MODA_AES_StoreSeal()) and written to disk. A process later maps it,
+ * opens it with MODA_AES_StoreOpen(), which reads only the header, and
+ * fetches entries with MODA_AES_StoreGet(), which returns pointers into
+ * the image. Nothing is parsed or copied: each entry is a table-less GCM
+ * key that MODA_AES_GCM_Seal() and the rest of the GCM API use in place,
+ * and its `aes` member serves every other mode.
+ *
+ * Entries are grouped into pages that are each authenticated with
+ * AES-CMAC. A page is checked the first time one of its entries is
+ * fetched, so only the pages in use are ever read.
+ *
+ * Image layout (native byte order and struct layout):
+ *
+ * | offset                          | content                      |
+ * |---------------------------------|------------------------------|
+ * | 0                               | struct aes_store_header      |
+ * | sizeof(struct aes_store_header) | one tag per page             |
+ * | `entryOffset` (#AES_STORE_ALIGN)| struct aes_store_entry array |
+ *
+ * The header records the byte order, entry size and the options that
+ * change an entry (struct aes_ctxt layout, GHASH word order and whether
+ * the PCLMULQDQ powers of H are filled in), so an image is only opened
+ * by a build and host that lay keys out the same way.
+ *
+ * @warning the image holds expanded keys in the clear and must be
+ * protected like any other key file
+ *
+ * @{
+ * */
+
+#include "aes.h"
+#include "aes_gcm.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/** entries start on a boundary of this many bytes */
+#define AES_STORE_ALIGN 4096U
+
+/** byte size of each page tag */
+#define AES_STORE_TAG_SIZE 16U
+
+/** One stored key */
+struct aes_store_entry {
+
+    struct aes_gcm_ctxt gcm;        /**< expanded key and GCM hash subkey (table-less) */
+};
+
+/** Image header */
+struct aes_store_header {
+
+    uint8_t magic[8U];              /**< "MODAKEYS" */
+    uint32_t order;                 /**< 0x01020304 in native byte order */
+    uint32_t options;               /**< options that change an entry */
+    uint32_t entrySize;             /**< sizeof(struct aes_store_entry) */
+    uint32_t count;                 /**< number of entries */
+    uint32_t perPage;               /**< entries per authenticated page */
+    uint32_t pages;                 /**< number of pages */
+    uint32_t entryOffset;           /**< byte offset of the first entry */
+    uint32_t reserved;              /**< zero */
+    uint8_t tag[AES_STORE_TAG_SIZE];    /**< CMAC of the preceding fields */
+};
+
+/** An opened image */
+struct aes_store {
+
+    const uint8_t *image;           /**< mapped image */
+    const struct aes_ctxt *mac;     /**< CMAC key */
+    uint8_t *verified;              /**< one flag per page */
+    uint32_t count;                 /**< number of entries */
+    uint32_t perPage;               /**< entries per page */
+    uint32_t pages;                 /**< number of pages */
+    uint32_t entryOffset;           /**< byte offset of the first entry */
+};
+
+/**
+ * Bytes needed for an image
+ *
+ * @param[in] count number of entries
+ * @param[in] perPage entries per authenticated page (15 fills a 4KB page with 16 byte alignment)
+ *
+ * @return image size in bytes
+ *
+ * */
+size_t MODA_AES_StoreSize(uint32_t count, uint32_t perPage);
+
+/**
+ * Lay out an empty image
+ *
+ * @note `image` must be #MODA_AES_ALIGN aligned
+ *
+ * @param[out] image
+ * @param[in] imageSize byte size of `image`
+ * @param[in] count number of entries
+ * @param[in] perPage entries per authenticated page
+ *
+ * @return false if `imageSize` is less than MODA_AES_StoreSize()
+ *
+ * */
+bool MODA_AES_StoreFormat(void *image, size_t imageSize, uint32_t count, uint32_t perPage);
+
+/**
+ * Expand a key into an entry of a formatted image
+ *
+ * @param[in] image
+ * @param[in] index entry number
+ * @param[in] keySize enumerated size of `key`
+ * @param[in] key pointer to the key (any alignment)
+ *
+ * */
+void MODA_AES_StorePut(void *image, uint32_t index, enum aes_key_size keySize, const uint8_t *key);
+
+/**
+ * Authenticate every page and the header once all entries are put
+ *
+ * @param[in] image
+ * @param[in] mac CMAC key
+ *
+ * */
+void MODA_AES_StoreSeal(void *image, const struct aes_ctxt *mac);
+
+/**
+ * Open an image
+ *
+ * Only the header is read. `verified` is cleared so that every page is
+ * authenticated again, which costs one byte store per page (count /
+ * perPage) rather than constant time.
+ *
+ * @note `image` must be #MODA_AES_ALIGN aligned (mmap() gives page alignment)
+ *
+ * @param[out] store
+ * @param[in] image mapped image
+ * @param[in] imageSize byte size of `image`
+ * @param[in] mac CMAC key (must outlive `store`)
+ * @param[in] verified one byte per page for verification state (must outlive `store`)
+ * @param[in] verifiedSize byte size of `verified`
+ *
+ * @return true if the header is authentic, matches this build and fits
+ *
+ * */
+bool MODA_AES_StoreOpen(struct aes_store *store, const void *image, size_t imageSize, const struct aes_ctxt *mac, uint8_t *verified, size_t verifiedSize);
+
+/**
+ * Fetch an entry, authenticating its page on first use
+ *
+ * Safe to call from many threads at once; two threads may both check a
+ * page the first time round.
+ *
+ * @param[in] store
+ * @param[in] index entry number
+ *
+ * @return entry within the image, or NULL if `index` is out of range or its page is not authentic
+ *
+ * */
+const struct aes_store_entry *MODA_AES_StoreGet(struct aes_store *store, uint32_t index);
+
+/** @} */
+#endif
@@ -32,6 +32,9 @@
 #include "aes_gcm.h"
 #include "aes_cmac.h"
 #include "aes_wrap.h"
+#include "aes_cache.h"
+#include "aes_store.h"
+#include "aes_handle.h"
 
 /** @} */
 #endif
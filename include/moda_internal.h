@@ -21,6 +21,11 @@
 #ifndef MODA_INTERNAL_H
 #define MODA_INTERNAL_H
 
+#include "aes.h"
+
+#include <stddef.h>
+#include <stdbool.h>
+
 #ifdef NDEBUG
     #define ASSERT(X)
 #else
@@ -44,8 +49,589 @@ typedef uint64_t moda_word_t;
     #error "unknown word size"
 #endif
 
+#if (MODA_AES_ALIGN < 8) || ((MODA_AES_ALIGN & (MODA_AES_ALIGN - 1)) != 0)
+    #error "MODA_AES_ALIGN must be a power of two no less than 8"
+#endif
+
 #ifndef MODA_RESTRICT
     #define MODA_RESTRICT __restrict__
 #endif
 
+/* this will place target specific attributes before constant tables (e.g. IAR) */
+#ifndef MODA_CONST_PRE
+    #define MODA_CONST_PRE
+#endif
+
+/* this will place target specific attributes after constant tables (e.g GCC) */
+#ifndef MODA_CONST_POST
+    #define MODA_CONST_POST
+#endif
+
+#if defined(MODA_AES_OTF)
+
+    #if defined(MODA_AES_TABLES) || defined(MODA_AES_BITSLICE) || defined(MODA_AES_UNROLL)
+        #error "MODA_AES_OTF applies to the byte oriented engine only"
+    #endif
+
+    #if defined(MODA_AES_NI) || defined(MODA_AES_VPERM)
+        #error "MODA_AES_OTF cannot be combined with backends that need an expanded key"
+    #endif
+
+#endif
+
+#if defined(MODA_AES_TABLES)
+
+    #if (MODA_AES_TABLES != 1U) && (MODA_AES_TABLES != 4U)
+        #error "MODA_AES_TABLES must be 1 or 4"
+    #endif
+
+/**
+ * Encrypt a block using the 32bit T-table engine
+ *
+ * @note `out` may equal `in`
+ *
+ * @param[in] aes expanded key
+ * @param[out] out output block (any alignment)
+ * @param[in] in input block (any alignment)
+ *
+ * */
+void MODA_AES_TableEncrypt(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in);
+
+#if defined(MODA_AES_UNROLL)
+
+/**
+ * Fully unrolled T-table encrypt for a fixed key size
+ *
+ * @note `out` may equal `in`
+ *
+ * @param[in] aes expanded key
+ * @param[out] out output block (any alignment)
+ * @param[in] in input block (any alignment)
+ *
+ * */
+void MODA_AES_TableEncrypt128(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in);
+void MODA_AES_TableEncrypt192(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in);
+void MODA_AES_TableEncrypt256(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in);
+
+#endif
+
+#endif
+
+#if defined(MODA_AES_DECRYPT_SCHEDULE)
+
+    #if !defined(MODA_AES_TABLES)
+        #error "MODA_AES_DECRYPT_SCHEDULE requires MODA_AES_TABLES"
+    #endif
+
+/**
+ * Derive the equivalent inverse cipher key schedule from the expanded key
+ *
+ * @param[in/out] aes expanded key
+ *
+ * */
+void MODA_AES_TableInitDecrypt(struct aes_ctxt *aes);
+
+/**
+ * Decrypt a block using the 32bit T-table engine and the equivalent inverse cipher
+ *
+ * @note `out` may equal `in`
+ *
+ * @param[in] aes expanded key
+ * @param[out] out output block (any alignment)
+ * @param[in] in input block (any alignment)
+ *
+ * */
+void MODA_AES_TableDecrypt(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in);
+
+#if defined(MODA_AES_UNROLL)
+
+/**
+ * Fully unrolled T-table decrypt for a fixed key size
+ *
+ * @note `out` may equal `in`
+ *
+ * @param[in] aes expanded key
+ * @param[out] out output block (any alignment)
+ * @param[in] in input block (any alignment)
+ *
+ * */
+void MODA_AES_TableDecrypt128(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in);
+void MODA_AES_TableDecrypt192(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in);
+void MODA_AES_TableDecrypt256(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in);
+
+#endif
+
+#endif
+
+#if defined(MODA_AES_BITSLICE)
+
+    #if defined(MODA_AES_TABLES)
+        #error "MODA_AES_BITSLICE and MODA_AES_TABLES are mutually exclusive"
+    #endif
+
+    #if defined(MODA_AES_UNROLL)
+        #error "MODA_AES_UNROLL applies to the byte and T-table engines only"
+    #endif
+
+/**
+ * Expand a key for the bitsliced engine
+ *
+ * The key schedule is computed in constant time. Fills both the
+ * byte oriented schedule and the compressed bitsliced schedule.
+ *
+ * @param[out] aes expanded key
+ * @param[in] keySize enumerated size of `key`
+ * @param[in] key pointer to the key (any alignment)
+ *
+ * */
+void MODA_AES_BitsliceInit(struct aes_ctxt *aes, enum aes_key_size keySize, const uint8_t *key);
+
+/**
+ * Expand several keys of the same size for the bitsliced engine
+ *
+ * Up to sixteen schedules are expanded in lockstep so that SubWord
+ * costs one pass of the S-box circuit for all of them.
+ *
+ * @param[out] aes `n` contexts
+ * @param[in] keySize enumerated size of each key
+ * @param[in] key `n` consecutive keys (any alignment)
+ * @param[in] n number of keys
+ *
+ * */
+void MODA_AES_BitsliceInitMany(struct aes_ctxt *aes, enum aes_key_size keySize, const uint8_t *key, size_t n);
+
+/**
+ * Encrypt a block using the bitsliced engine
+ *
+ * @param[in] aes expanded key
+ * @param[in] s pointer to #AES_BLOCK_SIZE bytes of state (any alignment)
+ *
+ * */
+void MODA_AES_BitsliceEncrypt(const struct aes_ctxt *aes, uint8_t *s);
+
+/**
+ * Decrypt a block using the bitsliced engine
+ *
+ * @param[in] aes expanded key
+ * @param[in] s pointer to #AES_BLOCK_SIZE bytes of state (any alignment)
+ *
+ * */
+void MODA_AES_BitsliceDecrypt(const struct aes_ctxt *aes, uint8_t *s);
+
+/**
+ * Encrypt consecutive blocks using the bitsliced engine, eight at a time
+ *
+ * @note `out` may equal `in`
+ *
+ * @param[in] aes expanded key
+ * @param[out] out output blocks (any alignment)
+ * @param[in] in input blocks (any alignment)
+ * @param[in] n number of blocks
+ *
+ * */
+void MODA_AES_BitsliceEncryptBlocks(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in, size_t n);
+
+/**
+ * Encrypt one block per key using the bitsliced engine, eight at a time
+ *
+ * Round keys of neighbouring keys of the same size are transposed into
+ * bitsliced form together.
+ *
+ * @note `out` may equal `in`
+ *
+ * @param[in] aes `n` expanded keys
+ * @param[out] out output blocks (any alignment)
+ * @param[in] in input blocks (any alignment)
+ * @param[in] n number of blocks
+ *
+ * */
+void MODA_AES_BitsliceEncryptMany(const struct aes_ctxt *const *aes, uint8_t *out, const uint8_t *in, size_t n);
+
+/**
+ * Decrypt consecutive blocks using the bitsliced engine, eight at a time
+ *
+ * @note `out` may equal `in`
+ *
+ * @param[in] aes expanded key
+ * @param[out] out output blocks (any alignment)
+ * @param[in] in input blocks (any alignment)
+ * @param[in] n number of blocks
+ *
+ * */
+void MODA_AES_BitsliceDecryptBlocks(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in, size_t n);
+
+#endif
+
+#if defined(MODA_AES_BITSLICE) || defined(MODA_AES_SBOX_COMPUTED)
+
+/** word of the S-box circuit, one bit from each of several bytes
+ *
+ * The computed S-box engine keeps two blocks per 32bit word (four per
+ * 64bit word) so it needs at least 32 bits. The type of the sliced
+ * schedule in struct aes_ctxt must match.
+ *
+ * */
+#if defined(MODA_AES_BITSLICE) || (MODA_WORD_SIZE == 8U)
+typedef uint64_t moda_slice_t;
+#else
+typedef uint32_t moda_slice_t;
+#endif
+
+/**
+ * SubBytes on eight bitsliced words (Boyar-Peralta circuit)
+ *
+ * Word 0 holds the least significant bit of every byte.
+ *
+ * @param[in/out] q eight words
+ *
+ * */
+void MODA_AES_Sbox(moda_slice_t *q);
+
+/**
+ * InvSubBytes on eight bitsliced words
+ *
+ * @param[in/out] q eight words
+ *
+ * */
+void MODA_AES_InvSbox(moda_slice_t *q);
+
+/**
+ * Transpose eight words between byte order and bitsliced order
+ *
+ * Afterwards word N holds bit N of every byte. This is an involution.
+ *
+ * @param[in/out] q eight words
+ *
+ * */
+void MODA_AES_Ortho(moda_slice_t *q);
+
+#endif
+
+#if defined(MODA_AES_SBOX_COMPUTED)
+
+    #if defined(MODA_AES_TABLES) || defined(MODA_AES_BITSLICE)
+        #error "MODA_AES_SBOX_COMPUTED applies to the byte oriented engine only"
+    #endif
+
+/** blocks held by one sliced state of the computed S-box engine */
+#define MODA_SLICE_BLOCKS (sizeof(moda_slice_t) >> 1U)
+
+/**
+ * SubWord of up to eight key schedule words in one pass of the circuit
+ *
+ * @param[in/out] w words
+ * @param[in] n number of words (1..8)
+ *
+ * */
+void MODA_AES_SubWords(uint32_t *w, size_t n);
+
+/**
+ * Load blocks into a sliced state
+ *
+ * The state is eight words, word N holding bit N of every byte. Each row
+ * of the state takes 4 * #MODA_SLICE_BLOCKS bits, a column of every block
+ * in turn, so that MixColumns moves whole rows by rotating the word.
+ *
+ * @param[out] q eight words of state
+ * @param[in] in `n` * #AES_BLOCK_SIZE bytes (any alignment)
+ * @param[in] n number of blocks (1..#MODA_SLICE_BLOCKS)
+ *
+ * */
+void MODA_AES_SliceIn(moda_slice_t *q, const uint8_t *in, size_t n);
+
+/**
+ * Store blocks from a sliced state
+ *
+ * @param[out] out `n` * #AES_BLOCK_SIZE bytes (any alignment)
+ * @param[in] q eight words of state
+ * @param[in] n number of blocks (1..#MODA_SLICE_BLOCKS)
+ *
+ * */
+void MODA_AES_SliceOut(uint8_t *out, const moda_slice_t *q, size_t n);
+
+/**
+ * Slice a round key into every block of a state
+ *
+ * @param[out] q eight words
+ * @param[in] k #AES_BLOCK_SIZE bytes of round key (any alignment)
+ *
+ * */
+void MODA_AES_SliceKey(moda_slice_t *q, const uint8_t *k);
+
+/**
+ * AddRoundKey on a sliced state
+ *
+ * @param[in/out] q eight words of state
+ * @param[in] k eight words of sliced round key
+ *
+ * */
+void MODA_AES_SlicedAddRoundKey(moda_slice_t *q, const moda_slice_t *k);
+
+/**
+ * AddRoundKey, SubBytes, ShiftRows and (optionally) MixColumns on a
+ * sliced state
+ *
+ * @param[in/out] q eight words of state
+ * @param[in] k eight words of sliced round key
+ * @param[in] mix false for the final round
+ *
+ * */
+void MODA_AES_SlicedRound(moda_slice_t *q, const moda_slice_t *k, bool mix);
+
+/**
+ * (Optionally) InvMixColumns, InvShiftRows, InvSubBytes and AddRoundKey
+ * on a sliced state
+ *
+ * @param[in/out] q eight words of state
+ * @param[in] k eight words of sliced round key
+ * @param[in] mix false for the first round
+ *
+ * */
+void MODA_AES_SlicedInvRound(moda_slice_t *q, const moda_slice_t *k, bool mix);
+
+#endif
+
+#if defined(MODA_AES_NI) || defined(MODA_AES_VPERM) || defined(MODA_GCM_PCLMUL)
+    #define MODA_CPU_PROBE
+#endif
+
+#if defined(MODA_CPU_PROBE)
+
+#define MODA_CPU_AES    0x01U   /**< AESENC and friends */
+#define MODA_CPU_SSSE3  0x02U   /**< PSHUFB and friends */
+#define MODA_CPU_PCLMUL 0x04U   /**< PCLMULQDQ (with SSSE3) */
+
+/**
+ * Probe (once) and return the instruction set extensions of this host
+ *
+ * @return MODA_CPU_* flags
+ *
+ * */
+uint32_t MODA_CPU_Features(void);
+
+#define MODA_CPU_HAS(F) ((MODA_CPU_Features() & (F)) == (F))
+
+#endif
+
+#if defined(MODA_AES_NI)
+
+    #if !defined(__x86_64__) && !defined(__i386__)
+        #error "MODA_AES_NI requires an x86 target"
+    #endif
+
+/**
+ * Expand a key with AESKEYGENASSIST
+ *
+ * Produces the same schedule as the portable key expansion.
+ *
+ * @param[out] aes expanded key
+ * @param[in] keySize enumerated size of `key`
+ * @param[in] key pointer to the key (any alignment)
+ *
+ * */
+void MODA_AES_NI_Init(struct aes_ctxt *aes, enum aes_key_size keySize, const uint8_t *key);
+
+/**
+ * Encrypt a block with AES-NI
+ *
+ * @param[in] aes expanded key
+ * @param[in] s pointer to #AES_BLOCK_SIZE bytes of state (any alignment)
+ *
+ * */
+void MODA_AES_NI_Encrypt(const struct aes_ctxt *aes, uint8_t *s);
+
+/**
+ * Decrypt a block with AES-NI
+ *
+ * @param[in] aes expanded key
+ * @param[in] s pointer to #AES_BLOCK_SIZE bytes of state (any alignment)
+ *
+ * */
+void MODA_AES_NI_Decrypt(const struct aes_ctxt *aes, uint8_t *s);
+
+/**
+ * Encrypt consecutive blocks with AES-NI, four at a time
+ *
+ * @note `out` may equal `in`
+ *
+ * @param[in] aes expanded key
+ * @param[out] out output blocks (any alignment)
+ * @param[in] in input blocks (any alignment)
+ * @param[in] n number of blocks
+ *
+ * */
+void MODA_AES_NI_EncryptBlocks(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in, size_t n);
+
+/**
+ * Encrypt one block per key with AES-NI, four at a time
+ *
+ * @note `out` may equal `in`
+ *
+ * @param[in] aes `n` expanded keys
+ * @param[out] out output blocks (any alignment)
+ * @param[in] in input blocks (any alignment)
+ * @param[in] n number of blocks
+ *
+ * */
+void MODA_AES_NI_EncryptMany(const struct aes_ctxt *const *aes, uint8_t *out, const uint8_t *in, size_t n);
+
+/**
+ * Decrypt consecutive blocks with AES-NI, four at a time
+ *
+ * @note `out` may equal `in`
+ *
+ * @param[in] aes expanded key
+ * @param[out] out output blocks (any alignment)
+ * @param[in] in input blocks (any alignment)
+ * @param[in] n number of blocks
+ *
+ * */
+void MODA_AES_NI_DecryptBlocks(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in, size_t n);
+
+#endif
+
+#if defined(MODA_AES_VPERM)
+
+    #if !defined(__x86_64__) && !defined(__i386__)
+        #error "MODA_AES_VPERM requires an x86 target"
+    #endif
+
+/**
+ * Expand a key using the SSSE3 engine to compute SubWord
+ *
+ * Produces the same schedule as the portable key expansion.
+ *
+ * @param[out] aes expanded key
+ * @param[in] keySize enumerated size of `key`
+ * @param[in] key pointer to the key (any alignment)
+ *
+ * */
+void MODA_AES_VPERM_Init(struct aes_ctxt *aes, enum aes_key_size keySize, const uint8_t *key);
+
+/**
+ * Expand several keys of the same size, four schedules per vector
+ *
+ * @param[out] aes `n` contexts
+ * @param[in] keySize enumerated size of each key
+ * @param[in] key `n` consecutive keys (any alignment)
+ * @param[in] n number of keys
+ *
+ * */
+void MODA_AES_VPERM_InitMany(struct aes_ctxt *aes, enum aes_key_size keySize, const uint8_t *key, size_t n);
+
+/**
+ * Encrypt a block with the SSSE3 vector permute engine
+ *
+ * @param[in] aes expanded key
+ * @param[in] s pointer to #AES_BLOCK_SIZE bytes of state (any alignment)
+ *
+ * */
+void MODA_AES_VPERM_Encrypt(const struct aes_ctxt *aes, uint8_t *s);
+
+/**
+ * Decrypt a block with the SSSE3 vector permute engine
+ *
+ * @param[in] aes expanded key
+ * @param[in] s pointer to #AES_BLOCK_SIZE bytes of state (any alignment)
+ *
+ * */
+void MODA_AES_VPERM_Decrypt(const struct aes_ctxt *aes, uint8_t *s);
+
+/**
+ * Encrypt consecutive blocks with the SSSE3 engine, four at a time
+ *
+ * @note `out` may equal `in`
+ *
+ * @param[in] aes expanded key
+ * @param[out] out output blocks (any alignment)
+ * @param[in] in input blocks (any alignment)
+ * @param[in] n number of blocks
+ *
+ * */
+void MODA_AES_VPERM_EncryptBlocks(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in, size_t n);
+
+/**
+ * Encrypt one block per key with the SSSE3 engine, four at a time
+ *
+ * @note `out` may equal `in`
+ *
+ * @param[in] aes `n` expanded keys
+ * @param[out] out output blocks (any alignment)
+ * @param[in] in input blocks (any alignment)
+ * @param[in] n number of blocks
+ *
+ * */
+void MODA_AES_VPERM_EncryptMany(const struct aes_ctxt *const *aes, uint8_t *out, const uint8_t *in, size_t n);
+
+/**
+ * Decrypt consecutive blocks with the SSSE3 engine, four at a time
+ *
+ * @note `out` may equal `in`
+ *
+ * @param[in] aes expanded key
+ * @param[out] out output blocks (any alignment)
+ * @param[in] in input blocks (any alignment)
+ * @param[in] n number of blocks
+ *
+ * */
+void MODA_AES_VPERM_DecryptBlocks(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in, size_t n);
+
+#endif
+
+#if defined(MODA_GCM_PCLMUL)
+
+    #if !defined(__x86_64__) && !defined(__i386__)
+        #error "MODA_GCM_PCLMUL requires an x86 target"
+    #endif
+
+/**
+ * Derive the powers of the hash subkey used by MODA_GCM_PCLMUL_Hash()
+ *
+ * @param[out] hpow #MODA_GCM_PCLMUL_POWERS * #AES_BLOCK_SIZE bytes (any alignment)
+ * @param[in] h hash subkey as GCM bytes (any alignment)
+ *
+ * */
+void MODA_GCM_PCLMUL_Init(uint8_t *hpow, const uint8_t *h);
+
+/**
+ * GHASH whole blocks with PCLMULQDQ
+ *
+ * Up to #MODA_GCM_PCLMUL_POWERS blocks are multiplied by descending
+ * powers of H and summed before a single reduction.
+ *
+ * @param[in] hpow from MODA_GCM_PCLMUL_Init()
+ * @param[in/out] x hash state as GCM bytes (any alignment)
+ * @param[in] in `n` * #AES_BLOCK_SIZE bytes (any alignment)
+ * @param[in] n number of blocks
+ *
+ * */
+void MODA_GCM_PCLMUL_Hash(const uint8_t *hpow, uint8_t *x, const uint8_t *in, size_t n);
+
+#if defined(MODA_AES_NI)
+
+/**
+ * Encrypt or decrypt with AES-NI stitched with PCLMULQDQ GHASH
+ *
+ * Counter blocks are encrypted eight at a time and the GHASH of eight
+ * blocks of cipher text is interleaved with the AES rounds. Input and
+ * output are read and written directly.
+ *
+ * @note `out` may equal `in`
+ *
+ * @param[in] aes expanded key (from MODA_AES_NI_Init())
+ * @param[in] hpow from MODA_GCM_PCLMUL_Init()
+ * @param[in/out] counter last counter block used
+ * @param[in/out] x hash state as GCM bytes (any alignment)
+ * @param[out] out output blocks (any alignment)
+ * @param[in] in input blocks (any alignment)
+ * @param[in] n number of blocks (a multiple of #MODA_GCM_PCLMUL_POWERS)
+ * @param[in] encrypt true to encrypt, false to decrypt
+ *
+ * */
+void MODA_GCM_PCLMUL_CryptBlocks(const struct aes_ctxt *aes, const uint8_t *hpow, uint8_t *counter, uint8_t *x, uint8_t *out, const uint8_t *in, size_t n, bool encrypt);
+
+#endif
+
+#endif
+
 #endif
@@ -25,18 +25,10 @@
 #include "moda_internal.h"
 
 #include <string.h>
+#include <stdbool.h>
 
 /* defines ************************************************************/
 
-/* this will place target specific attributes after sbox, rsbox and rcon (e.g. IAR) */
-#ifndef MODA_CONST_PRE
-    #define MODA_CONST_PRE
-#endif
-/* this will place target specific attributes before sbox, rsbox and rcon (e.g GCC) */
-#ifndef MODA_CONST_POST
-    #define MODA_CONST_POST
-#endif    
-
 #ifndef SBOX
     #define SBOX(C) sbox[(C)]
 #endif
@@ -57,10 +49,90 @@
 #define C3 8U
 #define C4 12U
 
+/* key schedules interleaved by MODA_AES_InitMany() */
+#define INIT_LANES 4U
+
+/* blocks that share each on the fly round key in MODA_AES_EncryptBlocks() */
+#define OTF_BATCH 8U
+
+/* sliced states that hold OTF_BATCH blocks */
+#define OTF_STATES ((OTF_BATCH + MODA_SLICE_BLOCKS - 1U) / MODA_SLICE_BLOCKS)
+
+/* N mod NK and N / NK for the three key sizes without a divide */
+#define OTF_MOD(N, NK) (((NK) == 6U) ? ((N) % 6U) : ((N) & ((NK) - 1U)))
+#define OTF_DIV(N, NK) (((NK) == 6U) ? ((N) / 6U) : ((N) >> (((NK) >> 2U) + 1U)))
+
 #define GALOIS_MUL2(B) ((((B) & 0x80U) == 0x80U) ? (uint8_t)(((B) << 1U) ^ 0x1bU) : (uint8_t)((B) << 1U))
 
+/* The key schedule works on the round keys as 32bit words, moved with
+ * loadWord() and storeWord() so that the byte array is never accessed
+ * through another type. Only SubWord and RotWord touch bytes.
+ *
+ * Word N of the schedule for a key of NK words (K bytes): */
+
+#if defined(MODA_AES_SBOX_COMPUTED)
+
+/* RotWord and Rcon on a word in memory order */
+#ifdef MODA_BIG_ENDIAN
+    #define ROT_WORD(W) (((W) << 8U) | ((W) >> 24U))
+    #define RCON_WORD(I) ((uint32_t)RCON((I)) << 24U)
+#else
+    #define ROT_WORD(W) (((W) >> 8U) | ((W) << 24U))
+    #define RCON_WORD(I) ((uint32_t)RCON((I)))
+#endif
+
+/* W[N] = SubWord(RotWord(W[N-1])) ^ Rcon(I) ^ W[N-NK] */
+#define KEY_CORE(K, N, NK, I) do{ \
+    uint32_t w_ = loadWord((K), (N) - 1U); \
+    w_ = ROT_WORD(w_); \
+    MODA_AES_SubWords(&w_, 1U); \
+    storeWord((K), (N), w_ ^ RCON_WORD((I)) ^ loadWord((K), (N) - (NK))); \
+}while(0)
+
+/* W[N] = SubWord(W[N-1]) ^ W[N-NK] */
+#define KEY_SUB(K, N, NK) do{ \
+    uint32_t w_ = loadWord((K), (N) - 1U); \
+    MODA_AES_SubWords(&w_, 1U); \
+    storeWord((K), (N), w_ ^ loadWord((K), (N) - (NK))); \
+}while(0)
+
+#else
+
+/* W[N] = SubWord(RotWord(W[N-1])) ^ Rcon(I) ^ W[N-NK] */
+#define KEY_CORE(K, N, NK, I) do{ \
+    (K)[((N) << 2U)     ] = SBOX( (K)[((N) << 2U) - 3U] ) ^ RCON((I)); \
+    (K)[((N) << 2U) + 1U] = SBOX( (K)[((N) << 2U) - 2U] ); \
+    (K)[((N) << 2U) + 2U] = SBOX( (K)[((N) << 2U) - 1U] ); \
+    (K)[((N) << 2U) + 3U] = SBOX( (K)[((N) << 2U) - 4U] ); \
+    KEY_MIX((K), (N), (N) - (NK)); \
+}while(0)
+
+/* W[N] = SubWord(W[N-1]) ^ W[N-NK] */
+#define KEY_SUB(K, N, NK) do{ \
+    (K)[((N) << 2U)     ] = SBOX( (K)[((N) << 2U) - 4U] ); \
+    (K)[((N) << 2U) + 1U] = SBOX( (K)[((N) << 2U) - 3U] ); \
+    (K)[((N) << 2U) + 2U] = SBOX( (K)[((N) << 2U) - 2U] ); \
+    (K)[((N) << 2U) + 3U] = SBOX( (K)[((N) << 2U) - 1U] ); \
+    KEY_MIX((K), (N), (N) - (NK)); \
+}while(0)
+
+#endif
+
+/* W[N] = W[N-1] ^ W[N-NK] */
+#define KEY_XOR(K, N, NK) storeWord((K), (N), loadWord((K), (N) - 1U) ^ loadWord((K), (N) - (NK)))
+
+/* W[N] ^= W[M] */
+#define KEY_MIX(K, N, M) storeWord((K), (N), loadWord((K), (N)) ^ loadWord((K), (M)))
+
+/* byte oriented cipher round with the round key at K[P] */
+#define ENC_ROUND(S, K, P) do{ addSubShift((S), &(K)[(P)]); mixColumns((S)); }while(0)
+
+/* byte oriented inverse cipher round with the round key at K[P] */
+#define DEC_ROUND(S, K, P) do{ invMixColumns((S)); invShiftSubAdd((S), &(K)[(P)]); }while(0)
+
 /* static variables ***************************************************/
 
+#if !defined(MODA_AES_BITSLICE) && !defined(MODA_AES_SBOX_COMPUTED)
 MODA_CONST_PRE static const uint8_t sbox[] MODA_CONST_POST = {
     0x63U, 0x7cU, 0x77U, 0x7bU, 0xf2U, 0x6bU, 0x6fU, 0xc5U,
     0x30U, 0x01U, 0x67U, 0x2bU, 0xfeU, 0xd7U, 0xabU, 0x76U,
@@ -95,308 +167,1747 @@ MODA_CONST_PRE static const uint8_t sbox[] MODA_CONST_POST = {
     0x8cU, 0xa1U, 0x89U, 0x0dU, 0xbfU, 0xe6U, 0x42U, 0x68U,
     0x41U, 0x99U, 0x2dU, 0x0fU, 0xb0U, 0x54U, 0xbbU, 0x16U
 };
+#endif
+
+#if !defined(MODA_AES_BITSLICE)
+MODA_CONST_PRE static const uint8_t rcon[] MODA_CONST_POST = {
+    0x8dU, 0x01U, 0x02U, 0x04U, 0x08U, 0x10U, 0x20U, 0x40U, 0x80U, 0x1bU, 0x36U
+};
+#endif
+
+#if !defined(MODA_AES_DECRYPT_SCHEDULE) && !defined(MODA_AES_BITSLICE) && !defined(MODA_AES_SBOX_COMPUTED)
+MODA_CONST_PRE static const uint8_t rsbox[] MODA_CONST_POST = {
+    0x52U, 0x09U, 0x6aU, 0xd5U, 0x30U, 0x36U, 0xa5U, 0x38U,
+    0xbfU, 0x40U, 0xa3U, 0x9eU, 0x81U, 0xf3U, 0xd7U, 0xfbU,
+    0x7cU, 0xe3U, 0x39U, 0x82U, 0x9bU, 0x2fU, 0xffU, 0x87U,
+    0x34U, 0x8eU, 0x43U, 0x44U, 0xc4U, 0xdeU, 0xe9U, 0xcbU,
+    0x54U, 0x7bU, 0x94U, 0x32U, 0xa6U, 0xc2U, 0x23U, 0x3dU,
+    0xeeU, 0x4cU, 0x95U, 0x0bU, 0x42U, 0xfaU, 0xc3U, 0x4eU,
+    0x08U, 0x2eU, 0xa1U, 0x66U, 0x28U, 0xd9U, 0x24U, 0xb2U,
+    0x76U, 0x5bU, 0xa2U, 0x49U, 0x6dU, 0x8bU, 0xd1U, 0x25U,
+    0x72U, 0xf8U, 0xf6U, 0x64U, 0x86U, 0x68U, 0x98U, 0x16U,
+    0xd4U, 0xa4U, 0x5cU, 0xccU, 0x5dU, 0x65U, 0xb6U, 0x92U,
+    0x6cU, 0x70U, 0x48U, 0x50U, 0xfdU, 0xedU, 0xb9U, 0xdaU,
+    0x5eU, 0x15U, 0x46U, 0x57U, 0xa7U, 0x8dU, 0x9dU, 0x84U,
+    0x90U, 0xd8U, 0xabU, 0x00U, 0x8cU, 0xbcU, 0xd3U, 0x0aU,
+    0xf7U, 0xe4U, 0x58U, 0x05U, 0xb8U, 0xb3U, 0x45U, 0x06U,
+    0xd0U, 0x2cU, 0x1eU, 0x8fU, 0xcaU, 0x3fU, 0x0fU, 0x02U,
+    0xc1U, 0xafU, 0xbdU, 0x03U, 0x01U, 0x13U, 0x8aU, 0x6bU,
+    0x3aU, 0x91U, 0x11U, 0x41U, 0x4fU, 0x67U, 0xdcU, 0xeaU,
+    0x97U, 0xf2U, 0xcfU, 0xceU, 0xf0U, 0xb4U, 0xe6U, 0x73U,
+    0x96U, 0xacU, 0x74U, 0x22U, 0xe7U, 0xadU, 0x35U, 0x85U,
+    0xe2U, 0xf9U, 0x37U, 0xe8U, 0x1cU, 0x75U, 0xdfU, 0x6eU,
+    0x47U, 0xf1U, 0x1aU, 0x71U, 0x1dU, 0x29U, 0xc5U, 0x89U,
+    0x6fU, 0xb7U, 0x62U, 0x0eU, 0xaaU, 0x18U, 0xbeU, 0x1bU,
+    0xfcU, 0x56U, 0x3eU, 0x4bU, 0xc6U, 0xd2U, 0x79U, 0x20U,
+    0x9aU, 0xdbU, 0xc0U, 0xfeU, 0x78U, 0xcdU, 0x5aU, 0xf4U,
+    0x1fU, 0xddU, 0xa8U, 0x33U, 0x88U, 0x07U, 0xc7U, 0x31U,
+    0xb1U, 0x12U, 0x10U, 0x59U, 0x27U, 0x80U, 0xecU, 0x5fU,
+    0x60U, 0x51U, 0x7fU, 0xa9U, 0x19U, 0xb5U, 0x4aU, 0x0dU,
+    0x2dU, 0xe5U, 0x7aU, 0x9fU, 0x93U, 0xc9U, 0x9cU, 0xefU,
+    0xa0U, 0xe0U, 0x3bU, 0x4dU, 0xaeU, 0x2aU, 0xf5U, 0xb0U,
+    0xc8U, 0xebU, 0xbbU, 0x3cU, 0x83U, 0x53U, 0x99U, 0x61U,
+    0x17U, 0x2bU, 0x04U, 0x7eU, 0xbaU, 0x77U, 0xd6U, 0x26U,
+    0xe1U, 0x69U, 0x14U, 0x63U, 0x55U, 0x21U, 0x0cU, 0x7dU
+};
+#endif
+
+/* static function prototypes *****************************************/
+
+#if !defined(MODA_AES_BITSLICE) && !defined(MODA_AES_OTF)
+/**
+ * Byte oriented Rijndael key schedule
+ *
+ * @param[out] aes expanded key
+ * @param[in] keySize enumerated size of `key`
+ * @param[in] key pointer to the key (any alignment)
+ *
+ * */
+static void expandKey(struct aes_ctxt *aes, enum aes_key_size keySize, const uint8_t *key);
+#endif
+
+#if !defined(MODA_AES_BITSLICE) && !defined(MODA_AES_OTF)
+/**
+ * Rijndael key schedule for up to #INIT_LANES keys in lockstep
+ *
+ * @param[out] aes `n` contexts
+ * @param[in] keySize enumerated size of each key
+ * @param[in] key `n` consecutive keys (any alignment)
+ * @param[in] n number of keys (1..#INIT_LANES)
+ *
+ * */
+static void expandKeys(struct aes_ctxt *aes, enum aes_key_size keySize, const uint8_t *key, size_t n);
+#endif
+
+#if !defined(MODA_AES_BITSLICE) && !defined(MODA_AES_OTF)
+/**
+ * Load word N of a key schedule
+ *
+ * @param[in] k key schedule
+ * @param[in] n word index
+ * @return word (in memory byte order)
+ *
+ * */
+static uint32_t loadWord(const uint8_t *k, uint8_t n);
+
+/**
+ * Store word N of a key schedule
+ *
+ * @param[out] k key schedule
+ * @param[in] n word index
+ * @param[in] w word (in memory byte order)
+ *
+ * */
+static void storeWord(uint8_t *k, uint8_t n, uint32_t w);
+#endif
+
+#if defined(MODA_AES_UNROLL)
+/**
+ * Rijndael key schedule for one key size (no key size tests in the loop)
+ *
+ * @param[out] aes expanded key
+ * @param[in] key pointer to the key (any alignment)
+ *
+ * */
+static void expandKey128(struct aes_ctxt *aes, const uint8_t *key);
+static void expandKey192(struct aes_ctxt *aes, const uint8_t *key);
+static void expandKey256(struct aes_ctxt *aes, const uint8_t *key);
+#endif
+
+#if defined(MODA_AES_OTF)
+/**
+ * Store the key for on the fly expansion
+ *
+ * @param[out] aes context
+ * @param[in] keySize enumerated size of `key`
+ * @param[in] key pointer to the key (any alignment)
+ *
+ * */
+static void storeKey(struct aes_ctxt *aes, enum aes_key_size keySize, const uint8_t *key);
+
+/**
+ * Encrypt consecutive blocks deriving each round key once for all of them
+ *
+ * @param[in] aes context
+ * @param[in] s pointer to `n` * #AES_BLOCK_SIZE bytes of state (any alignment)
+ * @param[in] n number of blocks
+ *
+ * */
+static void otfEncrypt(const struct aes_ctxt *aes, uint8_t *s, size_t n);
+
+/**
+ * Decrypt consecutive blocks running the key schedule backwards
+ *
+ * @param[in] aes context
+ * @param[in] s pointer to `n` * #AES_BLOCK_SIZE bytes of state (any alignment)
+ * @param[in] n number of blocks
+ *
+ * */
+static void otfDecrypt(const struct aes_ctxt *aes, uint8_t *s, size_t n);
+
+/**
+ * Move a window of `nk` schedule words so that it holds round key `round`
+ * and copy that round key out
+ *
+ * The window holds words `top - nk` to `top - 1`, each in slot
+ * (index mod `nk`). It is moved forward or backward one word at a time.
+ *
+ * @param[out] rk #AES_BLOCK_SIZE bytes of round key
+ * @param[in/out] w window of `nk` words
+ * @param[in] nk key size in words
+ * @param[in/out] top index of the word after the window
+ * @param[in] round round key number
+ *
+ * */
+static void otfRoundKey(uint8_t *rk, uint8_t *w, uint8_t nk, uint8_t *top, uint8_t round);
+
+/**
+ * One step of the key schedule on a window of `nk` words
+ *
+ * Applied to a slot holding W[N-NK] it yields W[N] and applied to a slot
+ * holding W[N] it yields W[N-NK], so the same step runs the schedule in
+ * either direction.
+ *
+ * @param[in/out] w window of `nk` words
+ * @param[in] nk key size in words
+ * @param[in] n index of the word to step
+ *
+ * */
+static void otfKeyStep(uint8_t *w, uint8_t nk, uint8_t n);
+#endif
+
+#if !defined(MODA_AES_BITSLICE) && !defined(MODA_AES_OTF) && (!defined(MODA_AES_TABLES) || defined(MODA_AES_UNROLL))
+/**
+ * Block encrypt with the portable engine
+ *
+ * Loops over the rounds or, with MODA_AES_UNROLL, dispatches on the
+ * round count to the unrolled key size variants.
+ *
+ * @param[in] aes expanded key
+ * @param[in] s pointer to #AES_BLOCK_SIZE bytes of state (any alignment)
+ *
+ * */
+static void encryptBlock(const struct aes_ctxt *aes, uint8_t *s);
+#endif
+
+#if !defined(MODA_AES_BITSLICE) && !defined(MODA_AES_OTF) && (!defined(MODA_AES_DECRYPT_SCHEDULE) || defined(MODA_AES_UNROLL))
+/**
+ * Block decrypt with the portable engine
+ *
+ * @param[in] aes expanded key
+ * @param[in] s pointer to #AES_BLOCK_SIZE bytes of state (any alignment)
+ *
+ * */
+static void decryptBlock(const struct aes_ctxt *aes, uint8_t *s);
+#endif
+
+#if !defined(MODA_AES_TABLES) && !defined(MODA_AES_BITSLICE) && !defined(MODA_AES_SBOX_COMPUTED)
+/**
+ * Byte oriented AddRoundKey, SubBytes and ShiftRows
+ *
+ * @param[in/out] s state
+ * @param[in] k round key
+ *
+ * */
+static void addSubShift(uint8_t *s, const uint8_t *k);
+
+/**
+ * Byte oriented MixColumns
+ *
+ * @param[in/out] s state
+ *
+ * */
+static void mixColumns(uint8_t *s);
+#endif
+
+#if !defined(MODA_AES_DECRYPT_SCHEDULE) && !defined(MODA_AES_BITSLICE) && !defined(MODA_AES_SBOX_COMPUTED)
+/**
+ * Byte oriented InvShiftRows, InvSubBytes and AddRoundKey
+ *
+ * @param[in/out] s state
+ * @param[in] k round key
+ *
+ * */
+static void invShiftSubAdd(uint8_t *s, const uint8_t *k);
+
+/**
+ * Byte oriented InvMixColumns
+ *
+ * @param[in/out] s state
+ *
+ * */
+static void invMixColumns(uint8_t *s);
+
+/**
+ * AddRoundKey
+ *
+ * @param[in/out] s state
+ * @param[in] k round key
+ *
+ * */
+static void addRoundKey(uint8_t *s, const uint8_t *k);
+#endif
+
+#if defined(MODA_AES_SBOX_COMPUTED) && !defined(MODA_AES_OTF)
+/**
+ * Slice every round key of the expanded key into aes->sk
+ *
+ * @param[in/out] aes expanded key
+ *
+ * */
+static void sliceSchedule(struct aes_ctxt *aes);
+
+/**
+ * Encrypt up to #MODA_SLICE_BLOCKS consecutive blocks as one sliced state
+ *
+ * @note `out` may equal `in`
+ *
+ * @param[in] aes expanded key
+ * @param[out] out `n` * #AES_BLOCK_SIZE bytes (any alignment)
+ * @param[in] in `n` * #AES_BLOCK_SIZE bytes (any alignment)
+ * @param[in] n number of blocks
+ *
+ * */
+static void encryptLanes(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in, size_t n);
+
+/**
+ * Encrypt one block under each of up to #MODA_SLICE_BLOCKS keys of the
+ * same size as one sliced state
+ *
+ * @param[in] aes `n` pointers to expanded keys
+ * @param[out] out `n` * #AES_BLOCK_SIZE bytes (any alignment)
+ * @param[in] in `n` * #AES_BLOCK_SIZE bytes (any alignment)
+ * @param[in] n number of blocks
+ *
+ * */
+static void encryptKeyLanes(const struct aes_ctxt *const *aes, uint8_t *out, const uint8_t *in, size_t n);
+
+/**
+ * Decrypt up to #MODA_SLICE_BLOCKS consecutive blocks as one sliced state
+ *
+ * @note `out` may equal `in`
+ *
+ * @param[in] aes expanded key
+ * @param[out] out `n` * #AES_BLOCK_SIZE bytes (any alignment)
+ * @param[in] in `n` * #AES_BLOCK_SIZE bytes (any alignment)
+ * @param[in] n number of blocks
+ *
+ * */
+static void decryptLanes(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in, size_t n);
+#endif
+
+#ifndef NDEBUG
+/**
+ * Check the aliasing rule of the multi-block functions
+ *
+ * @param[in] out
+ * @param[in] in
+ * @param[in] nblocks
+ * @return true if `out` equals `in` or the buffers do not overlap
+ *
+ * */
+static bool aliasOk(const uint8_t *out, const uint8_t *in, size_t nblocks);
+#endif
 
 /* functions **********************************************************/
 
 void MODA_AES_Init(struct aes_ctxt *aes, enum aes_key_size keySize, const uint8_t *key)
 {
-    uint8_t p;
-    uint8_t j;
-    uint8_t b = 0U;
-    uint8_t swap;
-    uint8_t *k;
-    uint8_t ks;
-    uint8_t i = 1U;
-
-    MODA_CONST_PRE static const uint8_t rcon[] MODA_CONST_POST = {
-        0x8dU, 0x01U, 0x02U, 0x04U, 0x08U, 0x10U, 0x20U, 0x40U, 0x80U, 0x1bU, 0x36U
-    };
-
     ASSERT((aes != NULL))
     ASSERT((key != NULL))
-    
-    switch(keySize){
-    case AES_KEY_128:
-        aes->r = 10U;
-        b = 176U;
-        break;
 
-    case AES_KEY_192:
-        aes->r = 12U;
-        b = 208U;
-        break;
+#if defined(MODA_AES_NI)
+    if(MODA_CPU_HAS(MODA_CPU_AES)){
 
-    case AES_KEY_256:
-        aes->r = 14U;
-        b = 240U;
-        break;         
+        MODA_AES_NI_Init(aes, keySize, key);
+    }
+    else
+#endif
+#if defined(MODA_AES_VPERM)
+    if(MODA_CPU_HAS(MODA_CPU_SSSE3)){
 
-    default:
-        /* impossible */
-        break;
+        MODA_AES_VPERM_Init(aes, keySize, key);
     }
+    else
+#endif
+    {
+#if defined(MODA_AES_BITSLICE)
+        MODA_AES_BitsliceInit(aes, keySize, key);
+#elif defined(MODA_AES_OTF)
+        storeKey(aes, keySize, key);
+#else
+        expandKey(aes, keySize, key);
+#endif
 
-    (void)memcpy(aes->k, key, (size_t)keySize);
-    k = aes->k;    
-    ks = (uint8_t)keySize;
-    p = ks;
+#if defined(MODA_AES_DECRYPT_SCHEDULE)
+        MODA_AES_TableInitDecrypt(aes);
+#endif
+    }
 
-    /* Rijndael key schedule */
-    while(p < b){
-        
-        swap = k[p - 4U];
-        k[p     ] = SBOX( k[p - 3U] ) ^ k[p      - ks] ^ RCON(i);
-        k[p + 1U] = SBOX( k[p - 2U] ) ^ k[p + 1U - ks];
-        k[p + 2U] = SBOX( k[p - 1U] ) ^ k[p + 2U - ks];
-        k[p + 3U] = SBOX( swap      ) ^ k[p + 3U - ks];
-        p += 4U;
+#if defined(MODA_AES_SBOX_COMPUTED) && !defined(MODA_AES_OTF)
+    /* the portable engine reads a sliced copy whichever backend expanded the key */
+    sliceSchedule(aes);
+#endif
+}
 
-        for(j=0U; j < 12U; j++){
+void MODA_AES_InitMany(struct aes_ctxt *aes, enum aes_key_size keySize, const uint8_t *key, size_t n)
+{
+#if defined(MODA_AES_NI) || !defined(MODA_AES_BITSLICE)
+    size_t i;
+#endif
 
-            k[p] = k[p - 4U] ^ k[p - ks];
-            p++;
-        }
+    ASSERT(((aes != NULL) && (key != NULL)) || (n == 0U))
 
-        if(p < b){
-            
-            if(keySize == AES_KEY_192){
+#if defined(MODA_AES_NI)
+    if(MODA_CPU_HAS(MODA_CPU_AES)){
 
-                for(j=0U; j < 8U; j++){
+        for(i = 0U; i < n; i++){
 
-                    k[p] = k[p - 4U] ^ k[p - ks];
-                    p++;
-                }
-            }
-            else{
+            MODA_AES_NI_Init(&aes[i], keySize, &key[i * (size_t)keySize]);
+        }
+    }
+    else
+#endif
+#if defined(MODA_AES_VPERM)
+    if(MODA_CPU_HAS(MODA_CPU_SSSE3)){
 
-                if(keySize == AES_KEY_256){
+        MODA_AES_VPERM_InitMany(aes, keySize, key, n);
+    }
+    else
+#endif
+    {
+#if defined(MODA_AES_BITSLICE)
+        MODA_AES_BitsliceInitMany(aes, keySize, key, n);
+#elif defined(MODA_AES_OTF)
+        for(i = 0U; i < n; i++){
 
-                    for(j=0U; j < 4U; j++){
+            storeKey(&aes[i], keySize, &key[i * (size_t)keySize]);
+        }
+#else
+        for(i = 0U; i < n; i += INIT_LANES){
 
-                        k[p] = sbox[ k[p - 4U] ] ^ k[p - ks];
-                        p++;
-                    }
+            expandKeys(&aes[i], keySize, &key[i * (size_t)keySize], ((n - i) < INIT_LANES) ? (n - i) : INIT_LANES);
+        }
+#endif
 
-                    for(j=0U; j < 12U; j++){
+#if defined(MODA_AES_DECRYPT_SCHEDULE)
+        for(i = 0U; i < n; i++){
 
-                        k[p] = k[p - 4U] ^ k[p - ks];
-                        p++;
-                    }
-                }
-            }
+            MODA_AES_TableInitDecrypt(&aes[i]);
         }
+#endif
+    }
 
-        i++;
+#if defined(MODA_AES_SBOX_COMPUTED) && !defined(MODA_AES_OTF)
+    for(i = 0U; i < n; i++){
+
+        sliceSchedule(&aes[i]);
     }
+#endif
 }
 
 void MODA_AES_Encrypt(const struct aes_ctxt *aes, uint8_t *s)
 {
-    uint8_t r;    
-    uint8_t a;
-    uint8_t b;
-    uint8_t c;
-    uint8_t d;    
-    uint8_t i;
-    uint8_t p = 0U;
-    const uint8_t *k = aes->k;
+#if defined(MODA_AES_NI)
+    if(MODA_CPU_HAS(MODA_CPU_AES)){
 
-    /* add round key, sbox and shiftrows */
-    for(r = 0U; r < aes->r; r++){
+        MODA_AES_NI_Encrypt(aes, s);
+    }
+    else
+#endif
+#if defined(MODA_AES_VPERM)
+    if(MODA_CPU_HAS(MODA_CPU_SSSE3)){
+
+        MODA_AES_VPERM_Encrypt(aes, s);
+    }
+    else
+#endif
+    {
+#if defined(MODA_AES_TABLES) && !defined(MODA_AES_UNROLL)
+        MODA_AES_TableEncrypt(aes, s, s);
+#elif defined(MODA_AES_BITSLICE)
+        MODA_AES_BitsliceEncrypt(aes, s);
+#elif defined(MODA_AES_OTF)
+        otfEncrypt(aes, s, 1U);
+#else
+        encryptBlock(aes, s);
+#endif
+    }
+}
 
-        /* add round key, sbox, left shift row */
+void MODA_AES_Decrypt(const struct aes_ctxt *aes, uint8_t *s)
+{
+#if defined(MODA_AES_NI)
+    if(MODA_CPU_HAS(MODA_CPU_AES)){
 
-        /* row 1 */
-        s[C1] = SBOX( s[C1] ^ k[p] );
-        s[C2] = SBOX( s[C2] ^ k[p + C2] );
-        s[C3] = SBOX( s[C3] ^ k[p + C3] );
-        s[C4] = SBOX( s[C4] ^ k[p + C4] );
-
-        /* row 2, left shift 1 */
-        a = SBOX( s[R2] ^ k[p + R2] );
-        s[R2     ] = SBOX( s[R2 + C2] ^ k[p + R2 + C2] );
-        s[R2 + C2] = SBOX( s[R2 + C3] ^ k[p + R2 + C3] );
-        s[R2 + C3] = SBOX( s[R2 + C4] ^ k[p + R2 + C4] );
-        s[R2 + C4] = a;
-
-        /* row 3, left shift 2 */
-        a = SBOX( s[R3     ] ^ k[p + R3] );
-        b = SBOX( s[R3 + C2] ^ k[p + R3 + C2] );
-        s[R3     ] = SBOX( s[R3 + C3] ^ k[p + R3 + C3] );
-        s[R3 + C2] = SBOX( s[R3 + C4] ^ k[p + R3 + C4] );
-        s[R3 + C3] = a;
-        s[R3 + C4] = b;
-
-        /* row 4, left shift 3 */
-        a = SBOX( s[R4 + C4] ^ k[p + R4 + C4] );
-        s[R4 + C4] = SBOX( s[R4 + C3] ^ k[p + R4 + C3] );
-        s[R4 + C3] = SBOX( s[R4 + C2] ^ k[p + R4 + C2] );
-        s[R4 + C2] = SBOX( s[R4     ] ^ k[p + R4     ] );
-        s[R4     ] = a;
-
-        if((r+1U) == aes->r){
-
-            p += 16U;
-
-            /* final add round key */
-            for(i=0U; i < 16U; i++){
-
-                s[i] ^= aes->k[p+i];
-            }
-            
-            break;
+        MODA_AES_NI_Decrypt(aes, s);
+    }
+    else
+#endif
+#if defined(MODA_AES_VPERM)
+    if(MODA_CPU_HAS(MODA_CPU_SSSE3)){
+
+        MODA_AES_VPERM_Decrypt(aes, s);
+    }
+    else
+#endif
+    {
+#if defined(MODA_AES_DECRYPT_SCHEDULE) && !defined(MODA_AES_UNROLL)
+        MODA_AES_TableDecrypt(aes, s, s);
+#elif defined(MODA_AES_BITSLICE)
+        MODA_AES_BitsliceDecrypt(aes, s);
+#elif defined(MODA_AES_OTF)
+        otfDecrypt(aes, s, 1U);
+#else
+        decryptBlock(aes, s);
+#endif
+    }
+}
+
+void MODA_AES_EncryptBlocks(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in, size_t nblocks)
+{
+    ASSERT((aes != NULL))
+    ASSERT(((out != NULL) && (in != NULL)) || (nblocks == 0U))
+    ASSERT((aliasOk(out, in, nblocks)))
+
+#if defined(MODA_AES_NI)
+    if(MODA_CPU_HAS(MODA_CPU_AES)){
+
+        MODA_AES_NI_EncryptBlocks(aes, out, in, nblocks);
+    }
+    else
+#endif
+#if defined(MODA_AES_VPERM)
+    if(MODA_CPU_HAS(MODA_CPU_SSSE3)){
+
+        MODA_AES_VPERM_EncryptBlocks(aes, out, in, nblocks);
+    }
+    else
+#endif
+    {
+#if defined(MODA_AES_BITSLICE)
+        MODA_AES_BitsliceEncryptBlocks(aes, out, in, nblocks);
+#elif defined(MODA_AES_OTF)
+        size_t i;
+
+        if((out != in) && (nblocks > 0U)){
+
+            (void)memcpy(out, in, nblocks << 4U);
         }
-         
-        /* mix columns */
-        for(i=0U; i < 16U; i += 4U){
 
-            a = s[i     ];
-            b = s[i + 1U];
-            c = s[i + 2U];
-            d = s[i + 3U];
+        for(i = 0U; i < nblocks; i += OTF_BATCH){
 
-            /* 2a + 3b + 1c + 1d 
-             * 1a + 2b + 3c + 1d
-             * 1a + 1b + 2c + 3d
-             * 3a + 1b + 1c + 2d
-             *
-             * */
-            s[i     ] ^= (a ^ b ^ c ^ d) ^ GALOIS_MUL2( (a ^ b) );
-            s[i + 1U] ^= (a ^ b ^ c ^ d) ^ GALOIS_MUL2( (b ^ c) );
-            s[i + 2U] ^= (a ^ b ^ c ^ d) ^ GALOIS_MUL2( (c ^ d) );
-            s[i + 3U] ^= (a ^ b ^ c ^ d) ^ GALOIS_MUL2( (d ^ a) );
+            otfEncrypt(aes, &out[i << 4U], ((nblocks - i) < OTF_BATCH) ? (nblocks - i) : OTF_BATCH);
         }
+#elif defined(MODA_AES_SBOX_COMPUTED)
+        size_t i;
+
+        for(i = 0U; i < nblocks; i += MODA_SLICE_BLOCKS){
+
+            encryptLanes(aes, &out[i << 4U], &in[i << 4U], ((nblocks - i) < MODA_SLICE_BLOCKS) ? (nblocks - i) : MODA_SLICE_BLOCKS);
+        }
+#else
+        size_t i;
+
+        for(i = 0U; i < nblocks; i++){
 
-        p += 16U;
-    }   
+#if defined(MODA_AES_TABLES) && !defined(MODA_AES_UNROLL)
+            MODA_AES_TableEncrypt(aes, &out[i << 4U], &in[i << 4U]);
+#else
+            if(out != in){
+
+                (void)memcpy(&out[i << 4U], &in[i << 4U], AES_BLOCK_SIZE);
+            }
+
+            encryptBlock(aes, &out[i << 4U]);
+#endif
+        }
+#endif
+    }
 }
 
-void MODA_AES_Decrypt(const struct aes_ctxt *aes, uint8_t *s)
+void MODA_AES_EncryptMany(const struct aes_ctxt *const *aes, uint8_t *out, const uint8_t *in, size_t n)
 {
-    uint8_t r;
-    uint8_t a;
-    uint8_t b;
-    uint8_t c;
-    uint8_t d;
-    uint8_t e;
-    uint8_t x;
-    uint8_t y;
-    uint8_t i;
-    uint8_t p;
-    const uint8_t *k = aes->k;
+    ASSERT(((aes != NULL) && (out != NULL) && (in != NULL)) || (n == 0U))
+    ASSERT((aliasOk(out, in, n)))
 
-    MODA_CONST_PRE static const uint8_t rsbox[] MODA_CONST_POST = {
-        0x52U, 0x09U, 0x6aU, 0xd5U, 0x30U, 0x36U, 0xa5U, 0x38U,
-        0xbfU, 0x40U, 0xa3U, 0x9eU, 0x81U, 0xf3U, 0xd7U, 0xfbU,
-        0x7cU, 0xe3U, 0x39U, 0x82U, 0x9bU, 0x2fU, 0xffU, 0x87U,
-        0x34U, 0x8eU, 0x43U, 0x44U, 0xc4U, 0xdeU, 0xe9U, 0xcbU,
-        0x54U, 0x7bU, 0x94U, 0x32U, 0xa6U, 0xc2U, 0x23U, 0x3dU,
-        0xeeU, 0x4cU, 0x95U, 0x0bU, 0x42U, 0xfaU, 0xc3U, 0x4eU,
-        0x08U, 0x2eU, 0xa1U, 0x66U, 0x28U, 0xd9U, 0x24U, 0xb2U,
-        0x76U, 0x5bU, 0xa2U, 0x49U, 0x6dU, 0x8bU, 0xd1U, 0x25U,
-        0x72U, 0xf8U, 0xf6U, 0x64U, 0x86U, 0x68U, 0x98U, 0x16U,
-        0xd4U, 0xa4U, 0x5cU, 0xccU, 0x5dU, 0x65U, 0xb6U, 0x92U,
-        0x6cU, 0x70U, 0x48U, 0x50U, 0xfdU, 0xedU, 0xb9U, 0xdaU,
-        0x5eU, 0x15U, 0x46U, 0x57U, 0xa7U, 0x8dU, 0x9dU, 0x84U,
-        0x90U, 0xd8U, 0xabU, 0x00U, 0x8cU, 0xbcU, 0xd3U, 0x0aU,
-        0xf7U, 0xe4U, 0x58U, 0x05U, 0xb8U, 0xb3U, 0x45U, 0x06U,
-        0xd0U, 0x2cU, 0x1eU, 0x8fU, 0xcaU, 0x3fU, 0x0fU, 0x02U,
-        0xc1U, 0xafU, 0xbdU, 0x03U, 0x01U, 0x13U, 0x8aU, 0x6bU,
-        0x3aU, 0x91U, 0x11U, 0x41U, 0x4fU, 0x67U, 0xdcU, 0xeaU,
-        0x97U, 0xf2U, 0xcfU, 0xceU, 0xf0U, 0xb4U, 0xe6U, 0x73U,
-        0x96U, 0xacU, 0x74U, 0x22U, 0xe7U, 0xadU, 0x35U, 0x85U,
-        0xe2U, 0xf9U, 0x37U, 0xe8U, 0x1cU, 0x75U, 0xdfU, 0x6eU,
-        0x47U, 0xf1U, 0x1aU, 0x71U, 0x1dU, 0x29U, 0xc5U, 0x89U,
-        0x6fU, 0xb7U, 0x62U, 0x0eU, 0xaaU, 0x18U, 0xbeU, 0x1bU,
-        0xfcU, 0x56U, 0x3eU, 0x4bU, 0xc6U, 0xd2U, 0x79U, 0x20U,
-        0x9aU, 0xdbU, 0xc0U, 0xfeU, 0x78U, 0xcdU, 0x5aU, 0xf4U,
-        0x1fU, 0xddU, 0xa8U, 0x33U, 0x88U, 0x07U, 0xc7U, 0x31U,
-        0xb1U, 0x12U, 0x10U, 0x59U, 0x27U, 0x80U, 0xecU, 0x5fU,
-        0x60U, 0x51U, 0x7fU, 0xa9U, 0x19U, 0xb5U, 0x4aU, 0x0dU,
-        0x2dU, 0xe5U, 0x7aU, 0x9fU, 0x93U, 0xc9U, 0x9cU, 0xefU,
-        0xa0U, 0xe0U, 0x3bU, 0x4dU, 0xaeU, 0x2aU, 0xf5U, 0xb0U,
-        0xc8U, 0xebU, 0xbbU, 0x3cU, 0x83U, 0x53U, 0x99U, 0x61U,
-        0x17U, 0x2bU, 0x04U, 0x7eU, 0xbaU, 0x77U, 0xd6U, 0x26U,
-        0xe1U, 0x69U, 0x14U, 0x63U, 0x55U, 0x21U, 0x0cU, 0x7dU
-    };
-    
-    p = (uint8_t)(aes->r << 4U);
-    
-    /* add round key */
-    for(i=0U; i < 16U; i++){
+#if defined(MODA_AES_NI)
+    if(MODA_CPU_HAS(MODA_CPU_AES)){
 
-        s[i] ^= aes->k[p+i];
+        MODA_AES_NI_EncryptMany(aes, out, in, n);
     }
+    else
+#endif
+#if defined(MODA_AES_VPERM)
+    if(MODA_CPU_HAS(MODA_CPU_SSSE3)){
 
-    p -= 16U;
- 
-    /* add round key, sbox and shiftrows */
-    for(r = aes->r; (r != 0U); r--){
-
-        if(r < aes->r){
-
-            /* inverse mix columns */
-            for(i=0U; i < 16U; i += 4U){
-
-                a = s[i     ];
-                b = s[i + 1U];
-                c = s[i + 2U];
-                d = s[i + 3U];
-
-                /* 2a + 2b + 2c + 2d */
-                e = GALOIS_MUL2( (a ^ b ^ c ^ d) );
-
-                /* 13a + 9b + 13c + 9d */
-                x = GALOIS_MUL2( (e ^ a ^ c) );                
-                x = (a ^ b ^ c ^ d) ^ GALOIS_MUL2( x );
-
-                /* 9a + 13b + 9c + 13d */
-                y = GALOIS_MUL2( (e ^ b ^ d) );                
-                y = (a ^ b ^ c ^ d) ^ GALOIS_MUL2( y );
-                
-                /* 14a + 11b + 13c + 9d
-                 * 9a + 14b + 11c + 13d
-                 * 13a + 9b + 14c + 11d
-                 * 11a + 13b + 9c + 14d
-                 *
-                 * */
-                s[i     ] ^= x ^ GALOIS_MUL2( (a ^ b) );
-                s[i + 1U] ^= y ^ GALOIS_MUL2( (b ^ c) );
-                s[i + 2U] ^= x ^ GALOIS_MUL2( (c ^ d) );
-                s[i + 3U] ^= y ^ GALOIS_MUL2( (d ^ a) );
+        MODA_AES_VPERM_EncryptMany(aes, out, in, n);
+    }
+    else
+#endif
+    {
+#if defined(MODA_AES_BITSLICE)
+        MODA_AES_BitsliceEncryptMany(aes, out, in, n);
+#elif defined(MODA_AES_SBOX_COMPUTED) && !defined(MODA_AES_OTF)
+        size_t i;
+        size_t len;
+
+        for(i = 0U; i < n; i += len){
+
+            ASSERT((aes[i] != NULL))
+
+            /* neighbouring keys of the same size share a sliced state */
+            for(len = 1U; (len < MODA_SLICE_BLOCKS) && ((i + len) < n) && (aes[i + len]->r == aes[i]->r); len++){
             }
+
+            encryptKeyLanes(&aes[i], &out[i << 4U], &in[i << 4U], len);
         }
+#else
+        size_t i;
 
-        /* right shift row, reverse-sbox, add round key */
+        for(i = 0U; i < n; i++){
 
-        /* row 1 */
-        s[C1] = RSBOX( s[C1] ) ^ k[p];
-        s[C2] = RSBOX( s[C2] ) ^ k[p + C2];
-        s[C3] = RSBOX( s[C3] ) ^ k[p + C3];
-        s[C4] = RSBOX( s[C4] ) ^ k[p + C4];
-        
-        /* row 2, right shift 1 */
-        a = RSBOX( s[R2 + C4] ) ^ k[p + R2];
-        s[R2 + C4] = RSBOX( s[R2 + C3] ) ^ k[p + R2 + C4];
-        s[R2 + C3] = RSBOX( s[R2 + C2] ) ^ k[p + R2 + C3];
-        s[R2 + C2] = RSBOX( s[R2] ) ^ k[p + R2 + C2];
-        s[R2] = a;
-
-        /* row 3, right shift 2 */
-        a = RSBOX( s[R3     ] ) ^ k[p + R3 + C3];
-        b = RSBOX( s[R3 + C2] ) ^ k[p + R3 + C4];
-        s[R3     ] = RSBOX( s[R3 + C3] ) ^ k[p + R3];
-        s[R3 + C2] = RSBOX( s[R3 + C4] ) ^ k[p + R3 + C2];
-        s[R3 + C3] = a;
-        s[R3 + C4] = b;
-
-        /* row 4, right shift 3 */
-        a = RSBOX( s[R4] ) ^ k[p + R4 + C4];
-        s[R4     ] = RSBOX( s[R4 + C2] ) ^ k[p + R4];
-        s[R4 + C2] = RSBOX( s[R4 + C3] ) ^ k[p + R4 + C2];
-        s[R4 + C3] = RSBOX( s[R4 + C4] ) ^ k[p + R4 + C3];
-        s[R4 + C4] = a;
+            ASSERT((aes[i] != NULL))
 
-        p -= 16U;
+#if defined(MODA_AES_TABLES) && !defined(MODA_AES_UNROLL)
+            MODA_AES_TableEncrypt(aes[i], &out[i << 4U], &in[i << 4U]);
+#else
+            if(out != in){
+
+                (void)memcpy(&out[i << 4U], &in[i << 4U], AES_BLOCK_SIZE);
+            }
+
+#if defined(MODA_AES_OTF)
+            otfEncrypt(aes[i], &out[i << 4U], 1U);
+#else
+            encryptBlock(aes[i], &out[i << 4U]);
+#endif
+#endif
+        }
+#endif
+    }
+}
+
+void MODA_AES_DecryptBlocks(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in, size_t nblocks)
+{
+    ASSERT((aes != NULL))
+    ASSERT(((out != NULL) && (in != NULL)) || (nblocks == 0U))
+    ASSERT((aliasOk(out, in, nblocks)))
+
+#if defined(MODA_AES_NI)
+    if(MODA_CPU_HAS(MODA_CPU_AES)){
+
+        MODA_AES_NI_DecryptBlocks(aes, out, in, nblocks);
+    }
+    else
+#endif
+#if defined(MODA_AES_VPERM)
+    if(MODA_CPU_HAS(MODA_CPU_SSSE3)){
+
+        MODA_AES_VPERM_DecryptBlocks(aes, out, in, nblocks);
+    }
+    else
+#endif
+    {
+#if defined(MODA_AES_BITSLICE)
+        MODA_AES_BitsliceDecryptBlocks(aes, out, in, nblocks);
+#elif defined(MODA_AES_OTF)
+        size_t i;
+
+        if((out != in) && (nblocks > 0U)){
+
+            (void)memcpy(out, in, nblocks << 4U);
+        }
+
+        for(i = 0U; i < nblocks; i += OTF_BATCH){
+
+            otfDecrypt(aes, &out[i << 4U], ((nblocks - i) < OTF_BATCH) ? (nblocks - i) : OTF_BATCH);
+        }
+#elif defined(MODA_AES_SBOX_COMPUTED)
+        size_t i;
+
+        for(i = 0U; i < nblocks; i += MODA_SLICE_BLOCKS){
+
+            decryptLanes(aes, &out[i << 4U], &in[i << 4U], ((nblocks - i) < MODA_SLICE_BLOCKS) ? (nblocks - i) : MODA_SLICE_BLOCKS);
+        }
+#else
+        size_t i;
+
+        for(i = 0U; i < nblocks; i++){
+
+#if defined(MODA_AES_DECRYPT_SCHEDULE) && !defined(MODA_AES_UNROLL)
+            MODA_AES_TableDecrypt(aes, &out[i << 4U], &in[i << 4U]);
+#else
+            if(out != in){
+
+                (void)memcpy(&out[i << 4U], &in[i << 4U], AES_BLOCK_SIZE);
+            }
+
+            decryptBlock(aes, &out[i << 4U]);
+#endif
+        }
+#endif
+    }
+}
+
+#if defined(MODA_AES_UNROLL)
+
+void MODA_AES128_Init(struct aes_ctxt *aes, const uint8_t *key)
+{
+    ASSERT((aes != NULL))
+    ASSERT((key != NULL))
+
+    expandKey128(aes, key);
+
+#if defined(MODA_AES_SBOX_COMPUTED)
+    sliceSchedule(aes);
+#endif
+#if defined(MODA_AES_DECRYPT_SCHEDULE)
+    MODA_AES_TableInitDecrypt(aes);
+#endif
+}
+
+void MODA_AES128_Encrypt(const struct aes_ctxt *aes, uint8_t *s)
+{
+#if !defined(MODA_AES_TABLES) && !defined(MODA_AES_SBOX_COMPUTED)
+    const uint8_t *k = aes->k;
+#endif
+
+    ASSERT((aes != NULL))
+    ASSERT((aes->r == 10U))
+
+#if defined(MODA_AES_TABLES)
+    MODA_AES_TableEncrypt128(aes, s, s);
+#elif defined(MODA_AES_SBOX_COMPUTED)
+    encryptLanes(aes, s, s, 1U);
+#else
+    ENC_ROUND(s, k, 0U);
+    ENC_ROUND(s, k, 16U);
+    ENC_ROUND(s, k, 32U);
+    ENC_ROUND(s, k, 48U);
+    ENC_ROUND(s, k, 64U);
+    ENC_ROUND(s, k, 80U);
+    ENC_ROUND(s, k, 96U);
+    ENC_ROUND(s, k, 112U);
+    ENC_ROUND(s, k, 128U);
+    addSubShift(s, &k[144U]);
+    addRoundKey(s, &k[160U]);
+#endif
+}
+
+void MODA_AES128_Decrypt(const struct aes_ctxt *aes, uint8_t *s)
+{
+#if !defined(MODA_AES_DECRYPT_SCHEDULE) && !defined(MODA_AES_SBOX_COMPUTED)
+    const uint8_t *k = aes->k;
+#endif
+
+    ASSERT((aes != NULL))
+    ASSERT((aes->r == 10U))
+
+#if defined(MODA_AES_DECRYPT_SCHEDULE)
+    MODA_AES_TableDecrypt128(aes, s, s);
+#elif defined(MODA_AES_SBOX_COMPUTED)
+    decryptLanes(aes, s, s, 1U);
+#else
+    addRoundKey(s, &k[160U]);
+    invShiftSubAdd(s, &k[144U]);
+    DEC_ROUND(s, k, 128U);
+    DEC_ROUND(s, k, 112U);
+    DEC_ROUND(s, k, 96U);
+    DEC_ROUND(s, k, 80U);
+    DEC_ROUND(s, k, 64U);
+    DEC_ROUND(s, k, 48U);
+    DEC_ROUND(s, k, 32U);
+    DEC_ROUND(s, k, 16U);
+    DEC_ROUND(s, k, 0U);
+#endif
+}
+
+void MODA_AES192_Init(struct aes_ctxt *aes, const uint8_t *key)
+{
+    ASSERT((aes != NULL))
+    ASSERT((key != NULL))
+
+    expandKey192(aes, key);
+
+#if defined(MODA_AES_SBOX_COMPUTED)
+    sliceSchedule(aes);
+#endif
+#if defined(MODA_AES_DECRYPT_SCHEDULE)
+    MODA_AES_TableInitDecrypt(aes);
+#endif
+}
+
+void MODA_AES192_Encrypt(const struct aes_ctxt *aes, uint8_t *s)
+{
+#if !defined(MODA_AES_TABLES) && !defined(MODA_AES_SBOX_COMPUTED)
+    const uint8_t *k = aes->k;
+#endif
+
+    ASSERT((aes != NULL))
+    ASSERT((aes->r == 12U))
+
+#if defined(MODA_AES_TABLES)
+    MODA_AES_TableEncrypt192(aes, s, s);
+#elif defined(MODA_AES_SBOX_COMPUTED)
+    encryptLanes(aes, s, s, 1U);
+#else
+    ENC_ROUND(s, k, 0U);
+    ENC_ROUND(s, k, 16U);
+    ENC_ROUND(s, k, 32U);
+    ENC_ROUND(s, k, 48U);
+    ENC_ROUND(s, k, 64U);
+    ENC_ROUND(s, k, 80U);
+    ENC_ROUND(s, k, 96U);
+    ENC_ROUND(s, k, 112U);
+    ENC_ROUND(s, k, 128U);
+    ENC_ROUND(s, k, 144U);
+    ENC_ROUND(s, k, 160U);
+    addSubShift(s, &k[176U]);
+    addRoundKey(s, &k[192U]);
+#endif
+}
+
+void MODA_AES192_Decrypt(const struct aes_ctxt *aes, uint8_t *s)
+{
+#if !defined(MODA_AES_DECRYPT_SCHEDULE) && !defined(MODA_AES_SBOX_COMPUTED)
+    const uint8_t *k = aes->k;
+#endif
+
+    ASSERT((aes != NULL))
+    ASSERT((aes->r == 12U))
+
+#if defined(MODA_AES_DECRYPT_SCHEDULE)
+    MODA_AES_TableDecrypt192(aes, s, s);
+#elif defined(MODA_AES_SBOX_COMPUTED)
+    decryptLanes(aes, s, s, 1U);
+#else
+    addRoundKey(s, &k[192U]);
+    invShiftSubAdd(s, &k[176U]);
+    DEC_ROUND(s, k, 160U);
+    DEC_ROUND(s, k, 144U);
+    DEC_ROUND(s, k, 128U);
+    DEC_ROUND(s, k, 112U);
+    DEC_ROUND(s, k, 96U);
+    DEC_ROUND(s, k, 80U);
+    DEC_ROUND(s, k, 64U);
+    DEC_ROUND(s, k, 48U);
+    DEC_ROUND(s, k, 32U);
+    DEC_ROUND(s, k, 16U);
+    DEC_ROUND(s, k, 0U);
+#endif
+}
+
+void MODA_AES256_Init(struct aes_ctxt *aes, const uint8_t *key)
+{
+    ASSERT((aes != NULL))
+    ASSERT((key != NULL))
+
+    expandKey256(aes, key);
+
+#if defined(MODA_AES_SBOX_COMPUTED)
+    sliceSchedule(aes);
+#endif
+#if defined(MODA_AES_DECRYPT_SCHEDULE)
+    MODA_AES_TableInitDecrypt(aes);
+#endif
+}
+
+void MODA_AES256_Encrypt(const struct aes_ctxt *aes, uint8_t *s)
+{
+#if !defined(MODA_AES_TABLES) && !defined(MODA_AES_SBOX_COMPUTED)
+    const uint8_t *k = aes->k;
+#endif
+
+    ASSERT((aes != NULL))
+    ASSERT((aes->r == 14U))
+
+#if defined(MODA_AES_TABLES)
+    MODA_AES_TableEncrypt256(aes, s, s);
+#elif defined(MODA_AES_SBOX_COMPUTED)
+    encryptLanes(aes, s, s, 1U);
+#else
+    ENC_ROUND(s, k, 0U);
+    ENC_ROUND(s, k, 16U);
+    ENC_ROUND(s, k, 32U);
+    ENC_ROUND(s, k, 48U);
+    ENC_ROUND(s, k, 64U);
+    ENC_ROUND(s, k, 80U);
+    ENC_ROUND(s, k, 96U);
+    ENC_ROUND(s, k, 112U);
+    ENC_ROUND(s, k, 128U);
+    ENC_ROUND(s, k, 144U);
+    ENC_ROUND(s, k, 160U);
+    ENC_ROUND(s, k, 176U);
+    ENC_ROUND(s, k, 192U);
+    addSubShift(s, &k[208U]);
+    addRoundKey(s, &k[224U]);
+#endif
+}
+
+void MODA_AES256_Decrypt(const struct aes_ctxt *aes, uint8_t *s)
+{
+#if !defined(MODA_AES_DECRYPT_SCHEDULE) && !defined(MODA_AES_SBOX_COMPUTED)
+    const uint8_t *k = aes->k;
+#endif
+
+    ASSERT((aes != NULL))
+    ASSERT((aes->r == 14U))
+
+#if defined(MODA_AES_DECRYPT_SCHEDULE)
+    MODA_AES_TableDecrypt256(aes, s, s);
+#elif defined(MODA_AES_SBOX_COMPUTED)
+    decryptLanes(aes, s, s, 1U);
+#else
+    addRoundKey(s, &k[224U]);
+    invShiftSubAdd(s, &k[208U]);
+    DEC_ROUND(s, k, 192U);
+    DEC_ROUND(s, k, 176U);
+    DEC_ROUND(s, k, 160U);
+    DEC_ROUND(s, k, 144U);
+    DEC_ROUND(s, k, 128U);
+    DEC_ROUND(s, k, 112U);
+    DEC_ROUND(s, k, 96U);
+    DEC_ROUND(s, k, 80U);
+    DEC_ROUND(s, k, 64U);
+    DEC_ROUND(s, k, 48U);
+    DEC_ROUND(s, k, 32U);
+    DEC_ROUND(s, k, 16U);
+    DEC_ROUND(s, k, 0U);
+#endif
+}
+
+#endif
+
+/* static functions  **************************************************/
+
+#if !defined(MODA_AES_BITSLICE) && !defined(MODA_AES_OTF)
+
+#if defined(MODA_AES_UNROLL)
+
+static void expandKey(struct aes_ctxt *aes, enum aes_key_size keySize, const uint8_t *key)
+{
+    switch(keySize){
+    case AES_KEY_128:
+        expandKey128(aes, key);
+        break;
+
+    case AES_KEY_192:
+        expandKey192(aes, key);
+        break;
+
+    case AES_KEY_256:
+        expandKey256(aes, key);
+        break;
+
+    default:
+        /* impossible */
+        break;
+    }
+}
+
+static void expandKey128(struct aes_ctxt *aes, const uint8_t *key)
+{
+    uint8_t *k = aes->k;
+    uint8_t n;
+    uint8_t i = 1U;
+
+    (void)memcpy(k, key, (size_t)AES_KEY_128);
+    aes->r = 10U;
+
+    for(n = 4U; n < 44U; n += 4U){
+
+        KEY_CORE(k, n, 4U, i);
+        KEY_XOR(k, n + 1U, 4U);
+        KEY_XOR(k, n + 2U, 4U);
+        KEY_XOR(k, n + 3U, 4U);
+        i++;
+    }
+}
+
+static void expandKey192(struct aes_ctxt *aes, const uint8_t *key)
+{
+    uint8_t *k = aes->k;
+    uint8_t n;
+    uint8_t i = 1U;
+
+    (void)memcpy(k, key, (size_t)AES_KEY_192);
+    aes->r = 12U;
+
+    for(n = 6U; n < 48U; n += 6U){
+
+        KEY_CORE(k, n, 6U, i);
+        KEY_XOR(k, n + 1U, 6U);
+        KEY_XOR(k, n + 2U, 6U);
+        KEY_XOR(k, n + 3U, 6U);
+        KEY_XOR(k, n + 4U, 6U);
+        KEY_XOR(k, n + 5U, 6U);
+        i++;
+    }
+
+    /* only four more words are needed */
+    KEY_CORE(k, 48U, 6U, i);
+    KEY_XOR(k, 49U, 6U);
+    KEY_XOR(k, 50U, 6U);
+    KEY_XOR(k, 51U, 6U);
+}
+
+static void expandKey256(struct aes_ctxt *aes, const uint8_t *key)
+{
+    uint8_t *k = aes->k;
+    uint8_t n;
+    uint8_t i = 1U;
+
+    (void)memcpy(k, key, (size_t)AES_KEY_256);
+    aes->r = 14U;
+
+    for(n = 8U; n < 56U; n += 8U){
+
+        KEY_CORE(k, n, 8U, i);
+        KEY_XOR(k, n + 1U, 8U);
+        KEY_XOR(k, n + 2U, 8U);
+        KEY_XOR(k, n + 3U, 8U);
+        KEY_SUB(k, n + 4U, 8U);
+        KEY_XOR(k, n + 5U, 8U);
+        KEY_XOR(k, n + 6U, 8U);
+        KEY_XOR(k, n + 7U, 8U);
+        i++;
+    }
+
+    /* only four more words are needed */
+    KEY_CORE(k, 56U, 8U, i);
+    KEY_XOR(k, 57U, 8U);
+    KEY_XOR(k, 58U, 8U);
+    KEY_XOR(k, 59U, 8U);
+}
+
+#else
+
+static void expandKey(struct aes_ctxt *aes, enum aes_key_size keySize, const uint8_t *key)
+{
+    uint8_t *k = aes->k;
+    uint8_t nk = (uint8_t)keySize >> 2U;
+    uint8_t nw = 0U;
+    uint8_t n;
+    uint8_t j = 0U;
+    uint8_t i = 1U;
+
+    switch(keySize){
+    case AES_KEY_128:
+        aes->r = 10U;
+        nw = 44U;
+        break;
+
+    case AES_KEY_192:
+        aes->r = 12U;
+        nw = 52U;
+        break;
+
+    case AES_KEY_256:
+        aes->r = 14U;
+        nw = 60U;
+        break;         
+
+    default:
+        /* impossible */
+        break;
+    }
+
+    (void)memcpy(k, key, (size_t)keySize);
+
+    /* Rijndael key schedule */
+    for(n = nk; n < nw; n++){
+
+        if(j == 0U){
+
+            KEY_CORE(k, n, nk, i);
+            i++;
+        }
+        else if((nk == 8U) && (j == 4U)){
+
+            KEY_SUB(k, n, nk);
+        }
+        else{
+
+            KEY_XOR(k, n, nk);
+        }
+
+        j++;
+
+        if(j == nk){
+
+            j = 0U;
+        }
+    }
+}
+
+#endif
+
+#endif
+
+#if !defined(MODA_AES_BITSLICE) && !defined(MODA_AES_OTF)
+static void expandKeys(struct aes_ctxt *aes, enum aes_key_size keySize, const uint8_t *key, size_t n)
+{
+    uint8_t *k;
+#if defined(MODA_AES_SBOX_COMPUTED)
+    uint32_t w[INIT_LANES];
+#endif
+    uint8_t nk = (uint8_t)keySize >> 2U;
+    uint8_t nw = (nk + 7U) << 2U;
+    uint8_t i;
+    uint8_t j = 0U;
+    uint8_t rc = 1U;
+    size_t l;
+
+    for(l = 0U; l < n; l++){
+
+        aes[l].r = nk + 6U;
+        (void)memcpy(aes[l].k, &key[l * (size_t)keySize], (size_t)keySize);
+    }
+
+    /* the same step for every key keeps the lookups independent */
+    for(i = nk; i < nw; i++){
+
+#if defined(MODA_AES_SBOX_COMPUTED)
+        /* and lets one pass of the circuit do SubWord for every key */
+        if(j == 0U){
+
+            for(l = 0U; l < n; l++){
+
+                w[l] = loadWord(aes[l].k, i - 1U);
+                w[l] = ROT_WORD(w[l]);
+            }
+
+            MODA_AES_SubWords(w, n);
+
+            for(l = 0U; l < n; l++){
+
+                k = aes[l].k;
+                storeWord(k, i, w[l] ^ RCON_WORD(rc) ^ loadWord(k, i - nk));
+            }
+
+            rc++;
+        }
+        else if((nk == 8U) && (j == 4U)){
+
+            for(l = 0U; l < n; l++){
+
+                w[l] = loadWord(aes[l].k, i - 1U);
+            }
+
+            MODA_AES_SubWords(w, n);
+
+            for(l = 0U; l < n; l++){
+
+                k = aes[l].k;
+                storeWord(k, i, w[l] ^ loadWord(k, i - nk));
+            }
+        }
+#else
+        if(j == 0U){
+
+            for(l = 0U; l < n; l++){
+
+                k = aes[l].k;
+                KEY_CORE(k, i, nk, rc);
+            }
+
+            rc++;
+        }
+        else if((nk == 8U) && (j == 4U)){
+
+            for(l = 0U; l < n; l++){
+
+                k = aes[l].k;
+                KEY_SUB(k, i, nk);
+            }
+        }
+#endif
+        else{
+
+            for(l = 0U; l < n; l++){
+
+                k = aes[l].k;
+                KEY_XOR(k, i, nk);
+            }
+        }
+
+        j++;
+
+        if(j == nk){
+
+            j = 0U;
+        }
+    }
+}
+#endif
+
+#if !defined(MODA_AES_BITSLICE) && !defined(MODA_AES_OTF)
+static uint32_t loadWord(const uint8_t *k, uint8_t n)
+{
+    uint32_t w;
+
+    (void)memcpy(&w, &k[(uint32_t)n << 2U], sizeof(w));
+
+    return w;
+}
+
+static void storeWord(uint8_t *k, uint8_t n, uint32_t w)
+{
+    (void)memcpy(&k[(uint32_t)n << 2U], &w, sizeof(w));
+}
+#endif
+
+#if defined(MODA_AES_OTF)
+static void storeKey(struct aes_ctxt *aes, enum aes_key_size keySize, const uint8_t *key)
+{
+    (void)memcpy(aes->k, key, (size_t)keySize);
+    aes->r = ((uint8_t)keySize >> 2U) + 6U;
+}
+
+#if defined(MODA_AES_SBOX_COMPUTED)
+static void otfEncrypt(const struct aes_ctxt *aes, uint8_t *s, size_t n)
+{
+    uint8_t w[32U];
+    uint8_t rk[AES_BLOCK_SIZE];
+    moda_slice_t q[OTF_STATES << 3U];
+    moda_slice_t k[8U];
+    uint8_t nk = aes->r - 6U;
+    uint8_t top = nk;
+    uint8_t r;
+    size_t i;
+
+    (void)memcpy(w, aes->k, (size_t)nk << 2U);
+
+    for(i = 0U; i < n; i += MODA_SLICE_BLOCKS){
+
+        MODA_AES_SliceIn(&q[(i / MODA_SLICE_BLOCKS) << 3U], &s[i << 4U], ((n - i) < MODA_SLICE_BLOCKS) ? (n - i) : MODA_SLICE_BLOCKS);
+    }
+
+    for(r = 0U; r <= aes->r; r++){
+
+        otfRoundKey(rk, w, nk, &top, r);
+        MODA_AES_SliceKey(k, rk);
+
+        for(i = 0U; i < n; i += MODA_SLICE_BLOCKS){
+
+            if(r < aes->r){
+
+                /* final round has no mix columns */
+                MODA_AES_SlicedRound(&q[(i / MODA_SLICE_BLOCKS) << 3U], k, (r < (aes->r - 1U)));
+            }
+            else{
+
+                MODA_AES_SlicedAddRoundKey(&q[(i / MODA_SLICE_BLOCKS) << 3U], k);
+            }
+        }
+    }
+
+    for(i = 0U; i < n; i += MODA_SLICE_BLOCKS){
+
+        MODA_AES_SliceOut(&s[i << 4U], &q[(i / MODA_SLICE_BLOCKS) << 3U], ((n - i) < MODA_SLICE_BLOCKS) ? (n - i) : MODA_SLICE_BLOCKS);
+    }
+
+    (void)memset(q, 0, sizeof(q));
+    (void)memset(k, 0, sizeof(k));
+}
+
+static void otfDecrypt(const struct aes_ctxt *aes, uint8_t *s, size_t n)
+{
+    uint8_t w[32U];
+    uint8_t rk[AES_BLOCK_SIZE];
+    moda_slice_t q[OTF_STATES << 3U];
+    moda_slice_t k[8U];
+    uint8_t nk = aes->r - 6U;
+    uint8_t top = nk;
+    uint8_t r;
+    size_t i;
+
+    (void)memcpy(w, aes->k, (size_t)nk << 2U);
+
+    /* forward to the final round key, then backward from there */
+    otfRoundKey(rk, w, nk, &top, aes->r);
+    MODA_AES_SliceKey(k, rk);
+
+    for(i = 0U; i < n; i += MODA_SLICE_BLOCKS){
+
+        MODA_AES_SliceIn(&q[(i / MODA_SLICE_BLOCKS) << 3U], &s[i << 4U], ((n - i) < MODA_SLICE_BLOCKS) ? (n - i) : MODA_SLICE_BLOCKS);
+        MODA_AES_SlicedAddRoundKey(&q[(i / MODA_SLICE_BLOCKS) << 3U], k);
+    }
+
+    for(r = aes->r; r > 0U; r--){
+
+        otfRoundKey(rk, w, nk, &top, r - 1U);
+        MODA_AES_SliceKey(k, rk);
+
+        for(i = 0U; i < n; i += MODA_SLICE_BLOCKS){
+
+            /* first round has no inverse mix columns */
+            MODA_AES_SlicedInvRound(&q[(i / MODA_SLICE_BLOCKS) << 3U], k, (r < aes->r));
+        }
+    }
+
+    for(i = 0U; i < n; i += MODA_SLICE_BLOCKS){
+
+        MODA_AES_SliceOut(&s[i << 4U], &q[(i / MODA_SLICE_BLOCKS) << 3U], ((n - i) < MODA_SLICE_BLOCKS) ? (n - i) : MODA_SLICE_BLOCKS);
+    }
+
+    (void)memset(q, 0, sizeof(q));
+    (void)memset(k, 0, sizeof(k));
+}
+#else
+static void otfEncrypt(const struct aes_ctxt *aes, uint8_t *s, size_t n)
+{
+    uint8_t w[32U];
+    uint8_t rk[AES_BLOCK_SIZE];
+    uint8_t nk = aes->r - 6U;
+    uint8_t top = nk;
+    uint8_t r;
+    size_t i;
+
+    (void)memcpy(w, aes->k, (size_t)nk << 2U);
+
+    for(r = 0U; r < aes->r; r++){
+
+        otfRoundKey(rk, w, nk, &top, r);
+
+        for(i = 0U; i < n; i++){
+
+            addSubShift(&s[i << 4U], rk);
+
+            /* final round has no mix columns */
+            if(r < (aes->r - 1U)){
+
+                mixColumns(&s[i << 4U]);
+            }
+        }
+    }
+
+    otfRoundKey(rk, w, nk, &top, aes->r);
+
+    for(i = 0U; i < n; i++){
+
+        addRoundKey(&s[i << 4U], rk);
+    }
+}
+
+static void otfDecrypt(const struct aes_ctxt *aes, uint8_t *s, size_t n)
+{
+    uint8_t w[32U];
+    uint8_t rk[AES_BLOCK_SIZE];
+    uint8_t nk = aes->r - 6U;
+    uint8_t top = nk;
+    uint8_t r;
+    size_t i;
+
+    (void)memcpy(w, aes->k, (size_t)nk << 2U);
+
+    /* forward to the final round key, then backward from there */
+    otfRoundKey(rk, w, nk, &top, aes->r);
+
+    for(i = 0U; i < n; i++){
+
+        addRoundKey(&s[i << 4U], rk);
+    }
+
+    for(r = aes->r; r > 0U; r--){
+
+        otfRoundKey(rk, w, nk, &top, r - 1U);
+
+        for(i = 0U; i < n; i++){
+
+            /* first round has no inverse mix columns */
+            if(r < aes->r){
+
+                invMixColumns(&s[i << 4U]);
+            }
+
+            invShiftSubAdd(&s[i << 4U], rk);
+        }
+    }
+}
+#endif
+
+static void otfRoundKey(uint8_t *rk, uint8_t *w, uint8_t nk, uint8_t *top, uint8_t round)
+{
+    uint8_t first = round << 2U;
+    uint8_t slot;
+    uint8_t i;
+
+    while(*top < (first + 4U)){
+
+        otfKeyStep(w, nk, *top);
+        (*top)++;
+    }
+
+    while((*top - nk) > first){
+
+        (*top)--;
+        otfKeyStep(w, nk, *top);
+    }
+
+    slot = OTF_MOD(first, nk);
+
+    for(i = 0U; i < 4U; i++){
+
+        (void)memcpy(&rk[i << 2U], &w[slot << 2U], 4U);
+
+        slot++;
+
+        if(slot == nk){
+
+            slot = 0U;
+        }
+    }
+}
+
+static void otfKeyStep(uint8_t *w, uint8_t nk, uint8_t n)
+{
+    uint8_t j = OTF_MOD(n, nk);
+    uint8_t *q = &w[j << 2U];
+    const uint8_t *p = &w[((j == 0U) ? (nk - 1U) : (j - 1U)) << 2U];
+
+#if defined(MODA_AES_SBOX_COMPUTED)
+    uint32_t x;
+    uint32_t y;
+
+    if((j == 0U) || ((nk == 8U) && (j == 4U))){
+
+        (void)memcpy(&x, p, sizeof(x));
+        (void)memcpy(&y, q, sizeof(y));
+
+        if(j == 0U){
+
+            /* SubWord(RotWord(W[N-1])) ^ Rcon */
+            x = ROT_WORD(x);
+            MODA_AES_SubWords(&x, 1U);
+            y ^= x ^ RCON_WORD(OTF_DIV(n, nk));
+        }
+        else{
+
+            /* SubWord(W[N-1]) */
+            MODA_AES_SubWords(&x, 1U);
+            y ^= x;
+        }
+
+        (void)memcpy(q, &y, sizeof(y));
+    }
+#else
+    if(j == 0U){
+
+        /* SubWord(RotWord(W[N-1])) ^ Rcon */
+        q[0] ^= SBOX(p[1]) ^ RCON(OTF_DIV(n, nk));
+        q[1] ^= SBOX(p[2]);
+        q[2] ^= SBOX(p[3]);
+        q[3] ^= SBOX(p[0]);
+    }
+    else if((nk == 8U) && (j == 4U)){
+
+        /* SubWord(W[N-1]) */
+        q[0] ^= SBOX(p[0]);
+        q[1] ^= SBOX(p[1]);
+        q[2] ^= SBOX(p[2]);
+        q[3] ^= SBOX(p[3]);
+    }
+#endif
+    else{
+
+        q[0] ^= p[0];
+        q[1] ^= p[1];
+        q[2] ^= p[2];
+        q[3] ^= p[3];
+    }
+}
+#endif
+
+#if !defined(MODA_AES_BITSLICE) && !defined(MODA_AES_OTF) && (!defined(MODA_AES_TABLES) || defined(MODA_AES_UNROLL))
+static void encryptBlock(const struct aes_ctxt *aes, uint8_t *s)
+{
+#if defined(MODA_AES_UNROLL)
+    switch(aes->r){
+    case 10U:
+        MODA_AES128_Encrypt(aes, s);
+        break;
+
+    case 12U:
+        MODA_AES192_Encrypt(aes, s);
+        break;
+
+    default:
+        MODA_AES256_Encrypt(aes, s);
+        break;
+    }
+#elif defined(MODA_AES_SBOX_COMPUTED)
+    encryptLanes(aes, s, s, 1U);
+#else
+    uint8_t r;
+    const uint8_t *k = aes->k;
+
+    for(r = 1U; r < aes->r; r++){
+
+        addSubShift(s, k);
+        mixColumns(s);
+        k = &k[AES_BLOCK_SIZE];
+    }
+
+    /* final round has no mix columns */
+    addSubShift(s, k);
+    addRoundKey(s, &k[AES_BLOCK_SIZE]);
+#endif
+}
+#endif
+
+#if !defined(MODA_AES_BITSLICE) && !defined(MODA_AES_OTF) && (!defined(MODA_AES_DECRYPT_SCHEDULE) || defined(MODA_AES_UNROLL))
+static void decryptBlock(const struct aes_ctxt *aes, uint8_t *s)
+{
+#if defined(MODA_AES_UNROLL)
+    switch(aes->r){
+    case 10U:
+        MODA_AES128_Decrypt(aes, s);
+        break;
+
+    case 12U:
+        MODA_AES192_Decrypt(aes, s);
+        break;
+
+    default:
+        MODA_AES256_Decrypt(aes, s);
+        break;
+    }
+#elif defined(MODA_AES_SBOX_COMPUTED)
+    decryptLanes(aes, s, s, 1U);
+#else
+    uint8_t p = (uint8_t)(aes->r << 4U);
+
+    addRoundKey(s, &aes->k[p]);
+
+    /* first round has no inverse mix columns */
+    p -= 16U;
+    invShiftSubAdd(s, &aes->k[p]);
+
+    while(p > 0U){
+
+        p -= 16U;
+        invMixColumns(s);
+        invShiftSubAdd(s, &aes->k[p]);
+    }
+#endif
+}
+#endif
+
+#if !defined(MODA_AES_TABLES) && !defined(MODA_AES_BITSLICE) && !defined(MODA_AES_SBOX_COMPUTED)
+static void addSubShift(uint8_t *s, const uint8_t *k)
+{
+    uint8_t a;
+    uint8_t b;
+
+        /* row 1 */
+    s[C1] = SBOX( s[C1] ^ k[C1] );
+    s[C2] = SBOX( s[C2] ^ k[C2] );
+    s[C3] = SBOX( s[C3] ^ k[C3] );
+    s[C4] = SBOX( s[C4] ^ k[C4] );
+
+    /* row 2, left shift 1 */
+    a = SBOX( s[R2] ^ k[R2] );
+    s[R2     ] = SBOX( s[R2 + C2] ^ k[R2 + C2] );
+    s[R2 + C2] = SBOX( s[R2 + C3] ^ k[R2 + C3] );
+    s[R2 + C3] = SBOX( s[R2 + C4] ^ k[R2 + C4] );
+    s[R2 + C4] = a;
+
+    /* row 3, left shift 2 */
+    a = SBOX( s[R3     ] ^ k[R3] );
+    b = SBOX( s[R3 + C2] ^ k[R3 + C2] );
+    s[R3     ] = SBOX( s[R3 + C3] ^ k[R3 + C3] );
+    s[R3 + C2] = SBOX( s[R3 + C4] ^ k[R3 + C4] );
+    s[R3 + C3] = a;
+    s[R3 + C4] = b;
+
+    /* row 4, left shift 3 */
+    a = SBOX( s[R4 + C4] ^ k[R4 + C4] );
+    s[R4 + C4] = SBOX( s[R4 + C3] ^ k[R4 + C3] );
+    s[R4 + C3] = SBOX( s[R4 + C2] ^ k[R4 + C2] );
+    s[R4 + C2] = SBOX( s[R4     ] ^ k[R4     ] );
+    s[R4     ] = a;
+}
+
+static void mixColumns(uint8_t *s)
+{
+    uint8_t a;
+    uint8_t b;
+    uint8_t c;
+    uint8_t d;
+    uint8_t i;
+
+    for(i=0U; i < 16U; i += 4U){
+
+        a = s[i     ];
+        b = s[i + 1U];
+        c = s[i + 2U];
+        d = s[i + 3U];
+
+        /* 2a + 3b + 1c + 1d 
+         * 1a + 2b + 3c + 1d
+         * 1a + 1b + 2c + 3d
+         * 3a + 1b + 1c + 2d
+         *
+         * */
+        s[i     ] ^= (a ^ b ^ c ^ d) ^ GALOIS_MUL2( (a ^ b) );
+        s[i + 1U] ^= (a ^ b ^ c ^ d) ^ GALOIS_MUL2( (b ^ c) );
+        s[i + 2U] ^= (a ^ b ^ c ^ d) ^ GALOIS_MUL2( (c ^ d) );
+        s[i + 3U] ^= (a ^ b ^ c ^ d) ^ GALOIS_MUL2( (d ^ a) );
+    }
+}
+#endif
+
+#if !defined(MODA_AES_DECRYPT_SCHEDULE) && !defined(MODA_AES_BITSLICE) && !defined(MODA_AES_SBOX_COMPUTED)
+static void invShiftSubAdd(uint8_t *s, const uint8_t *k)
+{
+    uint8_t a;
+    uint8_t b;
+
+        /* row 1 */
+    s[C1] = RSBOX( s[C1] ) ^ k[C1];
+    s[C2] = RSBOX( s[C2] ) ^ k[C2];
+    s[C3] = RSBOX( s[C3] ) ^ k[C3];
+    s[C4] = RSBOX( s[C4] ) ^ k[C4];
+    
+    /* row 2, right shift 1 */
+    a = RSBOX( s[R2 + C4] ) ^ k[R2];
+    s[R2 + C4] = RSBOX( s[R2 + C3] ) ^ k[R2 + C4];
+    s[R2 + C3] = RSBOX( s[R2 + C2] ) ^ k[R2 + C3];
+    s[R2 + C2] = RSBOX( s[R2] ) ^ k[R2 + C2];
+    s[R2] = a;
+
+    /* row 3, right shift 2 */
+    a = RSBOX( s[R3     ] ) ^ k[R3 + C3];
+    b = RSBOX( s[R3 + C2] ) ^ k[R3 + C4];
+    s[R3     ] = RSBOX( s[R3 + C3] ) ^ k[R3];
+    s[R3 + C2] = RSBOX( s[R3 + C4] ) ^ k[R3 + C2];
+    s[R3 + C3] = a;
+    s[R3 + C4] = b;
+
+    /* row 4, right shift 3 */
+    a = RSBOX( s[R4] ) ^ k[R4 + C4];
+    s[R4     ] = RSBOX( s[R4 + C2] ) ^ k[R4];
+    s[R4 + C2] = RSBOX( s[R4 + C3] ) ^ k[R4 + C2];
+    s[R4 + C3] = RSBOX( s[R4 + C4] ) ^ k[R4 + C3];
+    s[R4 + C4] = a;
+}
+
+static void invMixColumns(uint8_t *s)
+{
+    uint8_t a;
+    uint8_t b;
+    uint8_t c;
+    uint8_t d;
+    uint8_t e;
+    uint8_t x;
+    uint8_t y;
+    uint8_t i;
+
+    for(i=0U; i < 16U; i += 4U){
+
+        a = s[i     ];
+        b = s[i + 1U];
+        c = s[i + 2U];
+        d = s[i + 3U];
+
+        /* 2a + 2b + 2c + 2d */
+        e = GALOIS_MUL2( (a ^ b ^ c ^ d) );
+
+        /* 13a + 9b + 13c + 9d */
+        x = GALOIS_MUL2( (e ^ a ^ c) );                
+        x = (a ^ b ^ c ^ d) ^ GALOIS_MUL2( x );
+
+        /* 9a + 13b + 9c + 13d */
+        y = GALOIS_MUL2( (e ^ b ^ d) );                
+        y = (a ^ b ^ c ^ d) ^ GALOIS_MUL2( y );
+        
+        /* 14a + 11b + 13c + 9d
+         * 9a + 14b + 11c + 13d
+         * 13a + 9b + 14c + 11d
+         * 11a + 13b + 9c + 14d
+         *
+         * */
+        s[i     ] ^= x ^ GALOIS_MUL2( (a ^ b) );
+        s[i + 1U] ^= y ^ GALOIS_MUL2( (b ^ c) );
+        s[i + 2U] ^= x ^ GALOIS_MUL2( (c ^ d) );
+        s[i + 3U] ^= y ^ GALOIS_MUL2( (d ^ a) );
+    }
+}
+
+static void addRoundKey(uint8_t *s, const uint8_t *k)
+{
+    uint8_t i;
+
+    for(i=0U; i < 16U; i++){
+
+        s[i] ^= k[i];
+    }
+}
+#endif
+
+#if defined(MODA_AES_SBOX_COMPUTED) && !defined(MODA_AES_OTF)
+static void sliceSchedule(struct aes_ctxt *aes)
+{
+    uint8_t r;
+
+    for(r = 0U; r <= aes->r; r++){
+
+        MODA_AES_SliceKey(&aes->sk[r << 3U], &aes->k[r << 4U]);
+    }
+}
+
+static void encryptLanes(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in, size_t n)
+{
+    moda_slice_t q[8U];
+    uint8_t r;
+
+    MODA_AES_SliceIn(q, in, n);
+
+    for(r = 1U; r <= aes->r; r++){
+
+        /* final round has no mix columns */
+        MODA_AES_SlicedRound(q, &aes->sk[(r - 1U) << 3U], (r < aes->r));
+    }
+
+    MODA_AES_SlicedAddRoundKey(q, &aes->sk[aes->r << 3U]);
+
+    MODA_AES_SliceOut(out, q, n);
+
+    (void)memset(q, 0, sizeof(q));
+}
+
+static void encryptKeyLanes(const struct aes_ctxt *const *aes, uint8_t *out, const uint8_t *in, size_t n)
+{
+    moda_slice_t q[8U];
+    moda_slice_t k[8U];
+    /* bits 0 to 3 of every row (4 * MODA_SLICE_BLOCKS bits), the first block */
+    const moda_slice_t first = ((moda_slice_t)~(moda_slice_t)0U / (((moda_slice_t)1U << (MODA_SLICE_BLOCKS << 2U)) - 1U)) * 0x0FU;
+    uint8_t r;
+    uint8_t b;
+    size_t l;
+
+    MODA_AES_SliceIn(q, in, n);
+
+    for(r = 0U; r <= aes[0]->r; r++){
+
+        /* block L takes bits 4L to 4L+3 of every row from key L */
+        (void)memset(k, 0, sizeof(k));
+
+        for(l = 0U; l < n; l++){
+
+            for(b = 0U; b < 8U; b++){
+
+                k[b] |= aes[l]->sk[((size_t)r << 3U) + b] & (first << (l << 2U));
+            }
+        }
+
+        if(r < aes[0]->r){
+
+            /* final round has no mix columns */
+            MODA_AES_SlicedRound(q, k, (r < (aes[0]->r - 1U)));
+        }
+        else{
+
+            MODA_AES_SlicedAddRoundKey(q, k);
+        }
+    }
+
+    MODA_AES_SliceOut(out, q, n);
+
+    (void)memset(q, 0, sizeof(q));
+    (void)memset(k, 0, sizeof(k));
+}
+
+static void decryptLanes(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in, size_t n)
+{
+    moda_slice_t q[8U];
+    uint8_t r;
+
+    MODA_AES_SliceIn(q, in, n);
+
+    MODA_AES_SlicedAddRoundKey(q, &aes->sk[aes->r << 3U]);
+
+    for(r = aes->r; r > 0U; r--){
+
+        /* first round has no inverse mix columns */
+        MODA_AES_SlicedInvRound(q, &aes->sk[(r - 1U) << 3U], (r < aes->r));
     }
+
+    MODA_AES_SliceOut(out, q, n);
+
+    (void)memset(q, 0, sizeof(q));
+}
+#endif
+
+#ifndef NDEBUG
+static bool aliasOk(const uint8_t *out, const uint8_t *in, size_t nblocks)
+{
+    uintptr_t o = (uintptr_t)out;
+    uintptr_t i = (uintptr_t)in;
+    uintptr_t len = (uintptr_t)nblocks * AES_BLOCK_SIZE;
+
+    return (o == i) || ((o + len) <= i) || ((i + len) <= o);
 }
+#endif
@@ -0,0 +1,686 @@
+/* Copyright (c) 2013-2016 Cameron Harper
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * */
+
+/* includes ***********************************************************/
+
+#include "aes.h"
+#include "moda_internal.h"
+
+#if defined(MODA_AES_BITSLICE)
+
+#include <string.h>
+
+/* defines ************************************************************/
+
+/* blocks held by one slice of eight words */
+#define SLICE_BLOCKS 4U
+
+/* blocks processed per iteration of the multi-block functions (two slices) */
+#define LANES 8U
+
+/* key schedules expanded in lockstep by MODA_AES_BitsliceInitMany() (one word each per slice) */
+#define KEY_LANES 16U
+
+#define ROTR16(X) (((X) >> 16U) | ((X) << 48U))
+#define ROTR32(X) (((X) << 32U) | ((X) >> 32U))
+
+/* static function prototypes *****************************************/
+
+/**
+ * Spread one block (four little endian words) over two words
+ *
+ * @param[out] q0
+ * @param[out] q1
+ * @param[in] w four words
+ *
+ * */
+static void interleaveIn(uint64_t *q0, uint64_t *q1, const uint32_t *w);
+
+/**
+ * Inverse of interleaveIn()
+ *
+ * @param[out] w four words
+ * @param[in] q0
+ * @param[in] q1
+ *
+ * */
+static void interleaveOut(uint32_t *w, uint64_t q0, uint64_t q1);
+
+static void addRoundKey(uint64_t *q, const uint64_t *sk);
+static void shiftRows(uint64_t *q);
+static void invShiftRows(uint64_t *q);
+static void mixColumns(uint64_t *q);
+static void invMixColumns(uint64_t *q);
+
+/**
+ * SubWord on #KEY_LANES words with a single pass of the circuit
+ *
+ * @param[in/out] t #KEY_LANES words
+ *
+ * */
+static void subWords(uint32_t *t);
+
+/**
+ * Store a word schedule as the byte and compressed bitsliced schedules
+ *
+ * @param[out] aes context (r already set)
+ * @param[in] w (r + 1) * 4 words
+ *
+ * */
+static void storeSchedule(struct aes_ctxt *aes, const uint32_t *w);
+
+/**
+ * Expand the compressed key held in the context
+ *
+ * @param[in] aes context
+ * @param[out] sk (r + 1) * 8 words
+ *
+ * */
+static void expandKey(const struct aes_ctxt *aes, uint64_t *sk);
+
+/**
+ * Encrypt one slice (four blocks)
+ *
+ * @param[in] r number of rounds
+ * @param[in] sk expanded bitsliced key
+ * @param[in/out] q eight words
+ *
+ * */
+static void encrypt(uint8_t r, const uint64_t *sk, uint64_t *q);
+
+/**
+ * Decrypt one slice (four blocks)
+ *
+ * @param[in] r number of rounds
+ * @param[in] sk expanded bitsliced key
+ * @param[in/out] q eight words
+ *
+ * */
+static void decrypt(uint8_t r, const uint64_t *sk, uint64_t *q);
+
+/**
+ * Load up to #LANES blocks into two slices (missing blocks are zero)
+ *
+ * @param[out] q sixteen words
+ * @param[in] in blocks
+ * @param[in] n number of blocks (1..#LANES)
+ *
+ * */
+static void load(uint64_t *q, const uint8_t *in, size_t n);
+
+/**
+ * Store up to #LANES blocks from two slices
+ *
+ * @param[out] out blocks
+ * @param[in] q sixteen words
+ * @param[in] n number of blocks (1..#LANES)
+ *
+ * */
+static void store(uint8_t *out, uint64_t *q, size_t n);
+
+static uint32_t dec32le(const uint8_t *b);
+static void enc32le(uint8_t *b, uint32_t w);
+
+/* functions **********************************************************/
+
+void MODA_AES_BitsliceInit(struct aes_ctxt *aes, enum aes_key_size keySize, const uint8_t *key)
+{
+    MODA_AES_BitsliceInitMany(aes, keySize, key, 1U);
+}
+
+void MODA_AES_BitsliceInitMany(struct aes_ctxt *aes, enum aes_key_size keySize, const uint8_t *key, size_t n)
+{
+    MODA_CONST_PRE static const uint8_t rcon[] MODA_CONST_POST = {
+        0x01U, 0x02U, 0x04U, 0x08U, 0x10U, 0x20U, 0x40U, 0x80U, 0x1bU, 0x36U
+    };
+    uint32_t w[KEY_LANES][60U];
+    uint32_t t[KEY_LANES];
+    uint8_t nk = (uint8_t)keySize >> 2U;
+    uint8_t nw = (nk + 7U) << 2U;
+    uint8_t i;
+    uint8_t j;
+    uint8_t k;
+    size_t l;
+    size_t m;
+    size_t g;
+
+    (void)memset(t, 0, sizeof(t));
+
+    for(g = 0U; g < n; g += KEY_LANES){
+
+        m = ((n - g) < KEY_LANES) ? (n - g) : KEY_LANES;
+
+        for(l = 0U; l < m; l++){
+
+            for(i = 0U; i < nk; i++){
+
+                w[l][i] = dec32le(&key[((g + l) * (size_t)keySize) + ((size_t)i << 2U)]);
+            }
+        }
+
+        j = 0U;
+        k = 0U;
+
+        /* the schedules share their structure so SubWord is done for all lanes at once */
+        for(i = nk; i < nw; i++){
+
+            for(l = 0U; l < m; l++){
+
+                t[l] = w[l][i - 1U];
+            }
+
+            if(j == 0U){
+
+                /* little endian words so RotWord is a right rotate */
+                for(l = 0U; l < m; l++){
+
+                    t[l] = (t[l] << 24U) | (t[l] >> 8U);
+                }
+
+                subWords(t);
+
+                for(l = 0U; l < m; l++){
+
+                    t[l] ^= rcon[k];
+                }
+            }
+            else if((nk > 6U) && (j == 4U)){
+
+                subWords(t);
+            }
+            else{
+
+                /* no substitution */
+            }
+
+            for(l = 0U; l < m; l++){
+
+                w[l][i] = t[l] ^ w[l][i - nk];
+            }
+
+            j++;
+
+            if(j == nk){
+
+                j = 0U;
+                k++;
+            }
+        }
+
+        for(l = 0U; l < m; l++){
+
+            aes[g + l].r = nk + 6U;
+            storeSchedule(&aes[g + l], w[l]);
+        }
+    }
+
+    (void)memset(w, 0, sizeof(w));
+    (void)memset(t, 0, sizeof(t));
+}
+
+void MODA_AES_BitsliceEncrypt(const struct aes_ctxt *aes, uint8_t *s)
+{
+    MODA_AES_BitsliceEncryptBlocks(aes, s, s, 1U);
+}
+
+void MODA_AES_BitsliceDecrypt(const struct aes_ctxt *aes, uint8_t *s)
+{
+    MODA_AES_BitsliceDecryptBlocks(aes, s, s, 1U);
+}
+
+void MODA_AES_BitsliceEncryptBlocks(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in, size_t n)
+{
+    uint64_t sk[120U];
+    uint64_t q[16U];
+    size_t i;
+    size_t len;
+
+    expandKey(aes, sk);
+
+    for(i = 0U; i < n; i += LANES){
+
+        len = ((n - i) < LANES) ? (n - i) : LANES;
+
+        load(q, &in[i << 4U], len);
+
+        encrypt(aes->r, sk, q);
+
+        if(len > SLICE_BLOCKS){
+
+            encrypt(aes->r, sk, &q[8U]);
+        }
+
+        store(&out[i << 4U], q, len);
+    }
+
+    (void)memset(sk, 0, sizeof(sk));
+    (void)memset(q, 0, sizeof(q));
+}
+
+void MODA_AES_BitsliceEncryptMany(const struct aes_ctxt *const *aes, uint8_t *out, const uint8_t *in, size_t n)
+{
+    uint64_t sk[2U][120U];
+    uint64_t q[16U];
+    uint8_t rk[LANES * AES_BLOCK_SIZE];
+    uint8_t r;
+    uint8_t j;
+    size_t i;
+    size_t l;
+    size_t len;
+
+    for(i = 0U; i < n; i += len){
+
+        r = aes[i]->r;
+
+        /* neighbouring keys of the same size share a pass */
+        for(len = 1U; (len < LANES) && ((i + len) < n) && (aes[i + len]->r == r); len++){
+        }
+
+        /* round j of every lane is loaded like a block, giving one bitsliced round key per slice */
+        for(j = 0U; j <= r; j++){
+
+            for(l = 0U; l < len; l++){
+
+                (void)memcpy(&rk[l << 4U], &aes[i + l]->k[j << 4U], AES_BLOCK_SIZE);
+            }
+
+            load(q, rk, len);
+
+            (void)memcpy(&sk[0U][j << 3U], q, 8U * sizeof(*q));
+            (void)memcpy(&sk[1U][j << 3U], &q[8U], 8U * sizeof(*q));
+        }
+
+        load(q, &in[i << 4U], len);
+
+        encrypt(r, sk[0U], q);
+
+        if(len > SLICE_BLOCKS){
+
+            encrypt(r, sk[1U], &q[8U]);
+        }
+
+        store(&out[i << 4U], q, len);
+    }
+
+    (void)memset(sk, 0, sizeof(sk));
+    (void)memset(q, 0, sizeof(q));
+    (void)memset(rk, 0, sizeof(rk));
+}
+
+void MODA_AES_BitsliceDecryptBlocks(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in, size_t n)
+{
+    uint64_t sk[120U];
+    uint64_t q[16U];
+    size_t i;
+    size_t len;
+
+    expandKey(aes, sk);
+
+    for(i = 0U; i < n; i += LANES){
+
+        len = ((n - i) < LANES) ? (n - i) : LANES;
+
+        load(q, &in[i << 4U], len);
+
+        decrypt(aes->r, sk, q);
+
+        if(len > SLICE_BLOCKS){
+
+            decrypt(aes->r, sk, &q[8U]);
+        }
+
+        store(&out[i << 4U], q, len);
+    }
+
+    (void)memset(sk, 0, sizeof(sk));
+    (void)memset(q, 0, sizeof(q));
+}
+
+/* static functions  **************************************************/
+
+static void interleaveIn(uint64_t *q0, uint64_t *q1, const uint32_t *w)
+{
+    uint64_t x0 = w[0];
+    uint64_t x1 = w[1];
+    uint64_t x2 = w[2];
+    uint64_t x3 = w[3];
+
+    x0 |= (x0 << 16U);
+    x1 |= (x1 << 16U);
+    x2 |= (x2 << 16U);
+    x3 |= (x3 << 16U);
+    x0 &= 0x0000FFFF0000FFFFU;
+    x1 &= 0x0000FFFF0000FFFFU;
+    x2 &= 0x0000FFFF0000FFFFU;
+    x3 &= 0x0000FFFF0000FFFFU;
+    x0 |= (x0 << 8U);
+    x1 |= (x1 << 8U);
+    x2 |= (x2 << 8U);
+    x3 |= (x3 << 8U);
+    x0 &= 0x00FF00FF00FF00FFU;
+    x1 &= 0x00FF00FF00FF00FFU;
+    x2 &= 0x00FF00FF00FF00FFU;
+    x3 &= 0x00FF00FF00FF00FFU;
+
+    *q0 = x0 | (x2 << 8U);
+    *q1 = x1 | (x3 << 8U);
+}
+
+static void interleaveOut(uint32_t *w, uint64_t q0, uint64_t q1)
+{
+    uint64_t x0 = q0 & 0x00FF00FF00FF00FFU;
+    uint64_t x1 = q1 & 0x00FF00FF00FF00FFU;
+    uint64_t x2 = (q0 >> 8U) & 0x00FF00FF00FF00FFU;
+    uint64_t x3 = (q1 >> 8U) & 0x00FF00FF00FF00FFU;
+
+    x0 |= (x0 >> 8U);
+    x1 |= (x1 >> 8U);
+    x2 |= (x2 >> 8U);
+    x3 |= (x3 >> 8U);
+    x0 &= 0x0000FFFF0000FFFFU;
+    x1 &= 0x0000FFFF0000FFFFU;
+    x2 &= 0x0000FFFF0000FFFFU;
+    x3 &= 0x0000FFFF0000FFFFU;
+
+    w[0] = (uint32_t)x0 | (uint32_t)(x0 >> 16U);
+    w[1] = (uint32_t)x1 | (uint32_t)(x1 >> 16U);
+    w[2] = (uint32_t)x2 | (uint32_t)(x2 >> 16U);
+    w[3] = (uint32_t)x3 | (uint32_t)(x3 >> 16U);
+}
+
+static void addRoundKey(uint64_t *q, const uint64_t *sk)
+{
+    q[0] ^= sk[0];
+    q[1] ^= sk[1];
+    q[2] ^= sk[2];
+    q[3] ^= sk[3];
+    q[4] ^= sk[4];
+    q[5] ^= sk[5];
+    q[6] ^= sk[6];
+    q[7] ^= sk[7];
+}
+
+static void shiftRows(uint64_t *q)
+{
+    uint64_t x;
+    uint8_t i;
+
+    for(i = 0U; i < 8U; i++){
+
+        x = q[i];
+        q[i] = (x & 0x000000000000FFFFU)
+            | ((x & 0x00000000FFF00000U) >> 4U)
+            | ((x & 0x00000000000F0000U) << 12U)
+            | ((x & 0x0000FF0000000000U) >> 8U)
+            | ((x & 0x000000FF00000000U) << 8U)
+            | ((x & 0xF000000000000000U) >> 12U)
+            | ((x & 0x0FFF000000000000U) << 4U);
+    }
+}
+
+static void invShiftRows(uint64_t *q)
+{
+    uint64_t x;
+    uint8_t i;
+
+    for(i = 0U; i < 8U; i++){
+
+        x = q[i];
+        q[i] = (x & 0x000000000000FFFFU)
+            | ((x & 0x000000000FFF0000U) << 4U)
+            | ((x & 0x00000000F0000000U) >> 12U)
+            | ((x & 0x000000FF00000000U) << 8U)
+            | ((x & 0x0000FF0000000000U) >> 8U)
+            | ((x & 0x000F000000000000U) << 12U)
+            | ((x & 0xFFF0000000000000U) >> 4U);
+    }
+}
+
+static void mixColumns(uint64_t *q)
+{
+    uint64_t q0 = q[0];
+    uint64_t q1 = q[1];
+    uint64_t q2 = q[2];
+    uint64_t q3 = q[3];
+    uint64_t q4 = q[4];
+    uint64_t q5 = q[5];
+    uint64_t q6 = q[6];
+    uint64_t q7 = q[7];
+    uint64_t r0 = ROTR16(q0);
+    uint64_t r1 = ROTR16(q1);
+    uint64_t r2 = ROTR16(q2);
+    uint64_t r3 = ROTR16(q3);
+    uint64_t r4 = ROTR16(q4);
+    uint64_t r5 = ROTR16(q5);
+    uint64_t r6 = ROTR16(q6);
+    uint64_t r7 = ROTR16(q7);
+
+    q[0] = q7 ^ r7 ^ r0 ^ ROTR32(q0 ^ r0);
+    q[1] = q0 ^ r0 ^ q7 ^ r7 ^ r1 ^ ROTR32(q1 ^ r1);
+    q[2] = q1 ^ r1 ^ r2 ^ ROTR32(q2 ^ r2);
+    q[3] = q2 ^ r2 ^ q7 ^ r7 ^ r3 ^ ROTR32(q3 ^ r3);
+    q[4] = q3 ^ r3 ^ q7 ^ r7 ^ r4 ^ ROTR32(q4 ^ r4);
+    q[5] = q4 ^ r4 ^ r5 ^ ROTR32(q5 ^ r5);
+    q[6] = q5 ^ r5 ^ r6 ^ ROTR32(q6 ^ r6);
+    q[7] = q6 ^ r6 ^ r7 ^ ROTR32(q7 ^ r7);
+}
+
+static void invMixColumns(uint64_t *q)
+{
+    uint64_t q0 = q[0];
+    uint64_t q1 = q[1];
+    uint64_t q2 = q[2];
+    uint64_t q3 = q[3];
+    uint64_t q4 = q[4];
+    uint64_t q5 = q[5];
+    uint64_t q6 = q[6];
+    uint64_t q7 = q[7];
+    uint64_t r0 = ROTR16(q0);
+    uint64_t r1 = ROTR16(q1);
+    uint64_t r2 = ROTR16(q2);
+    uint64_t r3 = ROTR16(q3);
+    uint64_t r4 = ROTR16(q4);
+    uint64_t r5 = ROTR16(q5);
+    uint64_t r6 = ROTR16(q6);
+    uint64_t r7 = ROTR16(q7);
+
+    q[0] = q5 ^ q6 ^ q7 ^ r0 ^ r5 ^ r7 ^ ROTR32(q0 ^ q5 ^ q6 ^ r0 ^ r5);
+    q[1] = q0 ^ q5 ^ r0 ^ r1 ^ r5 ^ r6 ^ r7 ^ ROTR32(q1 ^ q5 ^ q7 ^ r1 ^ r5 ^ r6);
+    q[2] = q0 ^ q1 ^ q6 ^ r1 ^ r2 ^ r6 ^ r7 ^ ROTR32(q0 ^ q2 ^ q6 ^ r2 ^ r6 ^ r7);
+    q[3] = q0 ^ q1 ^ q2 ^ q5 ^ q6 ^ r0 ^ r2 ^ r3 ^ r5 ^ ROTR32(q0 ^ q1 ^ q3 ^ q5 ^ q6 ^ q7 ^ r0 ^ r3 ^ r5 ^ r7);
+    q[4] = q1 ^ q2 ^ q3 ^ q5 ^ r1 ^ r3 ^ r4 ^ r5 ^ r6 ^ r7 ^ ROTR32(q1 ^ q2 ^ q4 ^ q5 ^ q7 ^ r1 ^ r4 ^ r5 ^ r6);
+    q[5] = q2 ^ q3 ^ q4 ^ q6 ^ r2 ^ r4 ^ r5 ^ r6 ^ r7 ^ ROTR32(q2 ^ q3 ^ q5 ^ q6 ^ r2 ^ r5 ^ r6 ^ r7);
+    q[6] = q3 ^ q4 ^ q5 ^ q7 ^ r3 ^ r5 ^ r6 ^ r7 ^ ROTR32(q3 ^ q4 ^ q6 ^ q7 ^ r3 ^ r6 ^ r7);
+    q[7] = q4 ^ q5 ^ q6 ^ r4 ^ r6 ^ r7 ^ ROTR32(q4 ^ q5 ^ q7 ^ r4 ^ r7);
+}
+
+static void subWords(uint32_t *t)
+{
+    uint64_t q[8U];
+    uint8_t i;
+
+    for(i = 0U; i < 8U; i++){
+
+        q[i] = (uint64_t)t[i << 1U] | ((uint64_t)t[(i << 1U) + 1U] << 32U);
+    }
+
+    MODA_AES_Ortho(q);
+    MODA_AES_Sbox(q);
+    MODA_AES_Ortho(q);
+
+    for(i = 0U; i < 8U; i++){
+
+        t[i << 1U] = (uint32_t)q[i];
+        t[(i << 1U) + 1U] = (uint32_t)(q[i] >> 32U);
+    }
+
+    (void)memset(q, 0, sizeof(q));
+}
+
+static void storeSchedule(struct aes_ctxt *aes, const uint32_t *w)
+{
+    uint64_t q[8U];
+    uint8_t nw = (aes->r + 1U) << 2U;
+    uint8_t i;
+
+    for(i = 0U; i < nw; i++){
+
+        enc32le(&aes->k[i << 2U], w[i]);
+    }
+
+    /* every lane uses the same key so each round key compresses to two words */
+    for(i = 0U; i < nw; i += 4U){
+
+        interleaveIn(&q[0], &q[4], &w[i]);
+        q[1] = q[0];
+        q[2] = q[0];
+        q[3] = q[0];
+        q[5] = q[4];
+        q[6] = q[4];
+        q[7] = q[4];
+        MODA_AES_Ortho(q);
+
+        aes->sk[(i >> 1U)] = (q[0] & 0x1111111111111111U) | (q[1] & 0x2222222222222222U) | (q[2] & 0x4444444444444444U) | (q[3] & 0x8888888888888888U);
+        aes->sk[(i >> 1U) + 1U] = (q[4] & 0x1111111111111111U) | (q[5] & 0x2222222222222222U) | (q[6] & 0x4444444444444444U) | (q[7] & 0x8888888888888888U);
+    }
+
+    (void)memset(q, 0, sizeof(q));
+}
+
+static void expandKey(const struct aes_ctxt *aes, uint64_t *sk)
+{
+    uint64_t x0;
+    uint64_t x1;
+    uint64_t x2;
+    uint64_t x3;
+    uint8_t i;
+
+    /* replicate each compressed bit over the four lanes of its nibble */
+    for(i = 0U; i < ((aes->r + 1U) << 1U); i++){
+
+        x0 = aes->sk[i] & 0x1111111111111111U;
+        x1 = (aes->sk[i] & 0x2222222222222222U) >> 1U;
+        x2 = (aes->sk[i] & 0x4444444444444444U) >> 2U;
+        x3 = (aes->sk[i] & 0x8888888888888888U) >> 3U;
+
+        sk[(i << 2U)] = (x0 << 4U) - x0;
+        sk[(i << 2U) + 1U] = (x1 << 4U) - x1;
+        sk[(i << 2U) + 2U] = (x2 << 4U) - x2;
+        sk[(i << 2U) + 3U] = (x3 << 4U) - x3;
+    }
+}
+
+static void encrypt(uint8_t r, const uint64_t *sk, uint64_t *q)
+{
+    uint8_t i;
+
+    addRoundKey(q, sk);
+
+    for(i = 1U; i < r; i++){
+
+        MODA_AES_Sbox(q);
+        shiftRows(q);
+        mixColumns(q);
+        addRoundKey(q, &sk[i << 3U]);
+    }
+
+    MODA_AES_Sbox(q);
+    shiftRows(q);
+    addRoundKey(q, &sk[r << 3U]);
+}
+
+static void decrypt(uint8_t r, const uint64_t *sk, uint64_t *q)
+{
+    uint8_t i;
+
+    addRoundKey(q, &sk[r << 3U]);
+
+    for(i = r - 1U; i > 0U; i--){
+
+        invShiftRows(q);
+        MODA_AES_InvSbox(q);
+        addRoundKey(q, &sk[i << 3U]);
+        invMixColumns(q);
+    }
+
+    invShiftRows(q);
+    MODA_AES_InvSbox(q);
+    addRoundKey(q, sk);
+}
+
+static void load(uint64_t *q, const uint8_t *in, size_t n)
+{
+    uint32_t w[4U];
+    uint64_t *slice;
+    size_t i;
+    size_t j;
+
+    for(i = 0U; i < LANES; i++){
+
+        for(j = 0U; j < 4U; j++){
+
+            w[j] = (i < n) ? dec32le(&in[(i << 4U) + (j << 2U)]) : 0U;
+        }
+
+        slice = &q[(i / SLICE_BLOCKS) << 3U];
+        interleaveIn(&slice[i % SLICE_BLOCKS], &slice[(i % SLICE_BLOCKS) + 4U], w);
+    }
+
+    MODA_AES_Ortho(q);
+    MODA_AES_Ortho(&q[8U]);
+}
+
+static void store(uint8_t *out, uint64_t *q, size_t n)
+{
+    uint32_t w[4U];
+    uint64_t *slice;
+    size_t i;
+    size_t j;
+
+    MODA_AES_Ortho(q);
+    MODA_AES_Ortho(&q[8U]);
+
+    for(i = 0U; i < n; i++){
+
+        slice = &q[(i / SLICE_BLOCKS) << 3U];
+        interleaveOut(w, slice[i % SLICE_BLOCKS], slice[(i % SLICE_BLOCKS) + 4U]);
+
+        for(j = 0U; j < 4U; j++){
+
+            enc32le(&out[(i << 4U) + (j << 2U)], w[j]);
+        }
+    }
+}
+
+static uint32_t dec32le(const uint8_t *b)
+{
+    return (uint32_t)b[0] | ((uint32_t)b[1] << 8U) | ((uint32_t)b[2] << 16U) | ((uint32_t)b[3] << 24U);
+}
+
+static void enc32le(uint8_t *b, uint32_t w)
+{
+    b[0] = (uint8_t)w;
+    b[1] = (uint8_t)(w >> 8U);
+    b[2] = (uint8_t)(w >> 16U);
+    b[3] = (uint8_t)(w >> 24U);
+}
+
+#endif
@@ -0,0 +1,444 @@
+/* Copyright (c) 2013-2016 Cameron Harper
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * */
+
+/* includes ***********************************************************/
+
+#include "aes.h"
+#include "aes_cache.h"
+#include "aes_gcm.h"
+#include "moda_internal.h"
+
+#include <string.h>
+
+/* defines ************************************************************/
+
+/* marks the end of a list */
+#define NONE 0xffffffffU
+
+#ifndef MODA_AES_CACHE_LOCK
+    #if defined(__GNUC__) || defined(__clang__)
+        /* test and test-and-set so waiting threads spin on their own copy of the line */
+        #define MODA_AES_CACHE_LOCK(L) do{ \
+            while(__atomic_test_and_set((L), __ATOMIC_ACQUIRE)){ \
+                while(__atomic_load_n((L), __ATOMIC_RELAXED) != 0U){ \
+                } \
+            } \
+        }while(0)
+        #define MODA_AES_CACHE_UNLOCK(L) __atomic_clear((L), __ATOMIC_RELEASE)
+    #else
+        #error "define MODA_AES_CACHE_LOCK(L) and MODA_AES_CACHE_UNLOCK(L) for this compiler"
+    #endif
+#endif
+
+/* static function prototypes *****************************************/
+
+/**
+ * FNV-1a hash of an identifier with a final avalanche
+ *
+ * @param[in] id identifier
+ * @param[in] idSize byte size of `id`
+ * @return hash
+ *
+ * */
+static uint32_t hashId(const uint8_t *id, uint8_t idSize);
+
+/**
+ * Find the entry for an identifier (shard locked)
+ *
+ * @param[in] shard
+ * @param[in] hash hash of `id`
+ * @param[in] id identifier
+ * @param[in] idSize byte size of `id`
+ * @return entry index or #NONE
+ *
+ * */
+static uint32_t find(const struct aes_cache_shard *shard, uint32_t hash, const uint8_t *id, uint8_t idSize);
+
+/**
+ * Make an entry the most recently used (shard locked)
+ *
+ * @param[in] shard
+ * @param[in] e entry index (not in the list)
+ *
+ * */
+static void pushHead(struct aes_cache_shard *shard, uint32_t e);
+
+/**
+ * Take an entry off the recently used list and its hash chain, zeroise it
+ * and return it to the unused list (shard locked)
+ *
+ * @param[in] shard
+ * @param[in] e entry index
+ *
+ * */
+static void drop(struct aes_cache_shard *shard, uint32_t e);
+
+/**
+ * Look up or fill the entry for a key and copy out the expanded key or
+ * the whole GCM key
+ *
+ * @param[in] cache
+ * @param[in] id key identifier (NULL to use `key`)
+ * @param[in] idSize byte size of `id`
+ * @param[in] keySize enumerated size of `key`
+ * @param[in] key pointer to the key
+ * @param[out] aes expanded key (NULL if `gcm` is wanted)
+ * @param[out] gcm GCM key (NULL if `aes` is wanted)
+ * @return true if the key was found in the cache
+ *
+ * */
+static bool get(struct aes_cache *cache, const uint8_t *id, uint8_t idSize, enum aes_key_size keySize, const uint8_t *key, struct aes_ctxt *aes, struct aes_gcm_ctxt *gcm);
+
+/**
+ * Select the shard for a hash
+ *
+ * @param[in] cache
+ * @param[in] hash
+ * @return shard
+ *
+ * */
+static struct aes_cache_shard *shardOf(struct aes_cache *cache, uint32_t hash);
+
+/* functions **********************************************************/
+
+size_t MODA_AES_CacheInit(struct aes_cache *cache, void *mem, size_t memSize)
+{
+    struct aes_cache_entry *entry = (struct aes_cache_entry *)mem;
+    uint32_t *bucket;
+    struct aes_cache_shard *shard;
+    size_t n;
+    uint32_t m;
+    uint32_t i;
+    uint32_t s;
+
+    ASSERT((cache != NULL))
+    ASSERT(((mem != NULL) || (memSize == 0U)))
+    ASSERT((((uintptr_t)mem % MODA_AES_ALIGN) == 0U))
+
+    /* every entry costs itself and one bucket */
+    n = memSize / (sizeof(struct aes_cache_entry) + sizeof(uint32_t));
+    m = (uint32_t)(((n / MODA_AES_CACHE_SHARDS) < (size_t)(NONE - 1U)) ? (n / MODA_AES_CACHE_SHARDS) : (size_t)(NONE - 1U));
+
+    (void)memset(mem, 0, memSize);
+    (void)memset(cache, 0, sizeof(*cache));
+
+    bucket = (uint32_t *)(void *)&entry[(size_t)m * MODA_AES_CACHE_SHARDS];
+
+    for(s = 0U; s < MODA_AES_CACHE_SHARDS; s++){
+
+        shard = &cache->shard[s];
+
+        shard->entry = &entry[(size_t)m * s];
+        shard->bucket = &bucket[(size_t)m * s];
+        shard->size = m;
+        shard->head = NONE;
+        shard->tail = NONE;
+        shard->free = (m > 0U) ? 0U : NONE;
+
+        for(i = 0U; i < m; i++){
+
+            shard->bucket[i] = NONE;
+            shard->entry[i].chain = ((i + 1U) < m) ? (i + 1U) : NONE;
+            shard->entry[i].prev = NONE;
+            shard->entry[i].next = NONE;
+        }
+    }
+
+    return (size_t)m * MODA_AES_CACHE_SHARDS;
+}
+
+bool MODA_AES_CacheGet(struct aes_cache *cache, const uint8_t *id, uint8_t idSize, enum aes_key_size keySize, const uint8_t *key, struct aes_ctxt *aes)
+{
+    ASSERT((aes != NULL))
+
+    return get(cache, id, idSize, keySize, key, aes, NULL);
+}
+
+bool MODA_AES_CacheGetGCM(struct aes_cache *cache, const uint8_t *id, uint8_t idSize, enum aes_key_size keySize, const uint8_t *key, struct aes_gcm_ctxt *gcm)
+{
+    ASSERT((gcm != NULL))
+
+    return get(cache, id, idSize, keySize, key, NULL, gcm);
+}
+
+bool MODA_AES_CacheRemove(struct aes_cache *cache, const uint8_t *id, uint8_t idSize)
+{
+    struct aes_cache_shard *shard;
+    uint32_t hash;
+    uint32_t e;
+
+    ASSERT((cache != NULL))
+    ASSERT((id != NULL))
+    ASSERT(((idSize > 0U) && (idSize <= AES_CACHE_ID_SIZE)))
+
+    hash = hashId(id, idSize);
+    shard = shardOf(cache, hash);
+
+    MODA_AES_CACHE_LOCK(&shard->lock);
+
+    e = find(shard, hash, id, idSize);
+
+    if(e != NONE){
+
+        drop(shard, e);
+    }
+
+    MODA_AES_CACHE_UNLOCK(&shard->lock);
+
+    return (e != NONE);
+}
+
+void MODA_AES_CacheClear(struct aes_cache *cache)
+{
+    struct aes_cache_shard *shard;
+    uint32_t s;
+
+    ASSERT((cache != NULL))
+
+    for(s = 0U; s < MODA_AES_CACHE_SHARDS; s++){
+
+        shard = &cache->shard[s];
+
+        MODA_AES_CACHE_LOCK(&shard->lock);
+
+        while(shard->tail != NONE){
+
+            drop(shard, shard->tail);
+        }
+
+        MODA_AES_CACHE_UNLOCK(&shard->lock);
+    }
+}
+
+/* static functions  **************************************************/
+
+static uint32_t hashId(const uint8_t *id, uint8_t idSize)
+{
+    uint32_t hash = 0x811c9dc5U;
+    uint8_t i;
+
+    for(i = 0U; i < idSize; i++){
+
+        hash ^= id[i];
+        hash *= 0x01000193U;
+    }
+
+    /* FNV low bits only see low input bits; the shard and bucket need all of them */
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bU;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35U;
+    hash ^= hash >> 16;
+
+    return hash;
+}
+
+static uint32_t find(const struct aes_cache_shard *shard, uint32_t hash, const uint8_t *id, uint8_t idSize)
+{
+    const struct aes_cache_entry *entry;
+    uint32_t e = NONE;
+
+    if(shard->size > 0U){
+
+        e = shard->bucket[(hash / MODA_AES_CACHE_SHARDS) % shard->size];
+
+        while(e != NONE){
+
+            entry = &shard->entry[e];
+
+            if((entry->hash == hash) && (entry->idSize == idSize) && (memcmp(entry->id, id, idSize) == 0)){
+
+                break;
+            }
+
+            e = entry->chain;
+        }
+    }
+
+    return e;
+}
+
+static void pushHead(struct aes_cache_shard *shard, uint32_t e)
+{
+    shard->entry[e].prev = NONE;
+    shard->entry[e].next = shard->head;
+
+    if(shard->head != NONE){
+
+        shard->entry[shard->head].prev = e;
+    }
+    else{
+
+        shard->tail = e;
+    }
+
+    shard->head = e;
+}
+
+static void drop(struct aes_cache_shard *shard, uint32_t e)
+{
+    struct aes_cache_entry *entry = &shard->entry[e];
+    uint32_t *link = &shard->bucket[(entry->hash / MODA_AES_CACHE_SHARDS) % shard->size];
+
+    /* hash chain */
+    while(*link != e){
+
+        link = &shard->entry[*link].chain;
+    }
+
+    *link = entry->chain;
+
+    /* recently used list */
+    if(entry->prev != NONE){
+
+        shard->entry[entry->prev].next = entry->next;
+    }
+    else{
+
+        shard->head = entry->next;
+    }
+
+    if(entry->next != NONE){
+
+        shard->entry[entry->next].prev = entry->prev;
+    }
+    else{
+
+        shard->tail = entry->prev;
+    }
+
+    (void)memset(entry, 0, sizeof(*entry));
+
+    entry->prev = NONE;
+    entry->next = NONE;
+    entry->chain = shard->free;
+    shard->free = e;
+}
+
+static bool get(struct aes_cache *cache, const uint8_t *id, uint8_t idSize, enum aes_key_size keySize, const uint8_t *key, struct aes_ctxt *aes, struct aes_gcm_ctxt *gcm)
+{
+    const uint8_t *ident = (id != NULL) ? id : key;
+    uint8_t identSize = (id != NULL) ? idSize : (uint8_t)keySize;
+    struct aes_cache_shard *shard;
+    struct aes_cache_entry *entry;
+    struct aes_gcm_ctxt fresh;
+    uint32_t hash;
+    uint32_t e;
+    bool hit = false;
+
+    ASSERT((cache != NULL))
+    ASSERT((key != NULL))
+    ASSERT(((identSize > 0U) && (identSize <= AES_CACHE_ID_SIZE)))
+
+    hash = hashId(ident, identSize);
+    shard = shardOf(cache, hash);
+
+    MODA_AES_CACHE_LOCK(&shard->lock);
+
+    e = find(shard, hash, ident, identSize);
+
+    if(e != NONE){
+
+        entry = &shard->entry[e];
+
+        if(gcm != NULL){
+
+            (void)memcpy(gcm, &entry->gcm, sizeof(*gcm));
+        }
+        else{
+
+            (void)memcpy(aes, &entry->gcm.aes, sizeof(*aes));
+        }
+
+        if(shard->head != e){
+
+            /* unlink and push back as the most recently used */
+            shard->entry[entry->prev].next = entry->next;
+
+            if(entry->next != NONE){
+
+                shard->entry[entry->next].prev = entry->prev;
+            }
+            else{
+
+                shard->tail = entry->prev;
+            }
+
+            pushHead(shard, e);
+        }
+
+        hit = true;
+    }
+
+    MODA_AES_CACHE_UNLOCK(&shard->lock);
+
+    if(!hit){
+
+        /* expand without holding the lock (padding zeroed too) */
+        (void)memset(&fresh, 0, sizeof(fresh));
+        MODA_AES_GCM_Init(&fresh, keySize, key);
+
+        if(gcm != NULL){
+
+            (void)memcpy(gcm, &fresh, sizeof(*gcm));
+        }
+        else{
+
+            (void)memcpy(aes, &fresh.aes, sizeof(*aes));
+        }
+
+        MODA_AES_CACHE_LOCK(&shard->lock);
+
+        /* another thread may have got here first */
+        if((shard->size > 0U) && (find(shard, hash, ident, identSize) == NONE)){
+
+            if(shard->free == NONE){
+
+                drop(shard, shard->tail);
+            }
+
+            e = shard->free;
+            entry = &shard->entry[e];
+            shard->free = entry->chain;
+
+            (void)memcpy(&entry->gcm, &fresh, sizeof(fresh));
+            (void)memcpy(entry->id, ident, identSize);
+            entry->idSize = identSize;
+            entry->hash = hash;
+
+            entry->chain = shard->bucket[(hash / MODA_AES_CACHE_SHARDS) % shard->size];
+            shard->bucket[(hash / MODA_AES_CACHE_SHARDS) % shard->size] = e;
+
+            pushHead(shard, e);
+        }
+
+        MODA_AES_CACHE_UNLOCK(&shard->lock);
+
+        (void)memset(&fresh, 0, sizeof(fresh));
+    }
+
+    return hit;
+}
+
+static struct aes_cache_shard *shardOf(struct aes_cache *cache, uint32_t hash)
+{
+    return &cache->shard[hash % MODA_AES_CACHE_SHARDS];
+}
@@ -26,11 +26,15 @@
 #include "moda_internal.h"
 
 #include <string.h>
+#include <stdbool.h>
 
 /* defines ************************************************************/
 
 #define WORD_BLOCK_SIZE (AES_BLOCK_SIZE / MODA_WORD_SIZE)
 
+/* messages advanced together by MODA_AES_CMAC_Many() */
+#define CMAC_LANES 8U
+
 #define LSB 0x01U
 
 #if (MODA_WORD_SIZE == 1U)
@@ -71,6 +75,48 @@ static void copy128(moda_word_t *MODA_RESTRICT to, const moda_word_t *MODA_RESTR
  * */
 static void leftShift128(moda_word_t *v);
 
+/**
+ * Derive the two subkeys from L = E(K, 0)
+ *
+ * @param[out] k1 first subkey
+ * @param[out] k2 second subkey
+ * @param[in] l encrypted zero block
+ *
+ * */
+static void subkeys(moda_word_t *k1, moda_word_t *k2, const moda_word_t *l);
+
+/**
+ * Number of blocks CMAC processes for a message (at least one)
+ *
+ * @param[in] inLen byte length of the message
+ * @return blocks
+ *
+ * */
+static uint32_t countBlocks(uint32_t inLen);
+
+/**
+ * Load a block of a message, padded and masked with a subkey if it is the last
+ *
+ * @param[out] m block
+ * @param[in] in message
+ * @param[in] inLen byte length of the message
+ * @param[in] b block index
+ * @param[in] k1 first subkey
+ * @param[in] k2 second subkey
+ *
+ * */
+static void loadBlock(moda_word_t *m, const uint8_t *in, uint32_t inLen, uint32_t b, const moda_word_t *k1, const moda_word_t *k2);
+
+/**
+ * Check if every lane uses the same expanded key
+ *
+ * @param[in] aes `n` expanded keys
+ * @param[in] n number of lanes
+ * @return true if all are the same
+ *
+ * */
+static bool sameKey(const struct aes_ctxt *const *aes, size_t n);
+
 #if (MODA_WORD_SIZE > 1U)
 #ifndef MODA_BIG_ENDIAN
 /**
@@ -96,31 +142,131 @@ void MODA_AES_CMAC(const struct aes_ctxt *aes, const uint8_t *in, uint32_t inLen
     moda_word_t m[WORD_BLOCK_SIZE];
     uint32_t b;
     uint32_t n;
-    uint32_t pos = 0U;
     
     ASSERT((aes != NULL))
     ASSERT((tSize <= AES_BLOCK_SIZE))
     
-    n = (inLen / AES_BLOCK_SIZE);
+    n = countBlocks(inLen);
+    
+    (void)memset(k, 0, sizeof(k));
 
-    if( (inLen % AES_BLOCK_SIZE) != 0U ){
+    MODA_AES_Encrypt(aes, (uint8_t *)k);
 
-        n += 1U;    
+    subkeys(k1, k2, k);
+
+    xor128(k, k);
+
+    for(b = 0U; b < n; b++){
+
+        loadBlock(m, in, inLen, b, k1, k2);
+        
+        xor128(m, k);
+
+        MODA_AES_EncryptBlocks(aes, (uint8_t *)k, (uint8_t *)m, 1U);
     }
 
-    if(n == 0U){
+    (void)memcpy(t, k, (size_t)tSize);
+}
 
-        n = 1U;
+void MODA_AES_CMAC_Many(const struct aes_cmac_msg *msg, size_t n)
+{
+    const struct aes_ctxt *aes[CMAC_LANES];
+    moda_word_t x[CMAC_LANES][WORD_BLOCK_SIZE];
+    moda_word_t m[CMAC_LANES][WORD_BLOCK_SIZE];
+    moda_word_t k1[CMAC_LANES][WORD_BLOCK_SIZE];
+    moda_word_t k2[CMAC_LANES][WORD_BLOCK_SIZE];
+    uint32_t blocks[CMAC_LANES];
+    size_t lane[CMAC_LANES];
+    const struct aes_cmac_msg *g;
+    size_t group;
+    size_t lanes;
+    size_t active;
+    size_t i;
+    uint32_t b;
+    uint32_t most;
+
+    ASSERT(((msg != NULL) || (n == 0U)))
+
+    for(group = 0U; group < n; group += lanes){
+
+        lanes = ((n - group) < CMAC_LANES) ? (n - group) : CMAC_LANES;
+        g = &msg[group];
+        most = 0U;
+
+        /* L for every lane in one call */
+        for(i = 0U; i < lanes; i++){
+
+            ASSERT((g[i].aes != NULL))
+            ASSERT((g[i].tSize <= AES_BLOCK_SIZE))
+
+            aes[i] = g[i].aes;
+            (void)memset(x[i], 0, sizeof(x[i]));
+
+            blocks[i] = countBlocks(g[i].inLen);
+            most = (blocks[i] > most) ? blocks[i] : most;
+        }
+
+        MODA_AES_EncryptMany(aes, (uint8_t *)x, (uint8_t *)x, lanes);
+
+        for(i = 0U; i < lanes; i++){
+
+            subkeys(k1[i], k2[i], x[i]);
+            xor128(x[i], x[i]);
+        }
+
+        /* block b of every message that has one */
+        for(b = 0U; b < most; b++){
+
+            active = 0U;
+
+            for(i = 0U; i < lanes; i++){
+
+                if(b < blocks[i]){
+
+                    loadBlock(m[active], g[i].in, g[i].inLen, b, k1[i], k2[i]);
+                    xor128(m[active], x[i]);
+                    aes[active] = g[i].aes;
+                    lane[active] = i;
+                    active++;
+                }
+            }
+
+            /* one key for every lane is the common case and runs as ECB */
+            if(sameKey(aes, active)){
+
+                MODA_AES_EncryptBlocks(aes[0], (uint8_t *)m, (uint8_t *)m, active);
+            }
+            else{
+
+                MODA_AES_EncryptMany(aes, (uint8_t *)m, (uint8_t *)m, active);
+            }
+
+            for(i = 0U; i < active; i++){
+
+                copy128(x[lane[i]], m[i]);
+            }
+        }
+
+        for(i = 0U; i < lanes; i++){
+
+            (void)memcpy(g[i].t, x[i], (size_t)g[i].tSize);
+        }
     }
-    
-    xor128(k, k);
 
-    MODA_AES_Encrypt(aes, (uint8_t *)k);
+    /* clear subkeys on stack */
+    (void)memset(k1, 0, sizeof(k1));
+    (void)memset(k2, 0, sizeof(k2));
+}
+
 
-    copy128(k1, k);
+/* static functions  **************************************************/
+
+static void subkeys(moda_word_t *k1, moda_word_t *k2, const moda_word_t *l)
+{
+    copy128(k1, l);
     leftShift128(k1);
 
-    if((*(uint8_t *)k & 0x80U) == 0x80U){
+    if((*(const uint8_t *)l & 0x80U) == 0x80U){
 
         ((uint8_t *)k1)[AES_BLOCK_SIZE - 1U] ^= 0x87U;
     }
@@ -131,51 +277,67 @@ void MODA_AES_CMAC(const struct aes_ctxt *aes, const uint8_t *in, uint32_t inLen
     if((*(uint8_t *)k1 & 0x80U) == 0x80U){
 
         ((uint8_t *)k2)[AES_BLOCK_SIZE - 1U] ^= 0x87U;
-    }        
+    }
+}
 
-    xor128(k, k);
+static uint32_t countBlocks(uint32_t inLen)
+{
+    uint32_t n = (inLen / AES_BLOCK_SIZE);
 
-    uint32_t size = inLen;
-    
-    for(b = 0U; b < n; b++){
+    if( (inLen % AES_BLOCK_SIZE) != 0U ){
+
+        n += 1U;    
+    }
+
+    if(n == 0U){
 
-        xor128(m, m);
+        n = 1U;
+    }
 
-        (void)memcpy(m, &in[pos], (size < AES_BLOCK_SIZE) ? (size_t)size : AES_BLOCK_SIZE);
+    return n;
+}
 
-        /* if the last block */
-        if(size <= AES_BLOCK_SIZE){
+static void loadBlock(moda_word_t *m, const uint8_t *in, uint32_t inLen, uint32_t b, const moda_word_t *k1, const moda_word_t *k2)
+{
+    uint32_t pos = b * AES_BLOCK_SIZE;
+    uint32_t size = inLen - pos;    /* b never passes the last block */
 
-            if(size == AES_BLOCK_SIZE){
+    xor128(m, m);
 
-                xor128(m, k1);
-            }
-            else{
+    (void)memcpy(m, &in[pos], (size < AES_BLOCK_SIZE) ? (size_t)size : AES_BLOCK_SIZE);
 
-                ((uint8_t *)m)[size] = 0x80U;
-                xor128(m, k2);
-            }            
+    /* if the last block */
+    if(size <= AES_BLOCK_SIZE){
+
+        if(size == AES_BLOCK_SIZE){
+
+            xor128(m, k1);
         }
         else{
 
-            pos += AES_BLOCK_SIZE;            
+            ((uint8_t *)m)[size] = 0x80U;
+            xor128(m, k2);
         }
-        
-        xor128(m, k);
+    }
+}
 
-        MODA_AES_Encrypt(aes, (uint8_t *)m);
+static bool sameKey(const struct aes_ctxt *const *aes, size_t n)
+{
+    size_t i;
+    bool retval = true;
 
-        copy128(k, m);
+    for(i = 1U; i < n; i++){
 
-        size -= AES_BLOCK_SIZE;
+        if(aes[i] != aes[0]){
+
+            retval = false;
+            break;
+        }
     }
 
-    (void)memcpy(t, k, (size_t)tSize);
+    return retval;
 }
 
-
-/* static functions  **************************************************/
-
 static void leftShift128(moda_word_t *v)
 {
     moda_word_t t;
@@ -1,511 +1,1950 @@
-/* Copyright (c) 2013-2016 Cameron Harper
- * 
- * Permission is hereby granted, free of charge, to any person obtaining a copy of
- * this software and associated documentation files (the "Software"), to deal in
- * the Software without restriction, including without limitation the rights to
- * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
- * the Software, and to permit persons to whom the Software is furnished to do so,
- * subject to the following conditions:
- * 
- * The above copyright notice and this permission notice shall be included in all
- * copies or substantial portions of the Software.
- * 
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
- * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
- * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
- * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
- * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
- *
- * */
-
-/* includes ***********************************************************/
-
-#include "aes.h"
-#include "aes_gcm.h"
-#include "moda_internal.h"
-
-#include <string.h>
-
-/* defines ************************************************************/
-
-#define WORD_BLOCK_SIZE (AES_BLOCK_SIZE / MODA_WORD_SIZE)
-
-/* largest possible authentication tag size */
-#define GCM_TAG_SIZE 16U
-
-/* nominal IV size */
-#define GCM_IV_SIZE 12U
-
-#ifndef MODA_BIG_ENDIAN
-
-    #define R   0xe1U
-
-    #if (MODA_WORD_SIZE == 1U)
-        #define TST_MSB 0x01U
-        #define LSB 0x80U
-    #elif (MODA_WORD_SIZE == 2U)
-        #define TST_MSB 0x0100U
-        #define LSB 0x8000U
-    #elif (MODA_WORD_SIZE == 4U)
-        #define TST_MSB 0x01000000U
-        #define LSB 0x80000000U
-    #else
-        #define TST_MSB 0x0100000000000000U
-        #define LSB 0x8000000000000000U
-    #endif
-
-#else
-
-    #define TST_MSB 0x01U
-
-    #if (MODA_WORD_SIZE == 1U)
-        #define R 0xe1U
-        #define LSB 0x80U
-    #elif (MODA_WORD_SIZE == 2U)
-        #define R 0xe100U
-        #define LSB 0x8000U
-    #elif (MODA_WORD_SIZE == 4U)
-        #define R 0xe1000000U
-        #define LSB 0x80000000U
-    #else
-        #define R 0xe100000000000000U
-        #define LSB 0x8000000000000000U
-    #endif
-
-#endif
-
-/* static function prototypes *****************************************/
-
-/**
- * XOR an aligned AES block (may be aliased)
- *
- * @param[out] acc accumulator
- * @param[in] mask XORed with accumulator
- *
- * */
-static void xor128(moda_word_t *acc, const moda_word_t *mask);
-
-/**
- * word copy an non-aliased aligned AES block
- *
- * @param[out] to copy destination
- * @param[in] from copy input
- *
- * */
-static void copy128(moda_word_t *MODA_RESTRICT to, const moda_word_t *MODA_RESTRICT from);
-
-#if (MODA_WORD_SIZE > 1U)
-#ifndef MODA_BIG_ENDIAN
-/**
- * Swap the byte endianness of a word
- *
- * @param[in] w input word
- * @return reversed word
- *
- * */
-static moda_word_t swapw(moda_word_t w);
-
-/**
- * Swap the byte endianness of an AES block
- *
- * @param[in] block block to swap
- *
- * */
-static void swapBlock(moda_word_t *block);
-#endif
-#endif
-
-/* Table-less galois multiplication in a 128bit field
- *
- * X = X . Y
- *
- * algorithm:
- * 
- * Z <- 0, V <- X
- * for i to 127 do
- *   if Yi == 1 then
- *     Z <- Z XOR V
- *   end if
- *   if V127 = 0 then
- *     V <- rightshift(V)
- *   else
- *     V <- rightshit(V) XOR R
- *   end if
- * end for
- * return Z
- * 
- * */    
-static void xormul128(moda_word_t *x, const moda_word_t *text, const moda_word_t *y);
-
-/**
- * Increment an unaligned big endian 32bit counter
- *
- * @param[in] counter pointer to MSB of counter field
- *
- * */
-static void incrementCounter(uint8_t *counter);
-
-/**
- * GCM implementation
- *
- * @param[in] aes context
- * @param[in] iv initialisation vector
- * @param[in] ivSize size of *IV in bytes
- * @param[out] out cipher output buffer
- * @param[in] in cipher input buffer
- * @param[in] textSize size of *in or *out in bytes
- * @param[in] aad additional non-ciphered data for authentication
- * @param[in] aadSize size of *aad
- * @param[in] encrypt encrypt/decrypt boolean
- * @param[out] XX GMAC output
- * 
- * */
-static void gcm(const struct aes_ctxt *aes, const uint8_t *iv, uint32_t ivSize, uint8_t *out, const uint8_t *in, uint32_t textSize, const uint8_t *aad, uint32_t aadSize, bool encrypt, moda_word_t *x);
-
-
-/* functions **********************************************************/
-
-void MODA_AES_GCM_Encrypt(const struct aes_ctxt *aes, const uint8_t *iv, uint32_t ivSize, uint8_t *out, const uint8_t *in, uint32_t textSize, const uint8_t *aad, uint32_t aadSize, uint8_t *t, uint8_t tSize)
-{
-    moda_word_t x[WORD_BLOCK_SIZE];
-
-    ASSERT((aes != NULL))
-    ASSERT((tSize <= GCM_TAG_SIZE))
-    
-    gcm(aes, iv, ivSize, out, in, textSize, aad, aadSize, true, x);
-    (void)memcpy(t, x, (size_t)tSize);
-}
-
-bool MODA_AES_GCM_Decrypt(const struct aes_ctxt *aes, const uint8_t *iv, uint32_t ivSize, uint8_t *out, const uint8_t *in, uint32_t textSize, const uint8_t *aad, uint32_t aadSize, const uint8_t *t, uint8_t tSize)
-{
-    moda_word_t x[WORD_BLOCK_SIZE];
-
-    ASSERT((aes != NULL))
-    ASSERT((tSize <= GCM_TAG_SIZE))
-    
-    gcm(aes, iv, ivSize, out, in, textSize, aad, aadSize, false, x);
-
-    return (memcmp(x, t, (size_t)tSize) == 0);
-}
-
-/* static functions  **************************************************/
-
-static void xor128(moda_word_t *acc, const moda_word_t *mask)
-{
-    uint8_t i;
-    for(i=0U; i < WORD_BLOCK_SIZE; i++){
-
-        acc[i] ^= mask[i];
-    }
-}
-
-static void copy128(moda_word_t *MODA_RESTRICT to, const moda_word_t *MODA_RESTRICT from)
-{
-    uint8_t i;
-    for(i=0U; i < WORD_BLOCK_SIZE; i++){
-
-        to[i] = from[i];
-    }
-}
-
-#if (MODA_WORD_SIZE > 1U)
-#ifndef MODA_BIG_ENDIAN
-static moda_word_t swapw(moda_word_t w)
-{
-#if MODA_WORD_SIZE == 1U 
-    return w;
-#elif MODA_WORD_SIZE == 2U
-    return ((w >> 8U) & 0xffU) | ((w << 8U) & 0xff00U);    
-#elif MODA_WORD_SIZE == 4U
-    return  ((w << 24U) & 0xff000000U)    |
-            ((w <<  8U) & 0xff0000U)      |
-            ((w >>  8U) & 0xff00U)        |
-            ((w >> 24U) & 0xffU);
-#else
-    return  ((w << 56U) & 0xff00000000000000U)    |
-            ((w << 40U) & 0xff000000000000U)      |
-            ((w << 24U) & 0xff0000000000U)        |
-            ((w <<  8U) & 0xff00000000U)          |
-            ((w >>  8U) & 0xff000000U)            |
-            ((w >> 24U) & 0xff0000U)              |
-            ((w >> 40U) & 0xff00U)                |
-            ((w >> 56U) & 0xffU);            
-#endif
-}
-
-static void swapBlock(moda_word_t *block)
-{
-    uint8_t i;
-    for(i=0; i < WORD_BLOCK_SIZE; i++){
-
-        block[i] = swapw(block[i]);
-    }
-}
-#endif
-#endif
-
-static void xormul128(moda_word_t *x, const moda_word_t *text, const moda_word_t *y)
-{
-    moda_word_t z[WORD_BLOCK_SIZE];
-    moda_word_t v[WORD_BLOCK_SIZE];
-    moda_word_t yi;
-    moda_word_t t;
-    moda_word_t tt;
-    moda_word_t vmsb;
-    moda_word_t carry;
-    uint8_t i;
-    uint8_t j;
-    uint8_t k;
-
-    xor128(x, text);
-
-    xor128(z, z);
-    copy128(v, x);
-
-    for(i=0U; i < WORD_BLOCK_SIZE; i++){
-
-        yi = y[i];
-
-        for(j=0U; j < (MODA_WORD_SIZE << 3U); j++){
-
-            if((yi & LSB) == LSB){
-
-                xor128(z, v);
-            }
-            
-            /* MSbit of vector */
-            vmsb = v[WORD_BLOCK_SIZE-1U] & TST_MSB;
-            carry = 0U;
-            
-            /* rightshift vector */
-            for(k=0U; k < WORD_BLOCK_SIZE; k++){
-
-                t = v[k];        
-
-#if (MODA_WORD_SIZE > 1U)
-#ifndef MODA_BIG_ENDIAN
-                t = swapw(t);        
-#endif
-#endif
-                tt = t;
-                tt >>= 1;
-                tt |= carry;
-
-#if (MODA_WORD_SIZE > 1U)
-#ifndef MODA_BIG_ENDIAN
-                tt = swapw(tt);        
-#endif
-#endif
-                carry = ((t & 0x1U) == 0x1U) ? LSB : 0x0U;
-                v[k] = tt;
-            }
-
-            if(vmsb != 0U){
-
-                v[0] ^= R;
-            }
-            
-            yi <<= 1;            
-        }
-    }
-
-    copy128(x, z);
-}
-
-static void incrementCounter(uint8_t *counter)
-{
-    counter[AES_BLOCK_SIZE-1U]++;
-
-    if(counter[AES_BLOCK_SIZE-1U] == 0U){
-
-        counter[AES_BLOCK_SIZE-2U]++;
-
-        if(counter[AES_BLOCK_SIZE-2U] == 0U){
-
-            counter[AES_BLOCK_SIZE-3U]++;
-
-            if(counter[AES_BLOCK_SIZE-3U] == 0U){
-
-                counter[AES_BLOCK_SIZE-4U]++;
-            }
-        }
-    }    
-}
-
-static void gcm(const struct aes_ctxt *aes, const uint8_t *iv, uint32_t ivSize, uint8_t *out, const uint8_t *in, uint32_t textSize, const uint8_t *aad, uint32_t aadSize, bool encrypt, moda_word_t *x)
-{
-    static const uint8_t zeroCounter[] = {0U, 0U, 0U, 1U};
-    uint8_t counter[AES_BLOCK_SIZE];
-    moda_word_t encryptedCounter[WORD_BLOCK_SIZE];
-    moda_word_t encryptedInitialCounter[WORD_BLOCK_SIZE];    
-    moda_word_t part[WORD_BLOCK_SIZE];
-    moda_word_t h[WORD_BLOCK_SIZE];    
-    uint8_t sizeBlock[AES_BLOCK_SIZE];
-
-    uint32_t size;
-    const uint8_t *inPtr;
-    uint8_t *outPtr;
-
-    /* generate the hash subkey */
-    xor128(h, h);
-    MODA_AES_Encrypt(aes, (uint8_t *)h);
-
-#if (MODA_WORD_SIZE > 1U)
-#ifndef MODA_BIG_ENDIAN
-    swapBlock(h);
-#endif
-#endif
-
-    /* create zero block */
-    xor128(x, x);
-
-    if(ivSize == GCM_IV_SIZE){
-
-        (void)memcpy(counter, iv, GCM_IV_SIZE);
-        (void)memcpy(&counter[GCM_IV_SIZE], zeroCounter, (AES_BLOCK_SIZE - GCM_IV_SIZE));
-    }
-    /* GHASH(H, {}, IV) */ 
-    else{
-
-        size = ivSize;
-        inPtr = iv;
-
-        /* create zero block (for this GHASH) */
-        xor128((moda_word_t *)counter, (moda_word_t *)counter);
-
-        if(size > 0U){
-
-            for(;;){
-
-                xor128(part, part);
-                (void)memcpy(part, inPtr, ((size < AES_BLOCK_SIZE)? (size_t)size : AES_BLOCK_SIZE));
-                xormul128((moda_word_t *)counter, part, h);
-                
-                if(size <= AES_BLOCK_SIZE){
-
-                    break;
-                }
-                else{
-
-                    inPtr = &inPtr[AES_BLOCK_SIZE];
-                    size -= AES_BLOCK_SIZE;              
-                }
-            }
-        }
-
-        xor128((moda_word_t *)sizeBlock, (moda_word_t *)sizeBlock);
-        sizeBlock[11] = (uint8_t)(ivSize >> (32U-3U));
-        sizeBlock[12] = (uint8_t)(ivSize >> (24U-3U));
-        sizeBlock[13] = (uint8_t)(ivSize >> (16U-3U));
-        sizeBlock[14] = (uint8_t)(ivSize >> (8U-3U));
-        sizeBlock[15] = (uint8_t)(ivSize << 3U);
-
-        xormul128((moda_word_t *)counter, (moda_word_t *)sizeBlock, h);
-    }
-
-    /* encrypt the initial counter value */
-    copy128(encryptedInitialCounter, (moda_word_t *)counter);
-    MODA_AES_Encrypt(aes, (uint8_t *)encryptedInitialCounter);
-
-    /* GHASH aad */
-    if(aadSize > 0U){
-
-        inPtr = aad;
-        size = aadSize;
-        
-        for(;;){
-
-            xor128(part, part);
-            (void)memcpy(part, inPtr, ((size < AES_BLOCK_SIZE)?(size_t)size:AES_BLOCK_SIZE));
-
-            xormul128(x, part, h);
-
-            if(size <= AES_BLOCK_SIZE){
-
-                break;
-            }
-            else{
-
-                inPtr = &inPtr[AES_BLOCK_SIZE];
-                size -= AES_BLOCK_SIZE;
-            }
-        }
-    }
-
-    /* encrypt/decrypt and GHASH cipher text */
-    if(textSize > 0U){
-
-        inPtr = in;
-        outPtr = out;
-        size = textSize;
-
-        for(;;){
-
-            incrementCounter(counter);
-            copy128(encryptedCounter, (moda_word_t *)counter);
-            MODA_AES_Encrypt(aes, (uint8_t *)encryptedCounter);  
-            
-            xor128(part, part);
-            (void)memcpy(part, inPtr, ((size < AES_BLOCK_SIZE)?(size_t)size:AES_BLOCK_SIZE));
-            
-            if(!encrypt){
-
-                xormul128(x, part, h);
-            }
-
-            xor128(part, encryptedCounter);
-            (void)memcpy(outPtr, part, (size < AES_BLOCK_SIZE)?(size_t)size:AES_BLOCK_SIZE);
-            
-            if(encrypt){
-
-                /* zero garbage in unused block portion */
-                if(size < AES_BLOCK_SIZE){
-
-                    (void)memset(&((uint8_t *)part)[size], 0, (AES_BLOCK_SIZE - (size_t)size));
-                }
-
-                xormul128(x, part, h);
-            }
-            
-            if(size <= AES_BLOCK_SIZE){
-
-                break;
-            }
-            else{
-
-                inPtr = &inPtr[AES_BLOCK_SIZE];
-                outPtr = &outPtr[AES_BLOCK_SIZE];
-                size -= AES_BLOCK_SIZE;
-            }
-        }
-    }
-
-    /* make sizeBlock: [aad_size]64 || [size]64 */
-    sizeBlock[0] = 0x0U;
-    sizeBlock[1] = 0x0U;
-    sizeBlock[2] = 0x0U;
-    sizeBlock[3] = (uint8_t)(aadSize >> (32U-3U)); /* (x8 bits) */   
-    sizeBlock[4] = (uint8_t)(aadSize >> (24U-3U));
-    sizeBlock[5] = (uint8_t)(aadSize >> (16U-3U)); 
-    sizeBlock[6] = (uint8_t)(aadSize >> (8U-3U));
-    sizeBlock[7] = (uint8_t)(aadSize << 3U);
-    sizeBlock[8] = 0x0U;
-    sizeBlock[9] = 0x0U;
-    sizeBlock[10] = 0x0U;
-    sizeBlock[11] = (uint8_t)(textSize >> (32U-3U));
-    sizeBlock[12] = (uint8_t)(textSize >> (24U-3U));
-    sizeBlock[13] = (uint8_t)(textSize >> (16U-3U));
-    sizeBlock[14] = (uint8_t)(textSize >> (8U-3U));
-    sizeBlock[15] = (uint8_t)(textSize << 3U);
-
-    /* GHASH output with sizeBlock */
-    xormul128(x, (moda_word_t *)sizeBlock, h);
-
-    /* XOR encrypted initial counter with GHASH output */    
-    xor128(x, encryptedInitialCounter);
-    
-    /* clear h on stack */
-    xor128(h, h);    
-}
-    
+/* Copyright (c) 2013-2016 Cameron Harper
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * */
+
+/* includes ***********************************************************/
+
+#include "aes.h"
+#include "aes_gcm.h"
+#include "moda_internal.h"
+
+#include <string.h>
+
+/* defines ************************************************************/
+
+#define WORD_BLOCK_SIZE (AES_BLOCK_SIZE / MODA_WORD_SIZE)
+
+/* largest possible authentication tag size */
+#define GCM_TAG_SIZE 16U
+
+/* nominal IV size */
+#define GCM_IV_SIZE 12U
+
+/* largest text (2^39 - 256 bits) and AAD (2^64 - 1 bits) in bytes */
+#define GCM_TEXT_MAX 0xfffffffe0U
+#define GCM_AAD_MAX 0x1fffffffffffffffU
+
+/* counter blocks encrypted per call to MODA_AES_EncryptBlocks() */
+#ifndef MODA_GCM_BATCH
+    #define MODA_GCM_BATCH 8U
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define GCM_COUNT(C) (void)__atomic_fetch_add((C), 1U, __ATOMIC_RELAXED)
+    #define GCM_READ(C) __atomic_load_n((C), __ATOMIC_RELAXED)
+#else
+    #define GCM_COUNT(C) ((*(C))++)
+    #define GCM_READ(C) (*(C))
+#endif
+
+/* burst packets with at least this many bytes of text are not gathered */
+#define GCM_BURST_LONG (MODA_GCM_BATCH * AES_BLOCK_SIZE)
+
+/* xormul128() works on words in the order of the hash subkey (big endian) */
+#if (MODA_WORD_SIZE == 1U)
+    #define R 0xe1U
+    #define LSB 0x80U
+    #define TST_MSB 0x01U
+#elif (MODA_WORD_SIZE == 2U)
+    #define R 0xe100U
+    #define LSB 0x8000U
+    #define TST_MSB 0x01U
+#endif
+
+/* GHASH key: hash subkey and optional table built from it */
+struct ghash_key {
+
+    const moda_word_t *h;
+    const uint64_t *table;
+    size_t tableSize;
+#if defined(MODA_GCM_PCLMUL)
+    const uint8_t *hpow;    /* NULL if the host lacks PCLMULQDQ */
+#endif
+};
+
+/* static variables ***************************************************/
+
+/* tags rejected by MODA_AES_GCM_OpenVerified() */
+static uint32_t rejected = 0U;
+
+/* reduction of the four bits shifted out of a 4bit Shoup multiply */
+static const uint16_t last4[16U] = {
+    0x0000U, 0x1c20U, 0x3840U, 0x2460U, 0x7080U, 0x6ca0U, 0x48c0U, 0x54e0U,
+    0xe100U, 0xfd20U, 0xd940U, 0xc560U, 0x9180U, 0x8da0U, 0xa9c0U, 0xb5e0U
+};
+
+/* reduction of the eight bits shifted out of an 8bit Shoup multiply */
+static const uint16_t last8[256U] = {
+    0x0000U, 0x01c2U, 0x0384U, 0x0246U, 0x0708U, 0x06caU, 0x048cU, 0x054eU,
+    0x0e10U, 0x0fd2U, 0x0d94U, 0x0c56U, 0x0918U, 0x08daU, 0x0a9cU, 0x0b5eU,
+    0x1c20U, 0x1de2U, 0x1fa4U, 0x1e66U, 0x1b28U, 0x1aeaU, 0x18acU, 0x196eU,
+    0x1230U, 0x13f2U, 0x11b4U, 0x1076U, 0x1538U, 0x14faU, 0x16bcU, 0x177eU,
+    0x3840U, 0x3982U, 0x3bc4U, 0x3a06U, 0x3f48U, 0x3e8aU, 0x3cccU, 0x3d0eU,
+    0x3650U, 0x3792U, 0x35d4U, 0x3416U, 0x3158U, 0x309aU, 0x32dcU, 0x331eU,
+    0x2460U, 0x25a2U, 0x27e4U, 0x2626U, 0x2368U, 0x22aaU, 0x20ecU, 0x212eU,
+    0x2a70U, 0x2bb2U, 0x29f4U, 0x2836U, 0x2d78U, 0x2cbaU, 0x2efcU, 0x2f3eU,
+    0x7080U, 0x7142U, 0x7304U, 0x72c6U, 0x7788U, 0x764aU, 0x740cU, 0x75ceU,
+    0x7e90U, 0x7f52U, 0x7d14U, 0x7cd6U, 0x7998U, 0x785aU, 0x7a1cU, 0x7bdeU,
+    0x6ca0U, 0x6d62U, 0x6f24U, 0x6ee6U, 0x6ba8U, 0x6a6aU, 0x682cU, 0x69eeU,
+    0x62b0U, 0x6372U, 0x6134U, 0x60f6U, 0x65b8U, 0x647aU, 0x663cU, 0x67feU,
+    0x48c0U, 0x4902U, 0x4b44U, 0x4a86U, 0x4fc8U, 0x4e0aU, 0x4c4cU, 0x4d8eU,
+    0x46d0U, 0x4712U, 0x4554U, 0x4496U, 0x41d8U, 0x401aU, 0x425cU, 0x439eU,
+    0x54e0U, 0x5522U, 0x5764U, 0x56a6U, 0x53e8U, 0x522aU, 0x506cU, 0x51aeU,
+    0x5af0U, 0x5b32U, 0x5974U, 0x58b6U, 0x5df8U, 0x5c3aU, 0x5e7cU, 0x5fbeU,
+    0xe100U, 0xe0c2U, 0xe284U, 0xe346U, 0xe608U, 0xe7caU, 0xe58cU, 0xe44eU,
+    0xef10U, 0xeed2U, 0xec94U, 0xed56U, 0xe818U, 0xe9daU, 0xeb9cU, 0xea5eU,
+    0xfd20U, 0xfce2U, 0xfea4U, 0xff66U, 0xfa28U, 0xfbeaU, 0xf9acU, 0xf86eU,
+    0xf330U, 0xf2f2U, 0xf0b4U, 0xf176U, 0xf438U, 0xf5faU, 0xf7bcU, 0xf67eU,
+    0xd940U, 0xd882U, 0xdac4U, 0xdb06U, 0xde48U, 0xdf8aU, 0xddccU, 0xdc0eU,
+    0xd750U, 0xd692U, 0xd4d4U, 0xd516U, 0xd058U, 0xd19aU, 0xd3dcU, 0xd21eU,
+    0xc560U, 0xc4a2U, 0xc6e4U, 0xc726U, 0xc268U, 0xc3aaU, 0xc1ecU, 0xc02eU,
+    0xcb70U, 0xcab2U, 0xc8f4U, 0xc936U, 0xcc78U, 0xcdbaU, 0xcffcU, 0xce3eU,
+    0x9180U, 0x9042U, 0x9204U, 0x93c6U, 0x9688U, 0x974aU, 0x950cU, 0x94ceU,
+    0x9f90U, 0x9e52U, 0x9c14U, 0x9dd6U, 0x9898U, 0x995aU, 0x9b1cU, 0x9adeU,
+    0x8da0U, 0x8c62U, 0x8e24U, 0x8fe6U, 0x8aa8U, 0x8b6aU, 0x892cU, 0x88eeU,
+    0x83b0U, 0x8272U, 0x8034U, 0x81f6U, 0x84b8U, 0x857aU, 0x873cU, 0x86feU,
+    0xa9c0U, 0xa802U, 0xaa44U, 0xab86U, 0xaec8U, 0xaf0aU, 0xad4cU, 0xac8eU,
+    0xa7d0U, 0xa612U, 0xa454U, 0xa596U, 0xa0d8U, 0xa11aU, 0xa35cU, 0xa29eU,
+    0xb5e0U, 0xb422U, 0xb664U, 0xb7a6U, 0xb2e8U, 0xb32aU, 0xb16cU, 0xb0aeU,
+    0xbbf0U, 0xba32U, 0xb874U, 0xb9b6U, 0xbcf8U, 0xbd3aU, 0xbf7cU, 0xbebeU
+};
+
+/* static function prototypes *****************************************/
+
+/**
+ * XOR an aligned AES block (may be aliased)
+ *
+ * @param[out] acc accumulator
+ * @param[in] mask XORed with accumulator
+ *
+ * */
+static void xor128(moda_word_t *acc, const moda_word_t *mask);
+
+/**
+ * word copy an non-aliased aligned AES block
+ *
+ * @param[out] to copy destination
+ * @param[in] from copy input
+ *
+ * */
+static void copy128(moda_word_t *MODA_RESTRICT to, const moda_word_t *MODA_RESTRICT from);
+
+#if (MODA_WORD_SIZE > 1U)
+#ifndef MODA_BIG_ENDIAN
+/**
+ * Swap the byte endianness of a word
+ *
+ * @param[in] w input word
+ * @return reversed word
+ *
+ * */
+static moda_word_t swapw(moda_word_t w);
+
+/**
+ * Swap the byte endianness of an AES block
+ *
+ * @param[in] block block to swap
+ *
+ * */
+static void swapBlock(moda_word_t *block);
+#endif
+#endif
+
+/* Table-less galois multiplication in a 128bit field
+ *
+ * X = (X XOR text) . Y
+ *
+ * X and text are GCM bytes, Y is the hash subkey from hashKey(). A NULL
+ * text multiplies X alone.
+ *
+ * With 8 and 16bit words X is converted once to big endian words and
+ * multiplied bit by bit:
+ *
+ * Z <- 0, V <- X
+ * for i to 127 do
+ *   if Yi == 1 then
+ *     Z <- Z XOR V
+ *   end if
+ *   if V127 = 0 then
+ *     V <- rightshift(V)
+ *   else
+ *     V <- rightshit(V) XOR R
+ *   end if
+ * end for
+ * return Z
+ *
+ * With 32 and 64bit words the 256bit carry-less product is formed by
+ * Karatsuba from word multiplies with the operand bits spread four apart
+ * (so carries land in masked out holes), then reduced. The high half of
+ * each word product is the low half of the product of the bit reversed
+ * operands. There are no branches or lookups on secret data.
+ *
+ * */
+static void xormul128(moda_word_t *x, const moda_word_t *text, const moda_word_t *y);
+
+#if (MODA_WORD_SIZE == 8U)
+/**
+ * Low 64 bits of the carry-less product of two words
+ *
+ * @param[in] x
+ * @param[in] y
+ * @return x . y mod 2^64
+ *
+ * */
+static uint64_t bmul64(uint64_t x, uint64_t y);
+
+/**
+ * Reverse the bits of a word
+ *
+ * @param[in] x
+ * @return bit reversed x
+ *
+ * */
+static uint64_t rev64(uint64_t x);
+
+#elif (MODA_WORD_SIZE == 4U)
+/**
+ * Low 32 bits of the carry-less product of two words
+ *
+ * @param[in] x
+ * @param[in] y
+ * @return x . y mod 2^32
+ *
+ * */
+static uint32_t bmul32(uint32_t x, uint32_t y);
+
+/**
+ * Reverse the bits of a word
+ *
+ * @param[in] x
+ * @return bit reversed x
+ *
+ * */
+static uint32_t rev32(uint32_t x);
+
+/**
+ * Carry-less 64bit product of two 32bit words
+ *
+ * @param[in] x
+ * @param[in] y
+ * @param[out] r two words, least significant first
+ *
+ * */
+static void clmul32(uint32_t x, uint32_t y, uint32_t *r);
+
+/**
+ * Carry-less 128bit product of two 64bit values (Karatsuba)
+ *
+ * @param[in] x two words, least significant first
+ * @param[in] y two words, least significant first
+ * @param[out] r four words, least significant first
+ *
+ * */
+static void clmul64(const uint32_t *x, const uint32_t *y, uint32_t *r);
+#endif
+
+/**
+ * Multiply by x (one bit right shift with reduction) a 128bit vector
+ * held as big endian halves
+ *
+ * @param[in/out] hi bits 0..63
+ * @param[in/out] lo bits 64..127
+ *
+ * */
+static void mulx(uint64_t *hi, uint64_t *lo);
+
+/**
+ * Multiply by x^8 a 128bit vector held as big endian halves
+ *
+ * @param[in/out] hi bits 0..63
+ * @param[in/out] lo bits 64..127
+ *
+ * */
+static void mulx8(uint64_t *hi, uint64_t *lo);
+
+/**
+ * Fill a Shoup table with every multiple of H by a 4bit or 8bit value
+ *
+ * Entries are (hi, lo) pairs, entry i being H multiplied by the
+ * polynomial whose coefficients are the bits of i.
+ *
+ * @param[out] table 2 * `entries` words
+ * @param[in] entries 16 or 256
+ * @param[in] h hash subkey as GCM bytes
+ *
+ * */
+static void shoupTable(uint64_t *table, uint32_t entries, const uint8_t *h);
+
+/**
+ * Multiply an aligned block by H with a table from MODA_AES_GCM_InitTable()
+ *
+ * @param[in] key GHASH key
+ * @param[in/out] x block as GCM bytes
+ *
+ * */
+static void tableMul(const struct ghash_key *key, moda_word_t *x);
+
+/**
+ * One GHASH step: X = (X XOR text) . H
+ *
+ * Uses the table attached to `key` if there is one, otherwise xormul128().
+ *
+ * @param[in] key GHASH key
+ * @param[in/out] x hash state
+ * @param[in] text block to absorb
+ *
+ * */
+static void ghash(const struct ghash_key *key, moda_word_t *x, const moda_word_t *text);
+
+/**
+ * GHASH a buffer, zero padding the final partial block
+ *
+ * @param[in] key GHASH key
+ * @param[in/out] x hash state
+ * @param[in] in bytes to absorb (any alignment)
+ * @param[in] size size of `in`
+ *
+ * */
+static void ghashBytes(const struct ghash_key *key, moda_word_t *x, const uint8_t *in, size_t size);
+
+/**
+ * Increment an unaligned big endian 32bit counter
+ *
+ * @param[in] counter pointer to MSB of counter field
+ *
+ * */
+static void incrementCounter(uint8_t *counter);
+
+/**
+ * Derive the hash subkey in the word order used by xormul128()
+ *
+ * @param[in] aes context
+ * @param[out] h hash subkey
+ *
+ * */
+static void hashKey(const struct aes_ctxt *aes, moda_word_t *h);
+
+#if defined(MODA_GCM_PCLMUL)
+/**
+ * Derive the powers of H used by PCLMULQDQ GHASH if the host has it
+ *
+ * @param[in] h hash subkey from hashKey()
+ * @param[out] hpow powers of H
+ * @return `hpow`, or NULL if PCLMULQDQ is not available
+ *
+ * */
+static const uint8_t *hashPowers(const moda_word_t *h, uint8_t *hpow);
+#endif
+
+/**
+ * Load the GHASH key of a GCM key
+ *
+ * @param[in] gcm GCM key
+ * @param[out] key GHASH key
+ *
+ * */
+static void gcmKey(const struct aes_gcm_ctxt *gcm, struct ghash_key *key);
+
+/**
+ * Derive the initial counter block J0 from an IV
+ *
+ * @param[in] key GHASH key
+ * @param[in] iv initialisation vector
+ * @param[in] ivSize size of *IV in bytes
+ * @param[out] counter J0
+ *
+ * */
+static void initialCounter(const struct ghash_key *key, const uint8_t *iv, uint32_t ivSize, moda_word_t *counter);
+
+/**
+ * Encrypt/decrypt with the counters after `counter` and GHASH the cipher text
+ *
+ * The final block may be partial, in which case it is zero padded for
+ * GHASH.
+ *
+ * @param[in] aes context
+ * @param[in] key GHASH key (NULL for counter mode only)
+ * @param[in/out] counter last counter block used
+ * @param[in/out] x GHASH state
+ * @param[out] out output buffer
+ * @param[in] in input buffer
+ * @param[in] textSize size of *in or *out in bytes
+ * @param[in] encrypt encrypt/decrypt boolean
+ *
+ * */
+static void cryptText(const struct aes_ctxt *aes, const struct ghash_key *key, moda_word_t *counter, moda_word_t *x, uint8_t *out, const uint8_t *in, size_t textSize, bool encrypt);
+
+/**
+ * Make the GHASH length block: [aadSize]64 || [textSize]64 in bits
+ *
+ * @param[out] block
+ * @param[in] aadSize bytes of AAD
+ * @param[in] textSize bytes of text
+ *
+ * */
+static void lengthBlock(moda_word_t *block, uint64_t aadSize, uint64_t textSize);
+
+/**
+ * Zero pad and GHASH the partial block of a stream
+ *
+ * @param[in] key GHASH key
+ * @param[in/out] s stream
+ * @param[in] pos bytes in the partial block
+ *
+ * */
+static void streamFlush(const struct ghash_key *key, struct aes_gcm_stream *s, size_t pos);
+
+/**
+ * Encrypt/decrypt text into the partial block of a stream with the saved key stream
+ *
+ * @param[in/out] s stream
+ * @param[out] out output buffer
+ * @param[in] in input buffer
+ * @param[in] size bytes available
+ * @param[in] pos bytes already in the partial block
+ * @return bytes used (until the block is full or `size` is exhausted)
+ *
+ * */
+static size_t streamBytes(struct aes_gcm_stream *s, uint8_t *out, const uint8_t *in, size_t size, size_t pos);
+
+/**
+ * Complete a stream and compute its tag
+ *
+ * @param[in/out] s stream
+ * @param[out] x tag
+ *
+ * */
+static void streamTag(struct aes_gcm_stream *s, moda_word_t *x);
+
+/**
+ * Seal or open a burst of packets
+ *
+ * @param[in] gcm GCM key
+ * @param[in] pkt packets
+ * @param[in] n number of packets
+ * @param[in] encrypt encrypt/decrypt boolean
+ * @return number of valid packets (when decrypting)
+ *
+ * */
+static size_t burstCrypt(const struct aes_gcm_ctxt *gcm, struct aes_gcm_packet *pkt, size_t n, bool encrypt);
+
+/**
+ * Add to the 32bit counter field of a counter block (modulo 2^32)
+ *
+ * @param[in/out] counter
+ * @param[in] n
+ *
+ * */
+static void addCounter(uint8_t *counter, uint32_t n);
+
+/**
+ * Multiply two blocks in GCM byte order: x = x * y
+ *
+ * @param[in/out] x
+ * @param[in] y
+ *
+ * */
+static void mulBlock(moda_word_t *x, const moda_word_t *y);
+
+/**
+ * Raise the hash subkey to a power in GCM byte order
+ *
+ * @param[in] h hash subkey from hashKey()
+ * @param[in] n exponent
+ * @param[out] y H^n
+ *
+ * */
+static void hashPower(const moda_word_t *h, size_t n, moda_word_t *y);
+
+/**
+ * Merge the shares of a parallel operation and compute its tag
+ *
+ * @param[in] p parallel state
+ * @param[in] share partial GHASH of every share
+ * @param[out] x tag
+ *
+ * */
+static void parallelTag(const struct aes_gcm_parallel *p, const struct aes_gcm_share *share, moda_word_t *x);
+
+/**
+ * GCM implementation
+ *
+ * @param[in] aes context
+ * @param[in] key GHASH key
+ * @param[in] iv initialisation vector
+ * @param[in] ivSize size of *IV in bytes
+ * @param[out] out cipher output buffer
+ * @param[in] in cipher input buffer
+ * @param[in] textSize size of *in or *out in bytes
+ * @param[in] aad additional non-ciphered data for authentication
+ * @param[in] aadSize size of *aad
+ * @param[in] encrypt encrypt/decrypt boolean
+ * @param[out] XX GMAC output
+ * 
+ * */
+static void gcmCrypt(const struct aes_ctxt *aes, const struct ghash_key *key, const uint8_t *iv, uint32_t ivSize, uint8_t *out, const uint8_t *in, uint32_t textSize, const uint8_t *aad, uint32_t aadSize, bool encrypt, moda_word_t *x);
+
+
+/* functions **********************************************************/
+
+void MODA_AES_GCM_Encrypt(const struct aes_ctxt *aes, const uint8_t *iv, uint32_t ivSize, uint8_t *out, const uint8_t *in, uint32_t textSize, const uint8_t *aad, uint32_t aadSize, uint8_t *t, uint8_t tSize)
+{
+    moda_word_t x[WORD_BLOCK_SIZE];
+    moda_word_t h[WORD_BLOCK_SIZE];
+    struct ghash_key key = {h, NULL, 0U};
+#if defined(MODA_GCM_PCLMUL)
+    uint8_t hpow[MODA_GCM_PCLMUL_POWERS * AES_BLOCK_SIZE];
+#endif
+
+    ASSERT((aes != NULL))
+    ASSERT((tSize <= GCM_TAG_SIZE))
+    
+    hashKey(aes, h);
+#if defined(MODA_GCM_PCLMUL)
+    key.hpow = hashPowers(h, hpow);
+#endif
+    gcmCrypt(aes, &key, iv, ivSize, out, in, textSize, aad, aadSize, true, x);
+    (void)memcpy(t, x, (size_t)tSize);
+
+    /* clear h on stack */
+    xor128(h, h);
+#if defined(MODA_GCM_PCLMUL)
+    (void)memset(hpow, 0, sizeof(hpow));
+#endif
+}
+
+bool MODA_AES_GCM_Decrypt(const struct aes_ctxt *aes, const uint8_t *iv, uint32_t ivSize, uint8_t *out, const uint8_t *in, uint32_t textSize, const uint8_t *aad, uint32_t aadSize, const uint8_t *t, uint8_t tSize)
+{
+    moda_word_t x[WORD_BLOCK_SIZE];
+    moda_word_t h[WORD_BLOCK_SIZE];
+    struct ghash_key key = {h, NULL, 0U};
+#if defined(MODA_GCM_PCLMUL)
+    uint8_t hpow[MODA_GCM_PCLMUL_POWERS * AES_BLOCK_SIZE];
+#endif
+
+    ASSERT((aes != NULL))
+    ASSERT((tSize <= GCM_TAG_SIZE))
+    
+    hashKey(aes, h);
+#if defined(MODA_GCM_PCLMUL)
+    key.hpow = hashPowers(h, hpow);
+#endif
+    gcmCrypt(aes, &key, iv, ivSize, out, in, textSize, aad, aadSize, false, x);
+
+    /* clear h on stack */
+    xor128(h, h);
+#if defined(MODA_GCM_PCLMUL)
+    (void)memset(hpow, 0, sizeof(hpow));
+#endif
+
+    return (memcmp(x, t, (size_t)tSize) == 0);
+}
+
+void MODA_AES_GCM_Init(struct aes_gcm_ctxt *gcm, enum aes_key_size keySize, const uint8_t *key)
+{
+    ASSERT((gcm != NULL))
+
+    MODA_AES_Init(&gcm->aes, keySize, key);
+    hashKey(&gcm->aes, (moda_word_t *)gcm->h);
+#if defined(MODA_GCM_PCLMUL)
+    (void)hashPowers((const moda_word_t *)gcm->h, gcm->hpow);
+#endif
+    gcm->table = NULL;
+    gcm->tableSize = 0U;
+}
+
+void MODA_AES_GCM_InitTable(struct aes_gcm_ctxt *gcm, void *table, size_t tableSize)
+{
+    uint64_t *t = (uint64_t *)table;
+    uint8_t h[AES_BLOCK_SIZE];
+    size_t i;
+
+    ASSERT((gcm != NULL))
+    ASSERT((table != NULL))
+    ASSERT((((uintptr_t)table % sizeof(uint64_t)) == 0U))
+    ASSERT(((tableSize == AES_GCM_TABLE_4BIT) || (tableSize == AES_GCM_TABLE_8BIT) || (tableSize == AES_GCM_TABLE_64K)))
+
+    /* GCM byte order of H */
+    (void)memset(h, 0, sizeof(h));
+    MODA_AES_Encrypt(&gcm->aes, h);
+
+    if(tableSize == AES_GCM_TABLE_4BIT){
+
+        shoupTable(t, 16U, h);
+    }
+    else{
+
+        shoupTable(t, 256U, h);
+
+        /* each further 4KB is the previous multiplied by x^8, so that
+         * byte position p indexes table p and no reduction is left to
+         * do per block */
+        if(tableSize == AES_GCM_TABLE_64K){
+
+            for(i=512U; i < (AES_GCM_TABLE_64K / sizeof(uint64_t)); i += 2U){
+
+                t[i] = t[i - 512U];
+                t[i + 1U] = t[i - 511U];
+                mulx8(&t[i], &t[i + 1U]);
+            }
+        }
+    }
+
+    gcm->table = table;
+    gcm->tableSize = tableSize;
+
+    (void)memset(h, 0, sizeof(h));
+}
+
+void MODA_AES_GCM_Seal(const struct aes_gcm_ctxt *gcm, const uint8_t *iv, uint32_t ivSize, uint8_t *out, const uint8_t *in, uint32_t textSize, const uint8_t *aad, uint32_t aadSize, uint8_t *t, uint8_t tSize)
+{
+    moda_word_t x[WORD_BLOCK_SIZE];
+    struct ghash_key key;
+
+    ASSERT((gcm != NULL))
+    ASSERT((tSize <= GCM_TAG_SIZE))
+
+    gcmKey(gcm, &key);
+
+    gcmCrypt(&gcm->aes, &key, iv, ivSize, out, in, textSize, aad, aadSize, true, x);
+    (void)memcpy(t, x, (size_t)tSize);
+}
+
+bool MODA_AES_GCM_Open(const struct aes_gcm_ctxt *gcm, const uint8_t *iv, uint32_t ivSize, uint8_t *out, const uint8_t *in, uint32_t textSize, const uint8_t *aad, uint32_t aadSize, const uint8_t *t, uint8_t tSize)
+{
+    moda_word_t x[WORD_BLOCK_SIZE];
+    struct ghash_key key;
+
+    ASSERT((gcm != NULL))
+    ASSERT((tSize <= GCM_TAG_SIZE))
+
+    gcmKey(gcm, &key);
+
+    gcmCrypt(&gcm->aes, &key, iv, ivSize, out, in, textSize, aad, aadSize, false, x);
+
+    return (memcmp(x, t, (size_t)tSize) == 0);
+}
+
+bool MODA_AES_GCM_OpenVerified(const struct aes_gcm_ctxt *gcm, const uint8_t *iv, uint32_t ivSize, uint8_t *out, const uint8_t *in, uint32_t textSize, const uint8_t *aad, uint32_t aadSize, const uint8_t *t, uint8_t tSize)
+{
+    moda_word_t x[WORD_BLOCK_SIZE];
+    moda_word_t counter[WORD_BLOCK_SIZE];
+    moda_word_t encryptedInitialCounter[WORD_BLOCK_SIZE];
+    moda_word_t sizeBlock[WORD_BLOCK_SIZE];
+    struct ghash_key key;
+    bool retval;
+
+    ASSERT((gcm != NULL))
+    ASSERT((tSize <= GCM_TAG_SIZE))
+
+    gcmKey(gcm, &key);
+
+    initialCounter(&key, iv, ivSize, counter);
+    MODA_AES_EncryptBlocks(&gcm->aes, (uint8_t *)encryptedInitialCounter, (uint8_t *)counter, 1U);
+
+    /* tag from the cipher text alone */
+    (void)memset(x, 0, sizeof(x));
+    ghashBytes(&key, x, aad, (size_t)aadSize);
+    ghashBytes(&key, x, in, (size_t)textSize);
+
+    lengthBlock(sizeBlock, (uint64_t)aadSize, (uint64_t)textSize);
+    ghash(&key, x, sizeBlock);
+    xor128(x, encryptedInitialCounter);
+
+    retval = (memcmp(x, t, (size_t)tSize) == 0);
+
+    if(retval){
+
+        cryptText(&gcm->aes, NULL, counter, x, out, in, (size_t)textSize, false);
+    }
+    else{
+
+        GCM_COUNT(&rejected);
+    }
+
+    return retval;
+}
+
+uint32_t MODA_AES_GCM_Rejected(void)
+{
+    return GCM_READ(&rejected);
+}
+
+void MODA_AES_GCM_StreamInit(struct aes_gcm_stream *s, const struct aes_gcm_ctxt *gcm, const uint8_t *iv, uint32_t ivSize, bool encrypt)
+{
+    struct ghash_key key;
+
+    ASSERT((s != NULL))
+    ASSERT((gcm != NULL))
+
+    gcmKey(gcm, &key);
+
+    s->gcm = gcm;
+    s->encrypt = encrypt;
+    s->aadSize = 0U;
+    s->textSize = 0U;
+
+    (void)memset(s->x, 0, sizeof(s->x));
+
+    initialCounter(&key, iv, ivSize, (moda_word_t *)s->counter);
+    MODA_AES_EncryptBlocks(&gcm->aes, s->ek0, s->counter, 1U);
+}
+
+void MODA_AES_GCM_StreamAAD(struct aes_gcm_stream *s, const uint8_t *aad, size_t aadSize)
+{
+    struct ghash_key key;
+    size_t pos;
+    size_t n = 0U;
+    size_t whole;
+
+    ASSERT((s != NULL))
+    ASSERT((s->textSize == 0U))
+    ASSERT(((uint64_t)aadSize <= (GCM_AAD_MAX - s->aadSize)))
+
+    gcmKey(s->gcm, &key);
+
+    pos = (size_t)(s->aadSize % AES_BLOCK_SIZE);
+    s->aadSize += (uint64_t)aadSize;
+
+    /* top up a partial block */
+    if(pos > 0U){
+
+        n = AES_BLOCK_SIZE - pos;
+        n = (aadSize < n) ? aadSize : n;
+
+        (void)memcpy(&s->part[pos], aad, n);
+
+        if((pos + n) == AES_BLOCK_SIZE){
+
+            ghash(&key, (moda_word_t *)s->x, (const moda_word_t *)s->part);
+        }
+    }
+
+    if(n < aadSize){
+
+        whole = (aadSize - n) - ((aadSize - n) % AES_BLOCK_SIZE);
+
+        ghashBytes(&key, (moda_word_t *)s->x, &aad[n], whole);
+        (void)memcpy(s->part, &aad[n + whole], aadSize - (n + whole));
+    }
+}
+
+void MODA_AES_GCM_StreamUpdate(struct aes_gcm_stream *s, uint8_t *out, const uint8_t *in, size_t textSize)
+{
+    struct ghash_key key;
+    size_t pos;
+    size_t n = 0U;
+    size_t whole;
+
+    ASSERT((s != NULL))
+    ASSERT(((uint64_t)textSize <= (GCM_TEXT_MAX - s->textSize)))
+
+    if(textSize > 0U){
+
+        gcmKey(s->gcm, &key);
+
+        /* the first text closes the AAD */
+        if((s->textSize == 0U) && ((s->aadSize % AES_BLOCK_SIZE) != 0U)){
+
+            streamFlush(&key, s, (size_t)(s->aadSize % AES_BLOCK_SIZE));
+        }
+
+        pos = (size_t)(s->textSize % AES_BLOCK_SIZE);
+        s->textSize += (uint64_t)textSize;
+
+        /* finish a partial block with the saved key stream */
+        if(pos > 0U){
+
+            n = streamBytes(s, out, in, textSize, pos);
+
+            if((pos + n) == AES_BLOCK_SIZE){
+
+                ghash(&key, (moda_word_t *)s->x, (const moda_word_t *)s->part);
+            }
+        }
+
+        if(n < textSize){
+
+            whole = (textSize - n) - ((textSize - n) % AES_BLOCK_SIZE);
+
+            cryptText(&s->gcm->aes, &key, (moda_word_t *)s->counter, (moda_word_t *)s->x, &out[n], &in[n], whole, s->encrypt);
+            n += whole;
+
+            /* start a partial block and keep its key stream */
+            if(n < textSize){
+
+                incrementCounter(s->counter);
+                MODA_AES_EncryptBlocks(&s->gcm->aes, s->ks, s->counter, 1U);
+
+                (void)streamBytes(s, &out[n], &in[n], textSize - n, 0U);
+            }
+        }
+    }
+}
+
+void MODA_AES_GCM_StreamFinal(struct aes_gcm_stream *s, uint8_t *t, uint8_t tSize)
+{
+    moda_word_t x[WORD_BLOCK_SIZE];
+
+    ASSERT((s != NULL))
+    ASSERT((tSize <= GCM_TAG_SIZE))
+
+    streamTag(s, x);
+    (void)memcpy(t, x, (size_t)tSize);
+}
+
+bool MODA_AES_GCM_StreamCheck(struct aes_gcm_stream *s, const uint8_t *t, uint8_t tSize)
+{
+    moda_word_t x[WORD_BLOCK_SIZE];
+
+    ASSERT((s != NULL))
+    ASSERT((tSize <= GCM_TAG_SIZE))
+
+    streamTag(s, x);
+
+    return (memcmp(x, t, (size_t)tSize) == 0);
+}
+
+void MODA_AES_GCM_SealBurst(const struct aes_gcm_ctxt *gcm, struct aes_gcm_packet *pkt, size_t n)
+{
+    ASSERT((gcm != NULL))
+    ASSERT(((pkt != NULL) || (n == 0U)))
+
+    (void)burstCrypt(gcm, pkt, n, true);
+}
+
+size_t MODA_AES_GCM_OpenBurst(const struct aes_gcm_ctxt *gcm, struct aes_gcm_packet *pkt, size_t n)
+{
+    ASSERT((gcm != NULL))
+    ASSERT(((pkt != NULL) || (n == 0U)))
+
+    return burstCrypt(gcm, pkt, n, false);
+}
+
+size_t MODA_AES_GCM_ParallelInit(struct aes_gcm_parallel *p, const struct aes_gcm_ctxt *gcm, const uint8_t *iv, uint32_t ivSize, const uint8_t *aad, size_t aadSize, size_t textSize, size_t shares, bool encrypt)
+{
+    struct ghash_key key;
+    size_t blocks;
+    size_t perShare;
+
+    ASSERT((p != NULL))
+    ASSERT((gcm != NULL))
+    ASSERT((shares > 0U))
+    ASSERT(((uint64_t)textSize <= GCM_TEXT_MAX))
+
+    gcmKey(gcm, &key);
+
+    p->gcm = gcm;
+    p->encrypt = encrypt;
+    p->aadSize = (uint64_t)aadSize;
+    p->textSize = textSize;
+
+    initialCounter(&key, iv, ivSize, (moda_word_t *)p->counter);
+    MODA_AES_EncryptBlocks(&gcm->aes, p->ek0, p->counter, 1U);
+
+    (void)memset(p->x, 0, sizeof(p->x));
+    ghashBytes(&key, (moda_word_t *)p->x, aad, aadSize);
+
+    /* whole blocks per share, so only the last share has a partial block */
+    blocks = (textSize + (AES_BLOCK_SIZE - 1U)) / AES_BLOCK_SIZE;
+    perShare = (blocks + (shares - 1U)) / shares;
+
+    p->shareSize = perShare * AES_BLOCK_SIZE;
+    p->shares = (perShare > 0U) ? ((blocks + (perShare - 1U)) / perShare) : 0U;
+
+    return p->shares;
+}
+
+void MODA_AES_GCM_ParallelShare(const struct aes_gcm_parallel *p, size_t i, uint8_t *out, const uint8_t *in, struct aes_gcm_share *share)
+{
+    struct ghash_key key;
+    moda_word_t counter[WORD_BLOCK_SIZE];
+    size_t pos;
+    size_t size;
+
+    ASSERT((p != NULL))
+    ASSERT((i < p->shares))
+    ASSERT((share != NULL))
+
+    gcmKey(p->gcm, &key);
+
+    pos = i * p->shareSize;
+    size = ((p->textSize - pos) < p->shareSize) ? (p->textSize - pos) : p->shareSize;
+
+    /* counters of earlier shares are skipped */
+    copy128(counter, (const moda_word_t *)p->counter);
+    addCounter((uint8_t *)counter, (uint32_t)(pos / AES_BLOCK_SIZE));
+
+    (void)memset(share->x, 0, sizeof(share->x));
+
+    cryptText(&p->gcm->aes, &key, counter, (moda_word_t *)share->x, &out[pos], &in[pos], size, p->encrypt);
+}
+
+void MODA_AES_GCM_ParallelFinal(const struct aes_gcm_parallel *p, const struct aes_gcm_share *share, uint8_t *t, uint8_t tSize)
+{
+    moda_word_t x[WORD_BLOCK_SIZE];
+
+    ASSERT((p != NULL))
+    ASSERT((tSize <= GCM_TAG_SIZE))
+
+    parallelTag(p, share, x);
+    (void)memcpy(t, x, (size_t)tSize);
+}
+
+bool MODA_AES_GCM_ParallelCheck(const struct aes_gcm_parallel *p, const struct aes_gcm_share *share, const uint8_t *t, uint8_t tSize)
+{
+    moda_word_t x[WORD_BLOCK_SIZE];
+
+    ASSERT((p != NULL))
+    ASSERT((tSize <= GCM_TAG_SIZE))
+
+    parallelTag(p, share, x);
+
+    return (memcmp(x, t, (size_t)tSize) == 0);
+}
+
+/* static functions  **************************************************/
+
+static void xor128(moda_word_t *acc, const moda_word_t *mask)
+{
+    uint8_t i;
+    for(i=0U; i < WORD_BLOCK_SIZE; i++){
+
+        acc[i] ^= mask[i];
+    }
+}
+
+static void copy128(moda_word_t *MODA_RESTRICT to, const moda_word_t *MODA_RESTRICT from)
+{
+    uint8_t i;
+    for(i=0U; i < WORD_BLOCK_SIZE; i++){
+
+        to[i] = from[i];
+    }
+}
+
+#if (MODA_WORD_SIZE > 1U)
+#ifndef MODA_BIG_ENDIAN
+static moda_word_t swapw(moda_word_t w)
+{
+#if MODA_WORD_SIZE == 1U 
+    return w;
+#elif MODA_WORD_SIZE == 2U
+    return ((w >> 8U) & 0xffU) | ((w << 8U) & 0xff00U);    
+#elif MODA_WORD_SIZE == 4U
+    return  ((w << 24U) & 0xff000000U)    |
+            ((w <<  8U) & 0xff0000U)      |
+            ((w >>  8U) & 0xff00U)        |
+            ((w >> 24U) & 0xffU);
+#else
+    return  ((w << 56U) & 0xff00000000000000U)    |
+            ((w << 40U) & 0xff000000000000U)      |
+            ((w << 24U) & 0xff0000000000U)        |
+            ((w <<  8U) & 0xff00000000U)          |
+            ((w >>  8U) & 0xff000000U)            |
+            ((w >> 24U) & 0xff0000U)              |
+            ((w >> 40U) & 0xff00U)                |
+            ((w >> 56U) & 0xffU);            
+#endif
+}
+
+static void swapBlock(moda_word_t *block)
+{
+    uint8_t i;
+    for(i=0; i < WORD_BLOCK_SIZE; i++){
+
+        block[i] = swapw(block[i]);
+    }
+}
+#endif
+#endif
+
+#if (MODA_WORD_SIZE == 8U)
+static void xormul128(moda_word_t *x, const moda_word_t *text, const moda_word_t *y)
+{
+    uint64_t x0;
+    uint64_t x1;
+    uint64_t x2;
+    uint64_t x0r;
+    uint64_t x1r;
+    uint64_t x2r;
+    uint64_t y0 = y[1];
+    uint64_t y1 = y[0];
+    uint64_t y2 = y0 ^ y1;
+    uint64_t y0r = rev64(y0);
+    uint64_t y1r = rev64(y1);
+    uint64_t y2r = y0r ^ y1r;
+    uint64_t z0;
+    uint64_t z1;
+    uint64_t z2;
+    uint64_t z0h;
+    uint64_t z1h;
+    uint64_t z2h;
+    uint64_t v0;
+    uint64_t v1;
+    uint64_t v2;
+    uint64_t v3;
+
+    if(text != NULL){
+
+        xor128(x, text);
+    }
+
+    /* one conversion to big endian words per block */
+#ifndef MODA_BIG_ENDIAN
+    x0 = swapw(x[1]);
+    x1 = swapw(x[0]);
+#else
+    x0 = x[1];
+    x1 = x[0];
+#endif
+    x2 = x0 ^ x1;
+    x0r = rev64(x0);
+    x1r = rev64(x1);
+    x2r = x0r ^ x1r;
+
+    z0 = bmul64(x0, y0);
+    z1 = bmul64(x1, y1);
+    z2 = bmul64(x2, y2);
+    z0h = bmul64(x0r, y0r);
+    z1h = bmul64(x1r, y1r);
+    z2h = bmul64(x2r, y2r);
+    z2 ^= z0 ^ z1;
+    z2h ^= z0h ^ z1h;
+    z0h = rev64(z0h) >> 1;
+    z1h = rev64(z1h) >> 1;
+    z2h = rev64(z2h) >> 1;
+
+    v0 = z0;
+    v1 = z0h ^ z2;
+    v2 = z1 ^ z2h;
+    v3 = z1h;
+
+    /* the product of reflected operands is one bit short */
+    v3 = (v3 << 1U) | (v2 >> 63U);
+    v2 = (v2 << 1U) | (v1 >> 63U);
+    v1 = (v1 << 1U) | (v0 >> 63U);
+    v0 = (v0 << 1U);
+
+    /* reduce modulo x^128 + x^7 + x^2 + x + 1 */
+    v2 ^= v0 ^ (v0 >> 1U) ^ (v0 >> 2U) ^ (v0 >> 7U);
+    v1 ^= (v0 << 63U) ^ (v0 << 62U) ^ (v0 << 57U);
+    v3 ^= v1 ^ (v1 >> 1U) ^ (v1 >> 2U) ^ (v1 >> 7U);
+    v2 ^= (v1 << 63U) ^ (v1 << 62U) ^ (v1 << 57U);
+
+#ifndef MODA_BIG_ENDIAN
+    x[0] = swapw(v3);
+    x[1] = swapw(v2);
+#else
+    x[0] = v3;
+    x[1] = v2;
+#endif
+}
+
+static uint64_t bmul64(uint64_t x, uint64_t y)
+{
+    uint64_t x0 = x & 0x1111111111111111U;
+    uint64_t x1 = x & 0x2222222222222222U;
+    uint64_t x2 = x & 0x4444444444444444U;
+    uint64_t x3 = x & 0x8888888888888888U;
+    uint64_t y0 = y & 0x1111111111111111U;
+    uint64_t y1 = y & 0x2222222222222222U;
+    uint64_t y2 = y & 0x4444444444444444U;
+    uint64_t y3 = y & 0x8888888888888888U;
+    uint64_t z0 = (x0 * y0) ^ (x1 * y3) ^ (x2 * y2) ^ (x3 * y1);
+    uint64_t z1 = (x0 * y1) ^ (x1 * y0) ^ (x2 * y3) ^ (x3 * y2);
+    uint64_t z2 = (x0 * y2) ^ (x1 * y1) ^ (x2 * y0) ^ (x3 * y3);
+    uint64_t z3 = (x0 * y3) ^ (x1 * y2) ^ (x2 * y1) ^ (x3 * y0);
+
+    return  (z0 & 0x1111111111111111U) |
+            (z1 & 0x2222222222222222U) |
+            (z2 & 0x4444444444444444U) |
+            (z3 & 0x8888888888888888U);
+}
+
+static uint64_t rev64(uint64_t x)
+{
+    x = ((x & 0x5555555555555555U) << 1U) | ((x >> 1U) & 0x5555555555555555U);
+    x = ((x & 0x3333333333333333U) << 2U) | ((x >> 2U) & 0x3333333333333333U);
+    x = ((x & 0x0f0f0f0f0f0f0f0fU) << 4U) | ((x >> 4U) & 0x0f0f0f0f0f0f0f0fU);
+    x = ((x & 0x00ff00ff00ff00ffU) << 8U) | ((x >> 8U) & 0x00ff00ff00ff00ffU);
+    x = ((x & 0x0000ffff0000ffffU) << 16U) | ((x >> 16U) & 0x0000ffff0000ffffU);
+
+    return (x << 32U) | (x >> 32U);
+}
+
+#elif (MODA_WORD_SIZE == 4U)
+static void xormul128(moda_word_t *x, const moda_word_t *text, const moda_word_t *y)
+{
+    uint32_t a[4U];
+    uint32_t b[4U];
+    uint32_t am[2U];
+    uint32_t bm[2U];
+    uint32_t lo[4U];
+    uint32_t hi[4U];
+    uint32_t mid[4U];
+    uint32_t z[8U];
+    uint32_t t;
+    uint8_t i;
+
+    if(text != NULL){
+
+        xor128(x, text);
+    }
+
+    /* one conversion to big endian words per block, least significant first */
+    for(i=0U; i < 4U; i++){
+
+#ifndef MODA_BIG_ENDIAN
+        a[3U - i] = swapw(x[i]);
+#else
+        a[3U - i] = x[i];
+#endif
+        b[3U - i] = y[i];
+    }
+
+    am[0] = a[0] ^ a[2];
+    am[1] = a[1] ^ a[3];
+    bm[0] = b[0] ^ b[2];
+    bm[1] = b[1] ^ b[3];
+
+    clmul64(a, b, lo);
+    clmul64(&a[2], &b[2], hi);
+    clmul64(am, bm, mid);
+
+    for(i=0U; i < 4U; i++){
+
+        mid[i] ^= lo[i] ^ hi[i];
+    }
+
+    z[0] = lo[0];
+    z[1] = lo[1];
+    z[2] = lo[2] ^ mid[0];
+    z[3] = lo[3] ^ mid[1];
+    z[4] = hi[0] ^ mid[2];
+    z[5] = hi[1] ^ mid[3];
+    z[6] = hi[2];
+    z[7] = hi[3];
+
+    /* the product of reflected operands is one bit short */
+    for(i=7U; i > 0U; i--){
+
+        z[i] = (z[i] << 1U) | (z[i - 1U] >> 31U);
+    }
+
+    z[0] <<= 1U;
+
+    /* reduce modulo x^128 + x^7 + x^2 + x + 1, one word at a time */
+    for(i=0U; i < 4U; i++){
+
+        t = z[i];
+        z[i + 4U] ^= t ^ (t >> 1U) ^ (t >> 2U) ^ (t >> 7U);
+        z[i + 3U] ^= (t << 31U) ^ (t << 30U) ^ (t << 25U);
+    }
+
+    for(i=0U; i < 4U; i++){
+
+#ifndef MODA_BIG_ENDIAN
+        x[i] = swapw(z[7U - i]);
+#else
+        x[i] = z[7U - i];
+#endif
+    }
+}
+
+static uint32_t bmul32(uint32_t x, uint32_t y)
+{
+    uint32_t x0 = x & 0x11111111U;
+    uint32_t x1 = x & 0x22222222U;
+    uint32_t x2 = x & 0x44444444U;
+    uint32_t x3 = x & 0x88888888U;
+    uint32_t y0 = y & 0x11111111U;
+    uint32_t y1 = y & 0x22222222U;
+    uint32_t y2 = y & 0x44444444U;
+    uint32_t y3 = y & 0x88888888U;
+    uint32_t z0 = (x0 * y0) ^ (x1 * y3) ^ (x2 * y2) ^ (x3 * y1);
+    uint32_t z1 = (x0 * y1) ^ (x1 * y0) ^ (x2 * y3) ^ (x3 * y2);
+    uint32_t z2 = (x0 * y2) ^ (x1 * y1) ^ (x2 * y0) ^ (x3 * y3);
+    uint32_t z3 = (x0 * y3) ^ (x1 * y2) ^ (x2 * y1) ^ (x3 * y0);
+
+    return  (z0 & 0x11111111U) |
+            (z1 & 0x22222222U) |
+            (z2 & 0x44444444U) |
+            (z3 & 0x88888888U);
+}
+
+static uint32_t rev32(uint32_t x)
+{
+    x = ((x & 0x55555555U) << 1U) | ((x >> 1U) & 0x55555555U);
+    x = ((x & 0x33333333U) << 2U) | ((x >> 2U) & 0x33333333U);
+    x = ((x & 0x0f0f0f0fU) << 4U) | ((x >> 4U) & 0x0f0f0f0fU);
+    x = ((x & 0x00ff00ffU) << 8U) | ((x >> 8U) & 0x00ff00ffU);
+
+    return (x << 16U) | (x >> 16U);
+}
+
+static void clmul32(uint32_t x, uint32_t y, uint32_t *r)
+{
+    r[0] = bmul32(x, y);
+    r[1] = rev32(bmul32(rev32(x), rev32(y))) >> 1U;
+}
+
+static void clmul64(const uint32_t *x, const uint32_t *y, uint32_t *r)
+{
+    uint32_t lo[2U];
+    uint32_t hi[2U];
+    uint32_t mid[2U];
+
+    clmul32(x[0], y[0], lo);
+    clmul32(x[1], y[1], hi);
+    clmul32(x[0] ^ x[1], y[0] ^ y[1], mid);
+
+    mid[0] ^= lo[0] ^ hi[0];
+    mid[1] ^= lo[1] ^ hi[1];
+
+    r[0] = lo[0];
+    r[1] = lo[1] ^ mid[0];
+    r[2] = hi[0] ^ mid[1];
+    r[3] = hi[1];
+}
+
+#else
+static void xormul128(moda_word_t *x, const moda_word_t *text, const moda_word_t *y)
+{
+    moda_word_t z[WORD_BLOCK_SIZE];
+    moda_word_t v[WORD_BLOCK_SIZE];
+    moda_word_t yi;
+    moda_word_t vmsb;
+    moda_word_t carry;
+    moda_word_t t;
+    uint8_t i;
+    uint8_t j;
+    uint8_t k;
+
+    if(text != NULL){
+
+        xor128(x, text);
+    }
+
+    (void)memset(z, 0, sizeof(z));
+    copy128(v, x);
+
+    /* one conversion to big endian words per block */
+#if (MODA_WORD_SIZE > 1U)
+#ifndef MODA_BIG_ENDIAN
+    swapBlock(v);
+#endif
+#endif
+
+    for(i=0U; i < WORD_BLOCK_SIZE; i++){
+
+        yi = y[i];
+
+        for(j=0U; j < (MODA_WORD_SIZE << 3U); j++){
+
+            if((yi & LSB) == LSB){
+
+                xor128(z, v);
+            }
+
+            /* MSbit of vector */
+            vmsb = v[WORD_BLOCK_SIZE-1U] & TST_MSB;
+            carry = 0U;
+
+            /* rightshift vector */
+            for(k=0U; k < WORD_BLOCK_SIZE; k++){
+
+                t = v[k];
+                v[k] = (moda_word_t)(t >> 1) | carry;
+                carry = ((t & 0x1U) == 0x1U) ? LSB : 0x0U;
+            }
+
+            if(vmsb != 0U){
+
+                v[0] ^= R;
+            }
+
+            yi <<= 1;
+        }
+    }
+
+#if (MODA_WORD_SIZE > 1U)
+#ifndef MODA_BIG_ENDIAN
+    swapBlock(z);
+#endif
+#endif
+
+    copy128(x, z);
+}
+#endif
+
+static void mulx(uint64_t *hi, uint64_t *lo)
+{
+    uint64_t r = ((*lo & 1U) == 1U) ? 0xe100000000000000U : 0U;
+
+    *lo = (*hi << 63U) | (*lo >> 1U);
+    *hi = (*hi >> 1U) ^ r;
+}
+
+static void mulx8(uint64_t *hi, uint64_t *lo)
+{
+    uint64_t r = (uint64_t)last8[*lo & 0xffU] << 48U;
+
+    *lo = (*hi << 56U) | (*lo >> 8U);
+    *hi = (*hi >> 8U) ^ r;
+}
+
+static void shoupTable(uint64_t *table, uint32_t entries, const uint8_t *h)
+{
+    uint64_t hi = 0U;
+    uint64_t lo = 0U;
+    uint32_t i;
+    uint32_t j;
+
+    for(i=0U; i < 8U; i++){
+
+        hi = (hi << 8U) | (uint64_t)h[i];
+        lo = (lo << 8U) | (uint64_t)h[i + 8U];
+    }
+
+    /* the top bit of the index is the x^0 coefficient */
+    table[0] = 0U;
+    table[1] = 0U;
+
+    for(i = entries >> 1U; i > 0U; i >>= 1U){
+
+        table[i << 1U] = hi;
+        table[(i << 1U) + 1U] = lo;
+        mulx(&hi, &lo);
+    }
+
+    for(i=2U; i < entries; i <<= 1U){
+
+        for(j=1U; j < i; j++){
+
+            table[(i + j) << 1U] = table[i << 1U] ^ table[j << 1U];
+            table[((i + j) << 1U) + 1U] = table[(i << 1U) + 1U] ^ table[(j << 1U) + 1U];
+        }
+    }
+}
+
+static void tableMul(const struct ghash_key *key, moda_word_t *x)
+{
+    const uint64_t *t = key->table;
+    uint8_t *b = (uint8_t *)x;
+    uint64_t hi;
+    uint64_t lo;
+    uint64_t r;
+    uint32_t i;
+    uint8_t n;
+
+    if(key->tableSize == AES_GCM_TABLE_4BIT){
+
+        n = b[15] & 0xfU;
+        hi = t[n << 1U];
+        lo = t[(n << 1U) + 1U];
+
+        for(i=AES_BLOCK_SIZE; i > 0U; i--){
+
+            /* low nibble (already loaded for the last byte) */
+            if(i < AES_BLOCK_SIZE){
+
+                n = b[i - 1U] & 0xfU;
+                r = (uint64_t)last4[lo & 0xfU] << 48U;
+                lo = (hi << 60U) | (lo >> 4U);
+                hi = (hi >> 4U) ^ r;
+                hi ^= t[n << 1U];
+                lo ^= t[(n << 1U) + 1U];
+            }
+
+            n = b[i - 1U] >> 4U;
+            r = (uint64_t)last4[lo & 0xfU] << 48U;
+            lo = (hi << 60U) | (lo >> 4U);
+            hi = (hi >> 4U) ^ r;
+            hi ^= t[n << 1U];
+            lo ^= t[(n << 1U) + 1U];
+        }
+    }
+    else if(key->tableSize == AES_GCM_TABLE_8BIT){
+
+        hi = t[(uint32_t)b[15] << 1U];
+        lo = t[((uint32_t)b[15] << 1U) + 1U];
+
+        for(i=AES_BLOCK_SIZE-1U; i > 0U; i--){
+
+            mulx8(&hi, &lo);
+            hi ^= t[(uint32_t)b[i - 1U] << 1U];
+            lo ^= t[((uint32_t)b[i - 1U] << 1U) + 1U];
+        }
+    }
+    else{
+
+        hi = 0U;
+        lo = 0U;
+
+        for(i=0U; i < AES_BLOCK_SIZE; i++){
+
+            r = ((i << 8U) | (uint32_t)b[i]) << 1U;
+            hi ^= t[r];
+            lo ^= t[r + 1U];
+        }
+    }
+
+    for(i=0U; i < 8U; i++){
+
+        b[i] = (uint8_t)(hi >> (56U - (i << 3U)));
+        b[i + 8U] = (uint8_t)(lo >> (56U - (i << 3U)));
+    }
+}
+
+static void ghash(const struct ghash_key *key, moda_word_t *x, const moda_word_t *text)
+{
+#if defined(MODA_GCM_PCLMUL)
+    if(key->hpow != NULL){
+
+        MODA_GCM_PCLMUL_Hash(key->hpow, (uint8_t *)x, (const uint8_t *)text, 1U);
+    }
+    else
+#endif
+    if(key->table == NULL){
+
+        xormul128(x, text, key->h);
+    }
+    else{
+
+        xor128(x, text);
+        tableMul(key, x);
+    }
+}
+
+static void ghashBytes(const struct ghash_key *key, moda_word_t *x, const uint8_t *in, size_t size)
+{
+    moda_word_t part[WORD_BLOCK_SIZE];
+    size_t whole = size - (size % AES_BLOCK_SIZE);
+    size_t pos = 0U;
+
+#if defined(MODA_GCM_PCLMUL)
+    if(key->hpow != NULL){
+
+        MODA_GCM_PCLMUL_Hash(key->hpow, (uint8_t *)x, in, whole / AES_BLOCK_SIZE);
+        pos = whole;
+    }
+#endif
+
+    for(; pos < whole; pos += AES_BLOCK_SIZE){
+
+        (void)memcpy(part, &in[pos], AES_BLOCK_SIZE);
+        ghash(key, x, part);
+    }
+
+    if(pos < size){
+
+        (void)memset(part, 0, sizeof(part));
+        (void)memcpy(part, &in[pos], size - pos);
+        ghash(key, x, part);
+    }
+}
+
+static void incrementCounter(uint8_t *counter)
+{
+    counter[AES_BLOCK_SIZE-1U]++;
+
+    if(counter[AES_BLOCK_SIZE-1U] == 0U){
+
+        counter[AES_BLOCK_SIZE-2U]++;
+
+        if(counter[AES_BLOCK_SIZE-2U] == 0U){
+
+            counter[AES_BLOCK_SIZE-3U]++;
+
+            if(counter[AES_BLOCK_SIZE-3U] == 0U){
+
+                counter[AES_BLOCK_SIZE-4U]++;
+            }
+        }
+    }    
+}
+
+static void gcmCrypt(const struct aes_ctxt *aes, const struct ghash_key *key, const uint8_t *iv, uint32_t ivSize, uint8_t *out, const uint8_t *in, uint32_t textSize, const uint8_t *aad, uint32_t aadSize, bool encrypt, moda_word_t *x)
+{
+    moda_word_t counter[WORD_BLOCK_SIZE];
+    moda_word_t encryptedInitialCounter[WORD_BLOCK_SIZE];    
+    moda_word_t sizeBlock[WORD_BLOCK_SIZE];
+
+    /* create zero block */
+    xor128(x, x);
+
+    initialCounter(key, iv, ivSize, counter);
+
+    /* encrypt the initial counter value */
+    MODA_AES_EncryptBlocks(aes, (uint8_t *)encryptedInitialCounter, (uint8_t *)counter, 1U);
+
+    /* GHASH aad */
+    ghashBytes(key, x, aad, (size_t)aadSize);
+
+    /* encrypt/decrypt and GHASH cipher text */
+    cryptText(aes, key, counter, x, out, in, (size_t)textSize, encrypt);
+
+    /* GHASH output with sizeBlock */
+    lengthBlock(sizeBlock, (uint64_t)aadSize, (uint64_t)textSize);
+    ghash(key, x, sizeBlock);
+
+    /* XOR encrypted initial counter with GHASH output */    
+    xor128(x, encryptedInitialCounter);
+}
+
+static void initialCounter(const struct ghash_key *key, const uint8_t *iv, uint32_t ivSize, moda_word_t *counter)
+{
+    static const uint8_t zeroCounter[] = {0U, 0U, 0U, 1U};
+    moda_word_t sizeBlock[WORD_BLOCK_SIZE];
+
+    if(ivSize == GCM_IV_SIZE){
+
+        (void)memcpy(counter, iv, GCM_IV_SIZE);
+        (void)memcpy(&((uint8_t *)counter)[GCM_IV_SIZE], zeroCounter, (AES_BLOCK_SIZE - GCM_IV_SIZE));
+    }
+    /* GHASH(H, {}, IV) */ 
+    else{
+
+        /* create zero block (for this GHASH) */
+        (void)memset(counter, 0, AES_BLOCK_SIZE);
+
+        ghashBytes(key, counter, iv, (size_t)ivSize);
+
+        lengthBlock(sizeBlock, 0U, (uint64_t)ivSize);
+        ghash(key, counter, sizeBlock);
+    }
+}
+
+static void cryptText(const struct aes_ctxt *aes, const struct ghash_key *key, moda_word_t *counter, moda_word_t *x, uint8_t *out, const uint8_t *in, size_t textSize, bool encrypt)
+{
+    moda_word_t keyStream[MODA_GCM_BATCH][WORD_BLOCK_SIZE];
+    const uint8_t *ks = (const uint8_t *)keyStream;
+    size_t size = textSize;
+    size_t len;
+    size_t n;
+    size_t i;
+    const uint8_t *inPtr = in;
+    uint8_t *outPtr = out;
+
+#if defined(MODA_GCM_PCLMUL) && defined(MODA_AES_NI)
+    /* AES-NI stitched with PCLMULQDQ for whole groups of blocks */
+    if((key != NULL) && (key->hpow != NULL) && MODA_CPU_HAS(MODA_CPU_AES)){
+
+        len = size - (size % (MODA_GCM_PCLMUL_POWERS * AES_BLOCK_SIZE));
+
+        if(len > 0U){
+
+            MODA_GCM_PCLMUL_CryptBlocks(aes, key->hpow, (uint8_t *)counter, (uint8_t *)x, outPtr, inPtr, len / AES_BLOCK_SIZE, encrypt);
+
+            inPtr = &inPtr[len];
+            outPtr = &outPtr[len];
+            size -= len;
+        }
+    }
+#endif
+
+    /* a batch at a time */
+    while(size > 0U){
+
+        len = (size < (MODA_GCM_BATCH * AES_BLOCK_SIZE)) ? size : (MODA_GCM_BATCH * AES_BLOCK_SIZE);
+        n = (len + (AES_BLOCK_SIZE - 1U)) / AES_BLOCK_SIZE;
+
+        for(i = 0U; i < n; i++){
+
+            incrementCounter((uint8_t *)counter);
+            copy128(keyStream[i], counter);
+        }
+
+        MODA_AES_EncryptBlocks(aes, (uint8_t *)keyStream, (uint8_t *)keyStream, n);
+
+        if(!encrypt && (key != NULL)){
+
+            ghashBytes(key, x, inPtr, len);
+        }
+
+        /* straight from input to output (in may equal out) */
+        for(i = 0U; i < len; i++){
+
+            outPtr[i] = inPtr[i] ^ ks[i];
+        }
+
+        if(encrypt && (key != NULL)){
+
+            ghashBytes(key, x, outPtr, len);
+        }
+
+        inPtr = &inPtr[len];
+        outPtr = &outPtr[len];
+        size -= len;
+    }
+
+    /* clear key stream on stack */
+    (void)memset(keyStream, 0, sizeof(keyStream));
+}
+
+static void lengthBlock(moda_word_t *block, uint64_t aadSize, uint64_t textSize)
+{
+    uint8_t *sb = (uint8_t *)block;
+    uint8_t i;
+
+    /* [aad_size]64 || [size]64 (x8 bits) */
+    for(i=0U; i < 8U; i++){
+
+        sb[i] = (uint8_t)((aadSize << 3U) >> (56U - (i << 3U)));
+        sb[i + 8U] = (uint8_t)((textSize << 3U) >> (56U - (i << 3U)));
+    }
+}
+
+static void streamFlush(const struct ghash_key *key, struct aes_gcm_stream *s, size_t pos)
+{
+    (void)memset(&s->part[pos], 0, AES_BLOCK_SIZE - pos);
+    ghash(key, (moda_word_t *)s->x, (const moda_word_t *)s->part);
+}
+
+static size_t streamBytes(struct aes_gcm_stream *s, uint8_t *out, const uint8_t *in, size_t size, size_t pos)
+{
+    size_t i;
+    uint8_t c;
+
+    for(i=0U; (i < size) && ((pos + i) < AES_BLOCK_SIZE); i++){
+
+        c = in[i];
+        out[i] = c ^ s->ks[pos + i];
+        s->part[pos + i] = s->encrypt ? out[i] : c;
+    }
+
+    return i;
+}
+
+static void streamTag(struct aes_gcm_stream *s, moda_word_t *x)
+{
+    struct ghash_key key;
+    moda_word_t sizeBlock[WORD_BLOCK_SIZE];
+
+    gcmKey(s->gcm, &key);
+
+    if((s->textSize == 0U) && ((s->aadSize % AES_BLOCK_SIZE) != 0U)){
+
+        streamFlush(&key, s, (size_t)(s->aadSize % AES_BLOCK_SIZE));
+    }
+    else if((s->textSize % AES_BLOCK_SIZE) != 0U){
+
+        streamFlush(&key, s, (size_t)(s->textSize % AES_BLOCK_SIZE));
+    }
+    else{
+
+        /* no partial block */
+    }
+
+    lengthBlock(sizeBlock, s->aadSize, s->textSize);
+    ghash(&key, (moda_word_t *)s->x, sizeBlock);
+
+    copy128(x, (const moda_word_t *)s->x);
+    xor128(x, (const moda_word_t *)s->ek0);
+
+    /* clear key stream and partial text */
+    (void)memset(s->ks, 0, sizeof(s->ks));
+    (void)memset(s->part, 0, sizeof(s->part));
+}
+
+static void hashKey(const struct aes_ctxt *aes, moda_word_t *h)
+{
+    (void)memset(h, 0, AES_BLOCK_SIZE);
+    MODA_AES_Encrypt(aes, (uint8_t *)h);
+
+#if (MODA_WORD_SIZE > 1U)
+#ifndef MODA_BIG_ENDIAN
+    swapBlock(h);
+#endif
+#endif
+}
+
+#if defined(MODA_GCM_PCLMUL)
+static const uint8_t *hashPowers(const moda_word_t *h, uint8_t *hpow)
+{
+    moda_word_t hb[WORD_BLOCK_SIZE];
+    const uint8_t *retval = NULL;
+
+    if(MODA_CPU_HAS(MODA_CPU_PCLMUL)){
+
+        /* back to GCM byte order */
+        copy128(hb, h);
+#if (MODA_WORD_SIZE > 1U)
+#ifndef MODA_BIG_ENDIAN
+        swapBlock(hb);
+#endif
+#endif
+        MODA_GCM_PCLMUL_Init(hpow, (const uint8_t *)hb);
+        xor128(hb, hb);
+
+        retval = hpow;
+    }
+
+    return retval;
+}
+#endif
+
+static void gcmKey(const struct aes_gcm_ctxt *gcm, struct ghash_key *key)
+{
+    key->h = (const moda_word_t *)gcm->h;
+    key->table = (const uint64_t *)gcm->table;
+    key->tableSize = gcm->tableSize;
+#if defined(MODA_GCM_PCLMUL)
+    key->hpow = MODA_CPU_HAS(MODA_CPU_PCLMUL) ? gcm->hpow : NULL;
+#endif
+}
+
+static size_t burstCrypt(const struct aes_gcm_ctxt *gcm, struct aes_gcm_packet *pkt, size_t n, bool encrypt)
+{
+    struct ghash_key key;
+    moda_word_t counter[MODA_GCM_BATCH][WORD_BLOCK_SIZE];
+    moda_word_t ek0[MODA_GCM_BATCH][WORD_BLOCK_SIZE];
+    moda_word_t x[MODA_GCM_BATCH][WORD_BLOCK_SIZE];
+    moda_word_t keyStream[MODA_GCM_BATCH][WORD_BLOCK_SIZE];
+    moda_word_t sizeBlock[WORD_BLOCK_SIZE];
+    size_t slotPacket[MODA_GCM_BATCH];
+    uint32_t slotPos[MODA_GCM_BATCH];
+    struct aes_gcm_packet *p;
+    const uint8_t *ks;
+    size_t group;
+    size_t m;
+    size_t k;
+    size_t slots;
+    size_t i;
+    uint32_t pos;
+    uint32_t at;
+    uint32_t len;
+    uint32_t j;
+    size_t valid = 0U;
+
+    gcmKey(gcm, &key);
+
+    for(group = 0U; group < n; group += m){
+
+        m = ((n - group) < MODA_GCM_BATCH) ? (n - group) : MODA_GCM_BATCH;
+        p = &pkt[group];
+
+        /* initial counters of the whole group in one call */
+        for(k=0U; k < m; k++){
+
+            initialCounter(&key, p[k].iv, p[k].ivSize, counter[k]);
+            copy128(ek0[k], counter[k]);
+        }
+
+        MODA_AES_EncryptBlocks(&gcm->aes, (uint8_t *)ek0, (uint8_t *)ek0, m);
+
+        /* cipher text must be hashed before decryption in place replaces it */
+        for(k=0U; k < m; k++){
+
+            (void)memset(x[k], 0, sizeof(x[k]));
+            ghashBytes(&key, x[k], p[k].aad, (size_t)p[k].aadSize);
+
+            if(!encrypt && (p[k].textSize < GCM_BURST_LONG)){
+
+                ghashBytes(&key, x[k], p[k].in, (size_t)p[k].textSize);
+            }
+        }
+
+        /* each batch takes counter blocks from as many short packets as it needs */
+        k = 0U;
+        pos = 0U;
+
+        while(k < m){
+
+            slots = 0U;
+
+            while((slots < MODA_GCM_BATCH) && (k < m)){
+
+                if((pos < p[k].textSize) && (p[k].textSize < GCM_BURST_LONG)){
+
+                    incrementCounter((uint8_t *)counter[k]);
+                    copy128(keyStream[slots], counter[k]);
+                    slotPacket[slots] = k;
+                    slotPos[slots] = pos;
+                    slots++;
+
+                    pos = ((p[k].textSize - pos) > AES_BLOCK_SIZE) ? (pos + AES_BLOCK_SIZE) : p[k].textSize;
+                }
+                else{
+
+                    k++;
+                    pos = 0U;
+                }
+            }
+
+            if(slots > 0U){
+
+                MODA_AES_EncryptBlocks(&gcm->aes, (uint8_t *)keyStream, (uint8_t *)keyStream, slots);
+
+                for(i=0U; i < slots; i++){
+
+                    ks = (const uint8_t *)keyStream[i];
+                    at = slotPos[i];
+                    len = p[slotPacket[i]].textSize - at;
+                    len = (len < AES_BLOCK_SIZE) ? len : AES_BLOCK_SIZE;
+
+                    for(j=0U; j < len; j++){
+
+                        p[slotPacket[i]].out[at + j] = p[slotPacket[i]].in[at + j] ^ ks[j];
+                    }
+                }
+            }
+        }
+
+        /* packets of a batch or more fill the pipeline by themselves */
+        for(k=0U; k < m; k++){
+
+            if(p[k].textSize >= GCM_BURST_LONG){
+
+                cryptText(&gcm->aes, &key, counter[k], x[k], p[k].out, p[k].in, (size_t)p[k].textSize, encrypt);
+            }
+            else if(encrypt){
+
+                ghashBytes(&key, x[k], p[k].out, (size_t)p[k].textSize);
+            }
+            else{
+
+                /* hashed already */
+            }
+        }
+
+        for(k=0U; k < m; k++){
+
+            ASSERT((p[k].tSize <= GCM_TAG_SIZE))
+
+            lengthBlock(sizeBlock, (uint64_t)p[k].aadSize, (uint64_t)p[k].textSize);
+            ghash(&key, x[k], sizeBlock);
+            xor128(x[k], ek0[k]);
+
+            if(encrypt){
+
+                (void)memcpy(p[k].t, x[k], (size_t)p[k].tSize);
+            }
+            else{
+
+                p[k].valid = (memcmp(x[k], p[k].t, (size_t)p[k].tSize) == 0);
+                valid += p[k].valid ? 1U : 0U;
+            }
+        }
+    }
+
+    /* clear key stream on stack */
+    (void)memset(keyStream, 0, sizeof(keyStream));
+    (void)memset(ek0, 0, sizeof(ek0));
+
+    return valid;
+}
+
+static void addCounter(uint8_t *counter, uint32_t n)
+{
+    uint32_t c;
+
+    c = ((uint32_t)counter[AES_BLOCK_SIZE-4U] << 24U) | ((uint32_t)counter[AES_BLOCK_SIZE-3U] << 16U) | ((uint32_t)counter[AES_BLOCK_SIZE-2U] << 8U) | (uint32_t)counter[AES_BLOCK_SIZE-1U];
+    c += n;
+
+    counter[AES_BLOCK_SIZE-4U] = (uint8_t)(c >> 24U);
+    counter[AES_BLOCK_SIZE-3U] = (uint8_t)(c >> 16U);
+    counter[AES_BLOCK_SIZE-2U] = (uint8_t)(c >> 8U);
+    counter[AES_BLOCK_SIZE-1U] = (uint8_t)c;
+}
+
+static void mulBlock(moda_word_t *x, const moda_word_t *y)
+{
+    moda_word_t yk[WORD_BLOCK_SIZE];
+
+    /* y to the word order used by xormul128() */
+    copy128(yk, y);
+#if (MODA_WORD_SIZE > 1U)
+#ifndef MODA_BIG_ENDIAN
+    swapBlock(yk);
+#endif
+#endif
+
+    xormul128(x, NULL, yk);
+}
+
+static void hashPower(const moda_word_t *h, size_t n, moda_word_t *y)
+{
+    moda_word_t sq[WORD_BLOCK_SIZE];
+    size_t k;
+
+    /* one */
+    (void)memset(y, 0, AES_BLOCK_SIZE);
+    ((uint8_t *)y)[0] = 0x80U;
+
+    /* back to GCM byte order */
+    copy128(sq, h);
+#if (MODA_WORD_SIZE > 1U)
+#ifndef MODA_BIG_ENDIAN
+    swapBlock(sq);
+#endif
+#endif
+
+    for(k = n; k > 0U; k >>= 1U){
+
+        if((k & 1U) == 1U){
+
+            mulBlock(y, sq);
+        }
+
+        mulBlock(sq, sq);
+    }
+
+    xor128(sq, sq);
+}
+
+static void parallelTag(const struct aes_gcm_parallel *p, const struct aes_gcm_share *share, moda_word_t *x)
+{
+    struct ghash_key key;
+    moda_word_t hn[WORD_BLOCK_SIZE];
+    moda_word_t hlast[WORD_BLOCK_SIZE];
+    moda_word_t sizeBlock[WORD_BLOCK_SIZE];
+    size_t last;
+    size_t i;
+
+    gcmKey(p->gcm, &key);
+
+    copy128(x, (const moda_word_t *)p->x);
+
+    if(p->shares > 0U){
+
+        /* the last share may have fewer blocks than the rest */
+        last = p->textSize - ((p->shares - 1U) * p->shareSize);
+
+        hashPower(key.h, p->shareSize / AES_BLOCK_SIZE, hn);
+        hashPower(key.h, (last + (AES_BLOCK_SIZE - 1U)) / AES_BLOCK_SIZE, hlast);
+
+        /* X = X * H^m + Y for the m blocks of each share in turn */
+        for(i=0U; i < p->shares; i++){
+
+            mulBlock(x, (i == (p->shares - 1U)) ? hlast : hn);
+            xor128(x, (const moda_word_t *)share[i].x);
+        }
+
+        xor128(hn, hn);
+        xor128(hlast, hlast);
+    }
+
+    lengthBlock(sizeBlock, p->aadSize, (uint64_t)p->textSize);
+    ghash(&key, x, sizeBlock);
+
+    xor128(x, (const moda_word_t *)p->ek0);
+}
@@ -0,0 +1,304 @@
+/* Copyright (c) 2013-2016 Cameron Harper
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * */
+
+/* includes ***********************************************************/
+
+#include "aes_gcm.h"
+#include "moda_internal.h"
+
+#if defined(MODA_GCM_PCLMUL)
+
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+
+/* defines ************************************************************/
+
+/* compile for PCLMULQDQ without requiring -mpclmul for the whole project */
+#define TARGET __attribute__((target("pclmul,ssse3")))
+
+#define LOAD(P) _mm_loadu_si128((const __m128i *)(const void *)(P))
+#define STORE(P, V) _mm_storeu_si128((__m128i *)(void *)(P), (V))
+
+/* AES-NI and PCLMULQDQ together for the stitched kernel */
+#define TARGET_AES __attribute__((target("aes,pclmul,ssse3")))
+
+/* blocks per iteration of the stitched kernel */
+#define STITCH MODA_GCM_PCLMUL_POWERS
+
+/* reverse the bytes of a block so bit 127 is the x^0 coefficient */
+#define BSWAP(V) _mm_shuffle_epi8((V), _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15))
+
+/* static function prototypes *****************************************/
+
+/**
+ * Accumulate the Karatsuba partial products of a . b
+ *
+ * @param[in] a byte reversed block
+ * @param[in] b byte reversed block
+ * @param[in/out] lo sum of low halves multiplied
+ * @param[in/out] mid sum of (high XOR low) halves multiplied
+ * @param[in/out] hi sum of high halves multiplied
+ *
+ * */
+TARGET static void mulAcc(__m128i a, __m128i b, __m128i *lo, __m128i *mid, __m128i *hi);
+
+/**
+ * Combine accumulated partial products and reduce modulo the GCM polynomial
+ *
+ * @param[in] lo from mulAcc()
+ * @param[in] mid from mulAcc()
+ * @param[in] hi from mulAcc()
+ * @return byte reversed product
+ *
+ * */
+TARGET static __m128i reduce(__m128i lo, __m128i mid, __m128i hi);
+
+/* functions **********************************************************/
+
+TARGET void MODA_GCM_PCLMUL_Init(uint8_t *hpow, const uint8_t *h)
+{
+    __m128i hh = BSWAP(LOAD(h));
+    __m128i p = hh;
+    __m128i lo;
+    __m128i mid;
+    __m128i hi;
+    uint8_t i;
+
+    STORE(hpow, hh);
+
+    for(i = 1U; i < MODA_GCM_PCLMUL_POWERS; i++){
+
+        lo = _mm_setzero_si128();
+        mid = lo;
+        hi = lo;
+
+        mulAcc(p, hh, &lo, &mid, &hi);
+        p = reduce(lo, mid, hi);
+
+        STORE(&hpow[i << 4U], p);
+    }
+}
+
+TARGET void MODA_GCM_PCLMUL_Hash(const uint8_t *hpow, uint8_t *x, const uint8_t *in, size_t n)
+{
+    __m128i acc = BSWAP(LOAD(x));
+    __m128i b;
+    __m128i lo;
+    __m128i mid;
+    __m128i hi;
+    size_t k;
+    size_t j;
+
+    while(n > 0U){
+
+        k = (n < MODA_GCM_PCLMUL_POWERS) ? n : MODA_GCM_PCLMUL_POWERS;
+
+        lo = _mm_setzero_si128();
+        mid = lo;
+        hi = lo;
+
+        /* (X + B0)H^k + B1H^(k-1) + ... + B(k-1)H with one reduction */
+        for(j = 0U; j < k; j++){
+
+            b = BSWAP(LOAD(&in[j << 4U]));
+
+            if(j == 0U){
+
+                b = _mm_xor_si128(b, acc);
+            }
+
+            mulAcc(b, LOAD(&hpow[(k - 1U - j) << 4U]), &lo, &mid, &hi);
+        }
+
+        acc = reduce(lo, mid, hi);
+
+        in = &in[k << 4U];
+        n -= k;
+    }
+
+    STORE(x, BSWAP(acc));
+}
+
+#if defined(MODA_AES_NI)
+TARGET_AES void MODA_GCM_PCLMUL_CryptBlocks(const struct aes_ctxt *aes, const uint8_t *hpow, uint8_t *counter, uint8_t *x, uint8_t *out, const uint8_t *in, size_t n, bool encrypt)
+{
+    __m128i k[15U];
+    __m128i h[STITCH];
+    __m128i b[STITCH];
+    __m128i c[STITCH];
+    __m128i prefix = _mm_and_si128(LOAD(counter), _mm_set_epi32(0, -1, -1, -1));
+    __m128i acc = BSWAP(LOAD(x));
+    __m128i lo;
+    __m128i mid;
+    __m128i hi;
+    uint32_t ctr = ((uint32_t)counter[12] << 24U) | ((uint32_t)counter[13] << 16U) | ((uint32_t)counter[14] << 8U) | (uint32_t)counter[15];
+    bool hash = false;
+    size_t i;
+    uint8_t r;
+    uint8_t j;
+
+    ASSERT(((n % STITCH) == 0U))
+
+    for(r = 0U; r <= aes->r; r++){
+
+        k[r] = LOAD(&aes->k[r << 4U]);
+    }
+
+    for(j = 0U; j < STITCH; j++){
+
+        h[j] = LOAD(&hpow[j << 4U]);
+        c[j] = _mm_setzero_si128();     /* always written before it is hashed */
+    }
+
+    for(i = 0U; i < n; i += STITCH){
+
+        for(j = 0U; j < STITCH; j++){
+
+            ctr++;
+            b[j] = _mm_or_si128(prefix, _mm_slli_si128(_mm_cvtsi32_si128((int)__builtin_bswap32(ctr)), 12));
+            b[j] = _mm_xor_si128(b[j], k[0]);
+        }
+
+        /* decryption hashes this batch of cipher text, encryption the one before */
+        if(!encrypt){
+
+            for(j = 0U; j < STITCH; j++){
+
+                c[j] = BSWAP(LOAD(&in[(i + j) << 4U]));
+            }
+
+            hash = true;
+        }
+
+        lo = _mm_setzero_si128();
+        mid = lo;
+        hi = lo;
+
+        /* one block of GHASH between each round of AES (at least 9 rounds) */
+        for(r = 1U; r < aes->r; r++){
+
+            for(j = 0U; j < STITCH; j++){
+
+                b[j] = _mm_aesenc_si128(b[j], k[r]);
+            }
+
+            if(hash && (r <= STITCH)){
+
+                j = r - 1U;
+                mulAcc((j == 0U) ? _mm_xor_si128(c[0], acc) : c[j], h[STITCH - 1U - j], &lo, &mid, &hi);
+            }
+        }
+
+        if(hash){
+
+            acc = reduce(lo, mid, hi);
+        }
+
+        for(j = 0U; j < STITCH; j++){
+
+            b[j] = _mm_aesenclast_si128(b[j], k[aes->r]);
+            b[j] = _mm_xor_si128(b[j], LOAD(&in[(i + j) << 4U]));
+            STORE(&out[(i + j) << 4U], b[j]);
+        }
+
+        if(encrypt){
+
+            for(j = 0U; j < STITCH; j++){
+
+                c[j] = BSWAP(b[j]);
+            }
+
+            hash = true;
+        }
+    }
+
+    /* last batch of cipher text from encryption */
+    if(encrypt && hash){
+
+        lo = _mm_setzero_si128();
+        mid = lo;
+        hi = lo;
+
+        for(j = 0U; j < STITCH; j++){
+
+            mulAcc((j == 0U) ? _mm_xor_si128(c[0], acc) : c[j], h[STITCH - 1U - j], &lo, &mid, &hi);
+        }
+
+        acc = reduce(lo, mid, hi);
+    }
+
+    STORE(x, BSWAP(acc));
+
+    counter[12] = (uint8_t)(ctr >> 24U);
+    counter[13] = (uint8_t)(ctr >> 16U);
+    counter[14] = (uint8_t)(ctr >> 8U);
+    counter[15] = (uint8_t)ctr;
+}
+#endif
+
+/* static functions  **************************************************/
+
+TARGET static void mulAcc(__m128i a, __m128i b, __m128i *lo, __m128i *mid, __m128i *hi)
+{
+    __m128i aa = _mm_xor_si128(a, _mm_shuffle_epi32(a, 0x4e));
+    __m128i bb = _mm_xor_si128(b, _mm_shuffle_epi32(b, 0x4e));
+
+    *lo = _mm_xor_si128(*lo, _mm_clmulepi64_si128(a, b, 0x00));
+    *hi = _mm_xor_si128(*hi, _mm_clmulepi64_si128(a, b, 0x11));
+    *mid = _mm_xor_si128(*mid, _mm_clmulepi64_si128(aa, bb, 0x00));
+}
+
+TARGET static __m128i reduce(__m128i lo, __m128i mid, __m128i hi)
+{
+    __m128i t0;
+    __m128i t1;
+    __m128i t2;
+
+    /* 256bit product hi:lo */
+    mid = _mm_xor_si128(mid, _mm_xor_si128(lo, hi));
+    lo = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+    hi = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+
+    /* the product of reflected operands is one bit short: shift left */
+    t0 = _mm_srli_epi32(lo, 31);
+    t1 = _mm_srli_epi32(hi, 31);
+    lo = _mm_slli_epi32(lo, 1);
+    hi = _mm_slli_epi32(hi, 1);
+    t2 = _mm_srli_si128(t0, 12);
+    t1 = _mm_slli_si128(t1, 4);
+    t0 = _mm_slli_si128(t0, 4);
+    lo = _mm_or_si128(lo, t0);
+    hi = _mm_or_si128(hi, _mm_or_si128(t1, t2));
+
+    /* reduce modulo x^128 + x^7 + x^2 + x + 1 */
+    t0 = _mm_xor_si128(_mm_slli_epi32(lo, 31), _mm_xor_si128(_mm_slli_epi32(lo, 30), _mm_slli_epi32(lo, 25)));
+    t1 = _mm_srli_si128(t0, 4);
+    lo = _mm_xor_si128(lo, _mm_slli_si128(t0, 12));
+
+    t0 = _mm_xor_si128(_mm_srli_epi32(lo, 1), _mm_xor_si128(_mm_srli_epi32(lo, 2), _mm_srli_epi32(lo, 7)));
+    t0 = _mm_xor_si128(t0, t1);
+    lo = _mm_xor_si128(lo, t0);
+
+    return _mm_xor_si128(hi, lo);
+}
+
+#endif
@@ -0,0 +1,171 @@
+/* Copyright (c) 2013-2016 Cameron Harper
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * */
+
+/* includes ***********************************************************/
+
+#include "aes.h"
+#include "aes_handle.h"
+#include "moda_internal.h"
+
+#include <string.h>
+
+/* defines ************************************************************/
+
+#if !defined(__GNUC__) && !defined(__clang__)
+    #error "aes_handle.c requires the GCC/Clang __atomic builtins"
+#endif
+
+#if (MODA_AES_HANDLE_VERSIONS < 2U)
+    #error "MODA_AES_HANDLE_VERSIONS must be at least 2"
+#endif
+
+#define SLOT(E) ((E) % MODA_AES_HANDLE_VERSIONS)
+
+/* functions **********************************************************/
+
+void MODA_AES_HandleInit(struct aes_handle *handle, struct aes_handle_reader *reader, size_t readers, enum aes_key_size keySize, const uint8_t *key)
+{
+    size_t i;
+
+    ASSERT((handle != NULL))
+    ASSERT(((reader != NULL) || (readers == 0U)))
+    ASSERT((key != NULL))
+
+    (void)memset(handle, 0, sizeof(*handle));
+
+    for(i = 0U; i < readers; i++){
+
+        reader[i].epoch = 0U;
+    }
+
+    handle->reader = reader;
+    handle->readers = readers;
+
+    MODA_AES_Init(&handle->aes[SLOT(1U)], keySize, key);
+
+    handle->oldest = 1U;
+    __atomic_store_n(&handle->current, 1U, __ATOMIC_RELEASE);
+}
+
+const struct aes_ctxt *MODA_AES_HandleEnter(struct aes_handle *handle, struct aes_handle_reader *reader, uint32_t *epoch)
+{
+    uint32_t e;
+
+    ASSERT((handle != NULL))
+    ASSERT((reader != NULL))
+
+    /* announce before use; the writer sees the announcement or we see its retirement */
+    do{
+
+        e = __atomic_load_n(&handle->current, __ATOMIC_ACQUIRE);
+        __atomic_store_n(&reader->epoch, e, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    }
+    while(e < __atomic_load_n(&handle->oldest, __ATOMIC_RELAXED));
+
+    if(epoch != NULL){
+
+        *epoch = e;
+    }
+
+    return &handle->aes[SLOT(e)];
+}
+
+const struct aes_ctxt *MODA_AES_HandleEnterEpoch(struct aes_handle *handle, struct aes_handle_reader *reader, uint32_t epoch)
+{
+    const struct aes_ctxt *retval = NULL;
+
+    ASSERT((handle != NULL))
+    ASSERT((reader != NULL))
+
+    if(epoch != 0U){
+
+        __atomic_store_n(&reader->epoch, epoch, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+        if((epoch >= __atomic_load_n(&handle->oldest, __ATOMIC_RELAXED)) && (epoch <= __atomic_load_n(&handle->current, __ATOMIC_ACQUIRE))){
+
+            retval = &handle->aes[SLOT(epoch)];
+        }
+        else{
+
+            __atomic_store_n(&reader->epoch, 0U, __ATOMIC_RELEASE);
+        }
+    }
+
+    return retval;
+}
+
+void MODA_AES_HandleExit(struct aes_handle *handle, struct aes_handle_reader *reader)
+{
+    ASSERT((handle != NULL))
+    ASSERT((reader != NULL))
+
+    (void)handle;
+
+    __atomic_store_n(&reader->epoch, 0U, __ATOMIC_RELEASE);
+}
+
+bool MODA_AES_HandleRotate(struct aes_handle *handle, enum aes_key_size keySize, const uint8_t *key)
+{
+    uint32_t next;
+    uint32_t victim;
+    uint32_t e;
+    size_t i;
+    bool retval = true;
+
+    ASSERT((handle != NULL))
+    ASSERT((key != NULL))
+
+    next = __atomic_load_n(&handle->current, __ATOMIC_RELAXED) + 1U;
+
+    /* epoch whose slot the next key takes */
+    victim = (next > MODA_AES_HANDLE_VERSIONS) ? (next - MODA_AES_HANDLE_VERSIONS) : 0U;
+
+    if(victim >= __atomic_load_n(&handle->oldest, __ATOMIC_RELAXED)){
+
+        __atomic_store_n(&handle->oldest, victim + 1U, __ATOMIC_RELAXED);
+    }
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    for(i = 0U; i < handle->readers; i++){
+
+        e = __atomic_load_n(&handle->reader[i].epoch, __ATOMIC_ACQUIRE);
+
+        if((e != 0U) && (e <= victim)){
+
+            retval = false;
+            break;
+        }
+    }
+
+    if(retval){
+
+        (void)memset(&handle->aes[SLOT(next)], 0, sizeof(handle->aes[SLOT(next)]));
+
+        MODA_AES_Init(&handle->aes[SLOT(next)], keySize, key);
+
+        __atomic_store_n(&handle->current, next, __ATOMIC_RELEASE);
+    }
+
+    return retval;
+}
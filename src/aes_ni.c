@@ -0,0 +1,469 @@
+/* Copyright (c) 2013-2016 Cameron Harper
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * */
+
+/* includes ***********************************************************/
+
+#include "aes.h"
+#include "moda_internal.h"
+
+#if defined(MODA_AES_NI)
+
+#include <string.h>
+#include <emmintrin.h>
+#include <wmmintrin.h>
+
+/* defines ************************************************************/
+
+/* compile for AES-NI without requiring -maes for the whole project */
+#define TARGET __attribute__((target("aes,sse2")))
+
+#define LOAD(P) _mm_loadu_si128((const __m128i *)(const void *)(P))
+#define STORE(P, V) _mm_storeu_si128((__m128i *)(void *)(P), (V))
+
+/* number of blocks interleaved by the multi-block functions */
+#define LANES 4U
+
+/* AES-128 round key from the previous round key and AESKEYGENASSIST output */
+#define EXPAND_128(K, RCON) expand128((K), _mm_aeskeygenassist_si128((K), (RCON)))
+
+/* static function prototypes *****************************************/
+
+/**
+ * Fold the previous round key words into the AESKEYGENASSIST word
+ *
+ * @param[in] k previous round key
+ * @param[in] t AESKEYGENASSIST output already broadcast
+ * @return next round key
+ *
+ * */
+TARGET static __m128i fold(__m128i k, __m128i t);
+
+/**
+ * AES-128 key expansion step
+ *
+ * @param[in] k previous round key
+ * @param[in] t AESKEYGENASSIST output of `k`
+ * @return next round key
+ *
+ * */
+TARGET static __m128i expand128(__m128i k, __m128i t);
+
+/**
+ * Apply SubBytes to a word using AESKEYGENASSIST
+ *
+ * @param[in] w word
+ * @return SubWord(w)
+ *
+ * */
+TARGET static uint32_t subWord(uint32_t w);
+
+/**
+ * AES-192 key schedule (word oriented)
+ *
+ * @param[out] k expanded key
+ * @param[in] key 24 byte key
+ *
+ * */
+TARGET static void expand192(uint8_t *k, const uint8_t *key);
+
+/**
+ * AES-256 key schedule
+ *
+ * @param[out] k expanded key
+ * @param[in] key 32 byte key
+ *
+ * */
+TARGET static void expand256(uint8_t *k, const uint8_t *key);
+
+/**
+ * Load the decryption round keys (reverse order, InvMixColumns applied)
+ *
+ * @param[in] aes expanded key
+ * @param[out] dk decryption round keys
+ *
+ * */
+TARGET static void decryptKeys(const struct aes_ctxt *aes, __m128i *dk);
+
+/* functions **********************************************************/
+
+TARGET void MODA_AES_NI_Init(struct aes_ctxt *aes, enum aes_key_size keySize, const uint8_t *key)
+{
+    __m128i k;
+#if defined(MODA_AES_DECRYPT_SCHEDULE)
+    uint8_t r;
+#endif
+
+    switch(keySize){
+    case AES_KEY_128:
+
+        aes->r = 10U;
+
+        k = LOAD(key);
+        STORE(aes->k, k);
+        k = EXPAND_128(k, 0x01); STORE(&aes->k[16U], k);
+        k = EXPAND_128(k, 0x02); STORE(&aes->k[32U], k);
+        k = EXPAND_128(k, 0x04); STORE(&aes->k[48U], k);
+        k = EXPAND_128(k, 0x08); STORE(&aes->k[64U], k);
+        k = EXPAND_128(k, 0x10); STORE(&aes->k[80U], k);
+        k = EXPAND_128(k, 0x20); STORE(&aes->k[96U], k);
+        k = EXPAND_128(k, 0x40); STORE(&aes->k[112U], k);
+        k = EXPAND_128(k, 0x80); STORE(&aes->k[128U], k);
+        k = EXPAND_128(k, 0x1b); STORE(&aes->k[144U], k);
+        k = EXPAND_128(k, 0x36); STORE(&aes->k[160U], k);
+        break;
+
+    case AES_KEY_192:
+
+        aes->r = 12U;
+        expand192(aes->k, key);
+        break;
+
+    case AES_KEY_256:
+    default:
+
+        aes->r = 14U;
+        expand256(aes->k, key);
+        break;
+    }
+
+#if defined(MODA_AES_DECRYPT_SCHEDULE)
+    STORE(aes->dk, LOAD(&aes->k[aes->r << 4U]));
+
+    for(r = 1U; r < aes->r; r++){
+
+        STORE(&aes->dk[r << 4U], _mm_aesimc_si128(LOAD(&aes->k[(aes->r - r) << 4U])));
+    }
+
+    STORE(&aes->dk[aes->r << 4U], LOAD(aes->k));
+#endif
+}
+
+TARGET void MODA_AES_NI_Encrypt(const struct aes_ctxt *aes, uint8_t *s)
+{
+    __m128i b;
+    uint8_t r;
+    const uint8_t *k = aes->k;
+
+    b = _mm_xor_si128(LOAD(s), LOAD(k));
+
+    for(r = 1U; r < aes->r; r++){
+
+        b = _mm_aesenc_si128(b, LOAD(&k[r << 4U]));
+    }
+
+    STORE(s, _mm_aesenclast_si128(b, LOAD(&k[aes->r << 4U])));
+}
+
+TARGET void MODA_AES_NI_Decrypt(const struct aes_ctxt *aes, uint8_t *s)
+{
+    __m128i b;
+    uint8_t r;
+
+#if defined(MODA_AES_DECRYPT_SCHEDULE)
+    const uint8_t *k = aes->dk;
+
+    b = _mm_xor_si128(LOAD(s), LOAD(k));
+
+    for(r = 1U; r < aes->r; r++){
+
+        b = _mm_aesdec_si128(b, LOAD(&k[r << 4U]));
+    }
+
+    STORE(s, _mm_aesdeclast_si128(b, LOAD(&k[aes->r << 4U])));
+#else
+    const uint8_t *k = aes->k;
+
+    b = _mm_xor_si128(LOAD(s), LOAD(&k[aes->r << 4U]));
+
+    for(r = aes->r - 1U; r > 0U; r--){
+
+        b = _mm_aesdec_si128(b, _mm_aesimc_si128(LOAD(&k[r << 4U])));
+    }
+
+    STORE(s, _mm_aesdeclast_si128(b, LOAD(k)));
+#endif
+}
+
+TARGET void MODA_AES_NI_EncryptBlocks(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in, size_t n)
+{
+    __m128i k[15U];
+    __m128i b0;
+    __m128i b1;
+    __m128i b2;
+    __m128i b3;
+    uint8_t r;
+    size_t i = 0U;
+
+    for(r = 0U; r <= aes->r; r++){
+
+        k[r] = LOAD(&aes->k[r << 4U]);
+    }
+
+    for(; (n - i) >= LANES; i += LANES){
+
+        b0 = _mm_xor_si128(LOAD(&in[i << 4U]), k[0]);
+        b1 = _mm_xor_si128(LOAD(&in[(i + 1U) << 4U]), k[0]);
+        b2 = _mm_xor_si128(LOAD(&in[(i + 2U) << 4U]), k[0]);
+        b3 = _mm_xor_si128(LOAD(&in[(i + 3U) << 4U]), k[0]);
+
+        for(r = 1U; r < aes->r; r++){
+
+            b0 = _mm_aesenc_si128(b0, k[r]);
+            b1 = _mm_aesenc_si128(b1, k[r]);
+            b2 = _mm_aesenc_si128(b2, k[r]);
+            b3 = _mm_aesenc_si128(b3, k[r]);
+        }
+
+        STORE(&out[i << 4U], _mm_aesenclast_si128(b0, k[aes->r]));
+        STORE(&out[(i + 1U) << 4U], _mm_aesenclast_si128(b1, k[aes->r]));
+        STORE(&out[(i + 2U) << 4U], _mm_aesenclast_si128(b2, k[aes->r]));
+        STORE(&out[(i + 3U) << 4U], _mm_aesenclast_si128(b3, k[aes->r]));
+    }
+
+    for(; i < n; i++){
+
+        b0 = _mm_xor_si128(LOAD(&in[i << 4U]), k[0]);
+
+        for(r = 1U; r < aes->r; r++){
+
+            b0 = _mm_aesenc_si128(b0, k[r]);
+        }
+
+        STORE(&out[i << 4U], _mm_aesenclast_si128(b0, k[aes->r]));
+    }
+}
+
+TARGET void MODA_AES_NI_EncryptMany(const struct aes_ctxt *const *aes, uint8_t *out, const uint8_t *in, size_t n)
+{
+    __m128i b0;
+    __m128i b1;
+    __m128i b2;
+    __m128i b3;
+    uint8_t r;
+    uint8_t nr;
+    size_t i = 0U;
+
+    while(i < n){
+
+        nr = aes[i]->r;
+
+        /* four keys of the same size go through the pipeline together */
+        if(((n - i) >= LANES) && (aes[i + 1U]->r == nr) && (aes[i + 2U]->r == nr) && (aes[i + 3U]->r == nr)){
+
+            b0 = _mm_xor_si128(LOAD(&in[i << 4U]), LOAD(aes[i]->k));
+            b1 = _mm_xor_si128(LOAD(&in[(i + 1U) << 4U]), LOAD(aes[i + 1U]->k));
+            b2 = _mm_xor_si128(LOAD(&in[(i + 2U) << 4U]), LOAD(aes[i + 2U]->k));
+            b3 = _mm_xor_si128(LOAD(&in[(i + 3U) << 4U]), LOAD(aes[i + 3U]->k));
+
+            for(r = 1U; r < nr; r++){
+
+                b0 = _mm_aesenc_si128(b0, LOAD(&aes[i]->k[r << 4U]));
+                b1 = _mm_aesenc_si128(b1, LOAD(&aes[i + 1U]->k[r << 4U]));
+                b2 = _mm_aesenc_si128(b2, LOAD(&aes[i + 2U]->k[r << 4U]));
+                b3 = _mm_aesenc_si128(b3, LOAD(&aes[i + 3U]->k[r << 4U]));
+            }
+
+            STORE(&out[i << 4U], _mm_aesenclast_si128(b0, LOAD(&aes[i]->k[nr << 4U])));
+            STORE(&out[(i + 1U) << 4U], _mm_aesenclast_si128(b1, LOAD(&aes[i + 1U]->k[nr << 4U])));
+            STORE(&out[(i + 2U) << 4U], _mm_aesenclast_si128(b2, LOAD(&aes[i + 2U]->k[nr << 4U])));
+            STORE(&out[(i + 3U) << 4U], _mm_aesenclast_si128(b3, LOAD(&aes[i + 3U]->k[nr << 4U])));
+
+            i += LANES;
+        }
+        else{
+
+            b0 = _mm_xor_si128(LOAD(&in[i << 4U]), LOAD(aes[i]->k));
+
+            for(r = 1U; r < nr; r++){
+
+                b0 = _mm_aesenc_si128(b0, LOAD(&aes[i]->k[r << 4U]));
+            }
+
+            STORE(&out[i << 4U], _mm_aesenclast_si128(b0, LOAD(&aes[i]->k[nr << 4U])));
+
+            i++;
+        }
+    }
+}
+
+TARGET void MODA_AES_NI_DecryptBlocks(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in, size_t n)
+{
+    __m128i k[15U];
+    __m128i b0;
+    __m128i b1;
+    __m128i b2;
+    __m128i b3;
+    uint8_t r;
+    size_t i = 0U;
+
+    decryptKeys(aes, k);
+
+    for(; (n - i) >= LANES; i += LANES){
+
+        b0 = _mm_xor_si128(LOAD(&in[i << 4U]), k[0]);
+        b1 = _mm_xor_si128(LOAD(&in[(i + 1U) << 4U]), k[0]);
+        b2 = _mm_xor_si128(LOAD(&in[(i + 2U) << 4U]), k[0]);
+        b3 = _mm_xor_si128(LOAD(&in[(i + 3U) << 4U]), k[0]);
+
+        for(r = 1U; r < aes->r; r++){
+
+            b0 = _mm_aesdec_si128(b0, k[r]);
+            b1 = _mm_aesdec_si128(b1, k[r]);
+            b2 = _mm_aesdec_si128(b2, k[r]);
+            b3 = _mm_aesdec_si128(b3, k[r]);
+        }
+
+        STORE(&out[i << 4U], _mm_aesdeclast_si128(b0, k[aes->r]));
+        STORE(&out[(i + 1U) << 4U], _mm_aesdeclast_si128(b1, k[aes->r]));
+        STORE(&out[(i + 2U) << 4U], _mm_aesdeclast_si128(b2, k[aes->r]));
+        STORE(&out[(i + 3U) << 4U], _mm_aesdeclast_si128(b3, k[aes->r]));
+    }
+
+    for(; i < n; i++){
+
+        b0 = _mm_xor_si128(LOAD(&in[i << 4U]), k[0]);
+
+        for(r = 1U; r < aes->r; r++){
+
+            b0 = _mm_aesdec_si128(b0, k[r]);
+        }
+
+        STORE(&out[i << 4U], _mm_aesdeclast_si128(b0, k[aes->r]));
+    }
+}
+
+/* static functions  **************************************************/
+
+TARGET static __m128i fold(__m128i k, __m128i t)
+{
+    __m128i acc = k;
+    __m128i shifted = k;
+
+    /* w[i] = w[i-1] ^ w[i-4] across the four words of the round key */
+    shifted = _mm_slli_si128(shifted, 4);
+    acc = _mm_xor_si128(acc, shifted);
+    shifted = _mm_slli_si128(shifted, 4);
+    acc = _mm_xor_si128(acc, shifted);
+    shifted = _mm_slli_si128(shifted, 4);
+    acc = _mm_xor_si128(acc, shifted);
+
+    return _mm_xor_si128(acc, t);
+}
+
+TARGET static __m128i expand128(__m128i k, __m128i t)
+{
+    /* RotWord(SubWord(w3)) ^ rcon */
+    return fold(k, _mm_shuffle_epi32(t, 0xff));
+}
+
+TARGET static uint32_t subWord(uint32_t w)
+{
+    /* dword 0 of AESKEYGENASSIST is SubWord(dword 1) */
+    return (uint32_t)_mm_cvtsi128_si32(_mm_aeskeygenassist_si128(_mm_set1_epi32((int)w), 0x00));
+}
+
+TARGET static void expand192(uint8_t *k, const uint8_t *key)
+{
+    uint32_t w[52U];
+    uint32_t t;
+    uint32_t rcon = 1U;
+    uint8_t i;
+
+    (void)memcpy(w, key, (size_t)AES_KEY_192);
+
+    /* words are little endian so RotWord is a right rotate */
+    for(i = 6U; i < 52U; i++){
+
+        t = w[i - 1U];
+
+        if((i % 6U) == 0U){
+
+            t = subWord((t >> 8U) | (t << 24U)) ^ rcon;
+            rcon <<= 1U;
+        }
+
+        w[i] = w[i - 6U] ^ t;
+    }
+
+    (void)memcpy(k, w, 208U);
+}
+
+TARGET static void expand256(uint8_t *k, const uint8_t *key)
+{
+    __m128i a = LOAD(key);
+    __m128i b = LOAD(&key[16U]);
+    uint8_t p = 32U;
+    int rcon;
+
+    STORE(k, a);
+    STORE(&k[16U], b);
+
+    for(rcon = 1; ; rcon <<= 1){
+
+        /* AESKEYGENASSIST needs an immediate round constant */
+        switch(rcon){
+        case 0x01: a = fold(a, _mm_shuffle_epi32(_mm_aeskeygenassist_si128(b, 0x01), 0xff)); break;
+        case 0x02: a = fold(a, _mm_shuffle_epi32(_mm_aeskeygenassist_si128(b, 0x02), 0xff)); break;
+        case 0x04: a = fold(a, _mm_shuffle_epi32(_mm_aeskeygenassist_si128(b, 0x04), 0xff)); break;
+        case 0x08: a = fold(a, _mm_shuffle_epi32(_mm_aeskeygenassist_si128(b, 0x08), 0xff)); break;
+        case 0x10: a = fold(a, _mm_shuffle_epi32(_mm_aeskeygenassist_si128(b, 0x10), 0xff)); break;
+        case 0x20: a = fold(a, _mm_shuffle_epi32(_mm_aeskeygenassist_si128(b, 0x20), 0xff)); break;
+        default:   a = fold(a, _mm_shuffle_epi32(_mm_aeskeygenassist_si128(b, 0x40), 0xff)); break;
+        }
+
+        STORE(&k[p], a);
+        p += 16U;
+
+        if(p == 240U){
+
+            break;
+        }
+
+        /* SubWord(w3) without rotation or round constant */
+        b = fold(b, _mm_shuffle_epi32(_mm_aeskeygenassist_si128(a, 0x00), 0xaa));
+
+        STORE(&k[p], b);
+        p += 16U;
+    }
+}
+
+TARGET static void decryptKeys(const struct aes_ctxt *aes, __m128i *dk)
+{
+    uint8_t r;
+
+#if defined(MODA_AES_DECRYPT_SCHEDULE)
+    for(r = 0U; r <= aes->r; r++){
+
+        dk[r] = LOAD(&aes->dk[r << 4U]);
+    }
+#else
+    dk[0] = LOAD(&aes->k[aes->r << 4U]);
+
+    for(r = 1U; r < aes->r; r++){
+
+        dk[r] = _mm_aesimc_si128(LOAD(&aes->k[(aes->r - r) << 4U]));
+    }
+
+    dk[aes->r] = LOAD(aes->k);
+#endif
+}
+
+#endif
@@ -0,0 +1,694 @@
+/* Copyright (c) 2013-2016 Cameron Harper
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * */
+
+/* includes ***********************************************************/
+
+#include "aes.h"
+#include "moda_internal.h"
+
+#if defined(MODA_AES_BITSLICE) || defined(MODA_AES_SBOX_COMPUTED)
+
+#include <string.h>
+
+/* defines ************************************************************/
+
+/* exchange bit groups between two words (see MODA_AES_Ortho()) */
+#define SWAPN(CL, CH, S, X, Y) do{ \
+    moda_slice_t a_ = (X); \
+    moda_slice_t b_ = (Y); \
+    (X) = (a_ & (CL)) | ((b_ & (CL)) << (S)); \
+    (Y) = ((a_ & (CH)) >> (S)) | (b_ & (CH)); \
+}while(0)
+
+#define SWAP2(X, Y) SWAPN((moda_slice_t)0x5555555555555555U, (moda_slice_t)0xAAAAAAAAAAAAAAAAU, 1U, X, Y)
+#define SWAP4(X, Y) SWAPN((moda_slice_t)0x3333333333333333U, (moda_slice_t)0xCCCCCCCCCCCCCCCCU, 2U, X, Y)
+#define SWAP8(X, Y) SWAPN((moda_slice_t)0x0F0F0F0F0F0F0F0FU, (moda_slice_t)0xF0F0F0F0F0F0F0F0U, 4U, X, Y)
+
+#if defined(MODA_AES_SBOX_COMPUTED)
+
+/* bits in a word of sliced state and in one of its rows */
+#define SLICE_BITS (sizeof(moda_slice_t) << 3U)
+#define ROW_BITS (MODA_SLICE_BLOCKS << 2U)
+
+/* move every row of a sliced state up by one or two rows */
+#define ROT1(X) (((X) >> ROW_BITS) | ((X) << (SLICE_BITS - ROW_BITS)))
+#define ROT2(X) (((X) >> (ROW_BITS << 1U)) | ((X) << (ROW_BITS << 1U)))
+
+/* Masks on sliced state. Each row holds a column of every block in turn
+ * (four bit groups), so a mask selects rows and, within each group,
+ * columns.
+ *
+ * SR_SWAP: columns 0 and 1 of rows 2 and 3
+ * SR_KEEP: rows 0 and 2
+ * SR_LEFT: columns 1 to 3 of rows 1 and 3
+ * SR_WRAP: column 0 of rows 1 and 3
+ * */
+#if (MODA_WORD_SIZE == 8U)
+    #define SR_SWAP 0x3333333300000000U
+    #define SR_KEEP 0x0000FFFF0000FFFFU
+    #define SR_LEFT 0xEEEE0000EEEE0000U
+    #define SR_WRAP 0x1111000011110000U
+#else
+    #define SR_SWAP 0x33330000U
+    #define SR_KEEP 0x00FF00FFU
+    #define SR_LEFT 0xEE00EE00U
+    #define SR_WRAP 0x11001100U
+#endif
+
+#endif
+
+/* static function prototypes *****************************************/
+
+/**
+ * Inverse affine transform used by MODA_AES_InvSbox()
+ *
+ * @param[in/out] q eight words
+ *
+ * */
+static void invAffine(moda_slice_t *q);
+
+#if defined(MODA_AES_SBOX_COMPUTED)
+/**
+ * Word `e` of #MODA_SLICE_BLOCKS blocks ahead of MODA_AES_Ortho()
+ *
+ * Word E = 4 * J + C holds column C of block J (with 64 bit words, the
+ * even bytes from block J and the odd bytes from block J + 2). The
+ * transpose then leaves byte R + 4C of block J at bit
+ * 4 * (#MODA_SLICE_BLOCKS * R + J) + C of each word.
+ *
+ * @param[in] in `n` blocks
+ * @param[in] n blocks present, the rest read as zero
+ * @param[in] e word
+ * @return word
+ *
+ * */
+static moda_slice_t loadColumn(const uint8_t *in, size_t n, uint8_t e);
+
+/**
+ * Inverse of loadColumn()
+ *
+ * @param[out] out `n` blocks
+ * @param[in] n blocks to write
+ * @param[in] e word
+ * @param[in] x word
+ *
+ * */
+static void storeColumn(uint8_t *out, size_t n, uint8_t e, moda_slice_t x);
+
+#if (MODA_WORD_SIZE == 8U)
+/**
+ * Spread four bytes over the even bytes of a word
+ *
+ * @param[in] x four bytes
+ * @return word
+ *
+ * */
+static uint64_t spread(uint32_t x);
+
+/**
+ * Inverse of spread()
+ *
+ * @param[in] x word
+ * @return even bytes of `x`
+ *
+ * */
+static uint32_t gather(uint64_t x);
+#endif
+
+static uint32_t dec32le(const uint8_t *b);
+static void enc32le(uint8_t *b, uint32_t w);
+
+/**
+ * ShiftRows on a sliced state
+ *
+ * @param[in/out] q eight words
+ *
+ * */
+static void shiftRows(moda_slice_t *q);
+
+/**
+ * InvShiftRows on a sliced state
+ *
+ * @param[in/out] q eight words
+ *
+ * */
+static void invShiftRows(moda_slice_t *q);
+
+/**
+ * MixColumns on a sliced state
+ *
+ * @param[in/out] q eight words
+ *
+ * */
+static void mixColumns(moda_slice_t *q);
+
+/**
+ * InvMixColumns on a sliced state
+ *
+ * @param[in/out] q eight words
+ *
+ * */
+static void invMixColumns(moda_slice_t *q);
+#endif
+
+/* functions **********************************************************/
+
+/* Boyar and Peralta, "A depth-16 circuit for the AES S-box" (113 gates) */
+void MODA_AES_Sbox(moda_slice_t *q)
+{
+    moda_slice_t x0, x1, x2, x3, x4, x5, x6, x7;
+    moda_slice_t y1, y2, y3, y4, y5, y6, y7, y8, y9;
+    moda_slice_t y10, y11, y12, y13, y14, y15, y16, y17, y18, y19;
+    moda_slice_t y20, y21;
+    moda_slice_t z0, z1, z2, z3, z4, z5, z6, z7, z8, z9;
+    moda_slice_t z10, z11, z12, z13, z14, z15, z16, z17;
+    moda_slice_t t0, t1, t2, t3, t4, t5, t6, t7, t8, t9;
+    moda_slice_t t10, t11, t12, t13, t14, t15, t16, t17, t18, t19;
+    moda_slice_t t20, t21, t22, t23, t24, t25, t26, t27, t28, t29;
+    moda_slice_t t30, t31, t32, t33, t34, t35, t36, t37, t38, t39;
+    moda_slice_t t40, t41, t42, t43, t44, t45, t46, t47, t48, t49;
+    moda_slice_t t50, t51, t52, t53, t54, t55, t56, t57, t58, t59;
+    moda_slice_t t60, t61, t62, t63, t64, t65, t66, t67;
+    moda_slice_t s0, s1, s2, s3, s4, s5, s6, s7;
+
+    /* the circuit numbers bits from the most significant */
+    x0 = q[7];
+    x1 = q[6];
+    x2 = q[5];
+    x3 = q[4];
+    x4 = q[3];
+    x5 = q[2];
+    x6 = q[1];
+    x7 = q[0];
+
+    /* top linear transformation */
+    y14 = x3 ^ x5;
+    y13 = x0 ^ x6;
+    y9 = x0 ^ x3;
+    y8 = x0 ^ x5;
+    t0 = x1 ^ x2;
+    y1 = t0 ^ x7;
+    y4 = y1 ^ x3;
+    y12 = y13 ^ y14;
+    y2 = y1 ^ x0;
+    y5 = y1 ^ x6;
+    y3 = y5 ^ y8;
+    t1 = x4 ^ y12;
+    y15 = t1 ^ x5;
+    y20 = t1 ^ x1;
+    y6 = y15 ^ x7;
+    y10 = y15 ^ t0;
+    y11 = y20 ^ y9;
+    y7 = x7 ^ y11;
+    y17 = y10 ^ y11;
+    y19 = y10 ^ y8;
+    y16 = t0 ^ y11;
+    y21 = y13 ^ y16;
+    y18 = x0 ^ y16;
+
+    /* non-linear section */
+    t2 = y12 & y15;
+    t3 = y3 & y6;
+    t4 = t3 ^ t2;
+    t5 = y4 & x7;
+    t6 = t5 ^ t2;
+    t7 = y13 & y16;
+    t8 = y5 & y1;
+    t9 = t8 ^ t7;
+    t10 = y2 & y7;
+    t11 = t10 ^ t7;
+    t12 = y9 & y11;
+    t13 = y14 & y17;
+    t14 = t13 ^ t12;
+    t15 = y8 & y10;
+    t16 = t15 ^ t12;
+    t17 = t4 ^ t14;
+    t18 = t6 ^ t16;
+    t19 = t9 ^ t14;
+    t20 = t11 ^ t16;
+    t21 = t17 ^ y20;
+    t22 = t18 ^ y19;
+    t23 = t19 ^ y21;
+    t24 = t20 ^ y18;
+
+    t25 = t21 ^ t22;
+    t26 = t21 & t23;
+    t27 = t24 ^ t26;
+    t28 = t25 & t27;
+    t29 = t28 ^ t22;
+    t30 = t23 ^ t24;
+    t31 = t22 ^ t26;
+    t32 = t31 & t30;
+    t33 = t32 ^ t24;
+    t34 = t23 ^ t33;
+    t35 = t27 ^ t33;
+    t36 = t24 & t35;
+    t37 = t36 ^ t34;
+    t38 = t27 ^ t36;
+    t39 = t29 & t38;
+    t40 = t25 ^ t39;
+
+    t41 = t40 ^ t37;
+    t42 = t29 ^ t33;
+    t43 = t29 ^ t40;
+    t44 = t33 ^ t37;
+    t45 = t42 ^ t41;
+    z0 = t44 & y15;
+    z1 = t37 & y6;
+    z2 = t33 & x7;
+    z3 = t43 & y16;
+    z4 = t40 & y1;
+    z5 = t29 & y7;
+    z6 = t42 & y11;
+    z7 = t45 & y17;
+    z8 = t41 & y10;
+    z9 = t44 & y12;
+    z10 = t37 & y3;
+    z11 = t33 & y4;
+    z12 = t43 & y13;
+    z13 = t40 & y5;
+    z14 = t29 & y2;
+    z15 = t42 & y9;
+    z16 = t45 & y14;
+    z17 = t41 & y8;
+
+    /* bottom linear transformation */
+    t46 = z15 ^ z16;
+    t47 = z10 ^ z11;
+    t48 = z5 ^ z13;
+    t49 = z9 ^ z10;
+    t50 = z2 ^ z12;
+    t51 = z2 ^ z5;
+    t52 = z7 ^ z8;
+    t53 = z0 ^ z3;
+    t54 = z6 ^ z7;
+    t55 = z16 ^ z17;
+    t56 = z12 ^ t48;
+    t57 = t50 ^ t53;
+    t58 = z4 ^ t46;
+    t59 = z3 ^ t54;
+    t60 = t46 ^ t57;
+    t61 = z14 ^ t57;
+    t62 = t52 ^ t58;
+    t63 = t49 ^ t58;
+    t64 = z4 ^ t59;
+    t65 = t61 ^ t62;
+    t66 = z1 ^ t63;
+    s0 = t59 ^ t63;
+    s6 = t56 ^ ~t62;
+    s7 = t48 ^ ~t60;
+    t67 = t64 ^ t65;
+    s3 = t53 ^ t66;
+    s4 = t51 ^ t66;
+    s5 = t47 ^ t65;
+    s1 = t64 ^ ~s3;
+    s2 = t55 ^ ~t67;
+
+    q[7] = s0;
+    q[6] = s1;
+    q[5] = s2;
+    q[4] = s3;
+    q[3] = s4;
+    q[2] = s5;
+    q[1] = s6;
+    q[0] = s7;
+}
+
+void MODA_AES_InvSbox(moda_slice_t *q)
+{
+    /* InvSubBytes(x) = A'(SubBytes(A'(x))) */
+    invAffine(q);
+    MODA_AES_Sbox(q);
+    invAffine(q);
+}
+
+void MODA_AES_Ortho(moda_slice_t *q)
+{
+    SWAP2(q[0], q[1]);
+    SWAP2(q[2], q[3]);
+    SWAP2(q[4], q[5]);
+    SWAP2(q[6], q[7]);
+
+    SWAP4(q[0], q[2]);
+    SWAP4(q[1], q[3]);
+    SWAP4(q[4], q[6]);
+    SWAP4(q[5], q[7]);
+
+    SWAP8(q[0], q[4]);
+    SWAP8(q[1], q[5]);
+    SWAP8(q[2], q[6]);
+    SWAP8(q[3], q[7]);
+}
+
+#if defined(MODA_AES_SBOX_COMPUTED)
+void MODA_AES_SubWords(uint32_t *w, size_t n)
+{
+    moda_slice_t q[8U];
+    uint32_t x;
+    size_t i;
+
+    ASSERT(((n > 0U) && (n <= 8U)))
+
+    if(n == 1U){
+
+        /* word B takes bit B of every byte, the other bits are ignored */
+        for(i = 0U; i < 8U; i++){
+
+            q[i] = (moda_slice_t)(w[0] >> i) & 0x01010101U;
+        }
+
+        MODA_AES_Sbox(q);
+
+        x = 0U;
+
+        for(i = 0U; i < 8U; i++){
+
+            x |= ((uint32_t)q[i] & 0x01010101U) << i;
+        }
+
+        w[0] = x;
+    }
+    else{
+
+        /* transpose so that word B takes bit B of every byte of every word */
+        (void)memset(q, 0, sizeof(q));
+
+        for(i = 0U; i < n; i++){
+
+            q[i] = w[i];
+        }
+
+        MODA_AES_Ortho(q);
+        MODA_AES_Sbox(q);
+        MODA_AES_Ortho(q);
+
+        for(i = 0U; i < n; i++){
+
+            w[i] = (uint32_t)q[i];
+        }
+    }
+
+    (void)memset(q, 0, sizeof(q));
+}
+
+void MODA_AES_SliceIn(moda_slice_t *q, const uint8_t *in, size_t n)
+{
+    uint8_t e;
+
+    ASSERT(((n > 0U) && (n <= MODA_SLICE_BLOCKS)))
+
+    for(e = 0U; e < 8U; e++){
+
+        q[e] = loadColumn(in, n, e);
+    }
+
+    MODA_AES_Ortho(q);
+}
+
+void MODA_AES_SliceOut(uint8_t *out, const moda_slice_t *q, size_t n)
+{
+    moda_slice_t t[8U];
+    uint8_t e;
+
+    ASSERT(((n > 0U) && (n <= MODA_SLICE_BLOCKS)))
+
+    (void)memcpy(t, q, sizeof(t));
+
+    MODA_AES_Ortho(t);
+
+    for(e = 0U; e < 8U; e++){
+
+        storeColumn(out, n, e, t[e]);
+    }
+
+    (void)memset(t, 0, sizeof(t));
+}
+
+void MODA_AES_SliceKey(moda_slice_t *q, const uint8_t *k)
+{
+    uint8_t i;
+
+    /* the key goes in as every block at once */
+    for(i = 0U; i < 4U; i++){
+
+#if (MODA_WORD_SIZE == 8U)
+        q[i] = spread(dec32le(&k[i << 2U]));
+        q[i] |= q[i] << 8U;
+#else
+        q[i] = dec32le(&k[i << 2U]);
+#endif
+        q[i + 4U] = q[i];
+    }
+
+    MODA_AES_Ortho(q);
+}
+
+void MODA_AES_SlicedAddRoundKey(moda_slice_t *q, const moda_slice_t *k)
+{
+    q[0] ^= k[0];
+    q[1] ^= k[1];
+    q[2] ^= k[2];
+    q[3] ^= k[3];
+    q[4] ^= k[4];
+    q[5] ^= k[5];
+    q[6] ^= k[6];
+    q[7] ^= k[7];
+}
+
+void MODA_AES_SlicedRound(moda_slice_t *q, const moda_slice_t *k, bool mix)
+{
+    MODA_AES_SlicedAddRoundKey(q, k);
+    MODA_AES_Sbox(q);
+    shiftRows(q);
+
+    if(mix){
+
+        mixColumns(q);
+    }
+}
+
+void MODA_AES_SlicedInvRound(moda_slice_t *q, const moda_slice_t *k, bool mix)
+{
+    if(mix){
+
+        invMixColumns(q);
+    }
+
+    invShiftRows(q);
+    MODA_AES_InvSbox(q);
+    MODA_AES_SlicedAddRoundKey(q, k);
+}
+#endif
+
+/* static functions  **************************************************/
+
+static void invAffine(moda_slice_t *q)
+{
+    moda_slice_t q0 = ~q[0];
+    moda_slice_t q1 = ~q[1];
+    moda_slice_t q2 = q[2];
+    moda_slice_t q3 = q[3];
+    moda_slice_t q4 = q[4];
+    moda_slice_t q5 = ~q[5];
+    moda_slice_t q6 = ~q[6];
+    moda_slice_t q7 = q[7];
+
+    q[7] = q1 ^ q4 ^ q6;
+    q[6] = q0 ^ q3 ^ q5;
+    q[5] = q7 ^ q2 ^ q4;
+    q[4] = q6 ^ q1 ^ q3;
+    q[3] = q5 ^ q0 ^ q2;
+    q[2] = q4 ^ q7 ^ q1;
+    q[1] = q3 ^ q6 ^ q0;
+    q[0] = q2 ^ q5 ^ q7;
+}
+
+#if defined(MODA_AES_SBOX_COMPUTED)
+static moda_slice_t loadColumn(const uint8_t *in, size_t n, uint8_t e)
+{
+    size_t j = (size_t)e >> 2U;
+    size_t c = (size_t)e & 3U;
+    moda_slice_t x = (j < n) ? dec32le(&in[(j << 4U) + (c << 2U)]) : 0U;
+
+#if (MODA_WORD_SIZE == 8U)
+    x = spread((uint32_t)x);
+
+    if((j + 2U) < n){
+
+        x |= spread(dec32le(&in[((j + 2U) << 4U) + (c << 2U)])) << 8U;
+    }
+#endif
+
+    return x;
+}
+
+static void storeColumn(uint8_t *out, size_t n, uint8_t e, moda_slice_t x)
+{
+    size_t j = (size_t)e >> 2U;
+    size_t c = (size_t)e & 3U;
+
+#if (MODA_WORD_SIZE == 8U)
+    if((j + 2U) < n){
+
+        enc32le(&out[((j + 2U) << 4U) + (c << 2U)], gather(x >> 8U));
+    }
+
+    x = gather(x);
+#endif
+
+    if(j < n){
+
+        enc32le(&out[(j << 4U) + (c << 2U)], (uint32_t)x);
+    }
+}
+
+#if (MODA_WORD_SIZE == 8U)
+static uint64_t spread(uint32_t x)
+{
+    uint64_t retval = x;
+
+    retval = (retval | (retval << 16U)) & 0x0000FFFF0000FFFFU;
+    retval = (retval | (retval << 8U)) & 0x00FF00FF00FF00FFU;
+
+    return retval;
+}
+
+static uint32_t gather(uint64_t x)
+{
+    uint64_t retval = x & 0x00FF00FF00FF00FFU;
+
+    retval = (retval | (retval >> 8U)) & 0x0000FFFF0000FFFFU;
+
+    return (uint32_t)retval | (uint32_t)(retval >> 16U);
+}
+#endif
+
+static uint32_t dec32le(const uint8_t *b)
+{
+    return (uint32_t)b[0] | ((uint32_t)b[1] << 8U) | ((uint32_t)b[2] << 16U) | ((uint32_t)b[3] << 24U);
+}
+
+static void enc32le(uint8_t *b, uint32_t w)
+{
+    b[0] = (uint8_t)w;
+    b[1] = (uint8_t)(w >> 8U);
+    b[2] = (uint8_t)(w >> 16U);
+    b[3] = (uint8_t)(w >> 24U);
+}
+
+static void shiftRows(moda_slice_t *q)
+{
+    moda_slice_t x;
+    moda_slice_t t;
+    uint8_t i;
+
+    for(i = 0U; i < 8U; i++){
+
+        x = q[i];
+
+        /* rows 2 and 3 left by two columns */
+        t = (x ^ (x >> 2U)) & (moda_slice_t)SR_SWAP;
+        x ^= t ^ (t << 2U);
+
+        /* rows 1 and 3 left by one column */
+        q[i] = (x & (moda_slice_t)SR_KEEP) | ((x & (moda_slice_t)SR_LEFT) >> 1U) | ((x & (moda_slice_t)SR_WRAP) << 3U);
+    }
+}
+
+static void invShiftRows(moda_slice_t *q)
+{
+    moda_slice_t x;
+    moda_slice_t t;
+    uint8_t i;
+
+    for(i = 0U; i < 8U; i++){
+
+        x = q[i];
+
+        /* rows 1 and 3 right by one column */
+        x = (x & (moda_slice_t)SR_KEEP) | ((x << 1U) & (moda_slice_t)SR_LEFT) | ((x >> 3U) & (moda_slice_t)SR_WRAP);
+
+        /* rows 2 and 3 right by two columns */
+        t = (x ^ (x >> 2U)) & (moda_slice_t)SR_SWAP;
+        q[i] = x ^ t ^ (t << 2U);
+    }
+}
+
+static void mixColumns(moda_slice_t *q)
+{
+    moda_slice_t q0 = q[0];
+    moda_slice_t q1 = q[1];
+    moda_slice_t q2 = q[2];
+    moda_slice_t q3 = q[3];
+    moda_slice_t q4 = q[4];
+    moda_slice_t q5 = q[5];
+    moda_slice_t q6 = q[6];
+    moda_slice_t q7 = q[7];
+    moda_slice_t r0 = ROT1(q0);
+    moda_slice_t r1 = ROT1(q1);
+    moda_slice_t r2 = ROT1(q2);
+    moda_slice_t r3 = ROT1(q3);
+    moda_slice_t r4 = ROT1(q4);
+    moda_slice_t r5 = ROT1(q5);
+    moda_slice_t r6 = ROT1(q6);
+    moda_slice_t r7 = ROT1(q7);
+
+    q[0] = q7 ^ r7 ^ r0 ^ ROT2(q0 ^ r0);
+    q[1] = q0 ^ r0 ^ q7 ^ r7 ^ r1 ^ ROT2(q1 ^ r1);
+    q[2] = q1 ^ r1 ^ r2 ^ ROT2(q2 ^ r2);
+    q[3] = q2 ^ r2 ^ q7 ^ r7 ^ r3 ^ ROT2(q3 ^ r3);
+    q[4] = q3 ^ r3 ^ q7 ^ r7 ^ r4 ^ ROT2(q4 ^ r4);
+    q[5] = q4 ^ r4 ^ r5 ^ ROT2(q5 ^ r5);
+    q[6] = q5 ^ r5 ^ r6 ^ ROT2(q6 ^ r6);
+    q[7] = q6 ^ r6 ^ r7 ^ ROT2(q7 ^ r7);
+}
+
+static void invMixColumns(moda_slice_t *q)
+{
+    moda_slice_t q0 = q[0];
+    moda_slice_t q1 = q[1];
+    moda_slice_t q2 = q[2];
+    moda_slice_t q3 = q[3];
+    moda_slice_t q4 = q[4];
+    moda_slice_t q5 = q[5];
+    moda_slice_t q6 = q[6];
+    moda_slice_t q7 = q[7];
+    moda_slice_t r0 = ROT1(q0);
+    moda_slice_t r1 = ROT1(q1);
+    moda_slice_t r2 = ROT1(q2);
+    moda_slice_t r3 = ROT1(q3);
+    moda_slice_t r4 = ROT1(q4);
+    moda_slice_t r5 = ROT1(q5);
+    moda_slice_t r6 = ROT1(q6);
+    moda_slice_t r7 = ROT1(q7);
+
+    q[0] = q5 ^ q6 ^ q7 ^ r0 ^ r5 ^ r7 ^ ROT2(q0 ^ q5 ^ q6 ^ r0 ^ r5);
+    q[1] = q0 ^ q5 ^ r0 ^ r1 ^ r5 ^ r6 ^ r7 ^ ROT2(q1 ^ q5 ^ q7 ^ r1 ^ r5 ^ r6);
+    q[2] = q0 ^ q1 ^ q6 ^ r1 ^ r2 ^ r6 ^ r7 ^ ROT2(q0 ^ q2 ^ q6 ^ r2 ^ r6 ^ r7);
+    q[3] = q0 ^ q1 ^ q2 ^ q5 ^ q6 ^ r0 ^ r2 ^ r3 ^ r5 ^ ROT2(q0 ^ q1 ^ q3 ^ q5 ^ q6 ^ q7 ^ r0 ^ r3 ^ r5 ^ r7);
+    q[4] = q1 ^ q2 ^ q3 ^ q5 ^ r1 ^ r3 ^ r4 ^ r5 ^ r6 ^ r7 ^ ROT2(q1 ^ q2 ^ q4 ^ q5 ^ q7 ^ r1 ^ r4 ^ r5 ^ r6);
+    q[5] = q2 ^ q3 ^ q4 ^ q6 ^ r2 ^ r4 ^ r5 ^ r6 ^ r7 ^ ROT2(q2 ^ q3 ^ q5 ^ q6 ^ r2 ^ r5 ^ r6 ^ r7);
+    q[6] = q3 ^ q4 ^ q5 ^ q7 ^ r3 ^ r5 ^ r6 ^ r7 ^ ROT2(q3 ^ q4 ^ q6 ^ q7 ^ r3 ^ r6 ^ r7);
+    q[7] = q4 ^ q5 ^ q6 ^ r4 ^ r6 ^ r7 ^ ROT2(q4 ^ q5 ^ q7 ^ r4 ^ r7);
+}
+#endif
+
+#endif
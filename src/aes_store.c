@@ -0,0 +1,320 @@
+/* Copyright (c) 2013-2016 Cameron Harper
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * */
+
+/* includes ***********************************************************/
+
+#include "aes.h"
+#include "aes_store.h"
+#include "aes_cmac.h"
+#include "aes_gcm.h"
+#include "moda_internal.h"
+
+#include <string.h>
+
+/* defines ************************************************************/
+
+#define ORDER 0x01020304U
+
+/* options */
+#define OPT_OTF         0x01U
+#define OPT_BITSLICE    0x02U
+#define OPT_DS          0x04U
+#define OPT_SLICED      0x08U   /* sliced schedule after the round keys */
+#define OPT_NI          0x10U   /* expanded by the AES-NI backend */
+#define OPT_VPERM       0x20U   /* expanded by the SSSE3 backend */
+#define OPT_PCLMUL      0x40U   /* powers of H filled in */
+
+/* page verification state */
+#define PAGE_UNCHECKED  0U
+#define PAGE_GOOD       1U
+#define PAGE_BAD        2U
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define LOAD_FLAG(P) __atomic_load_n((P), __ATOMIC_ACQUIRE)
+    #define STORE_FLAG(P, V) __atomic_store_n((P), (V), __ATOMIC_RELEASE)
+#else
+    #define LOAD_FLAG(P) (*(P))
+    #define STORE_FLAG(P, V) (*(P) = (V))
+#endif
+
+/* static variables ***************************************************/
+
+static const uint8_t magic[8U] = {'M', 'O', 'D', 'A', 'K', 'E', 'Y', 'S'};
+
+/* static function prototypes *****************************************/
+
+/**
+ * Options and run time backend that decide the layout of an entry
+ *
+ * @return OPT_* flags with MODA_AES_ALIGN in bits 8..15 and
+ * MODA_WORD_SIZE (GHASH word order of H) in bits 16..23
+ *
+ * */
+static uint32_t options(void);
+
+/**
+ * Byte offset of the first entry
+ *
+ * @param[in] pages number of pages
+ * @return offset
+ *
+ * */
+static size_t entryOffset(uint32_t pages);
+
+/**
+ * Tag a page, binding it to its position and to the header
+ *
+ * The page CMAC is XORed with the header tag and page number and
+ * encrypted once more, so pages cannot be moved within or between
+ * images that share a CMAC key.
+ *
+ * @param[in] mac CMAC key
+ * @param[in] header
+ * @param[in] page page number
+ * @param[in] in first entry of the page
+ * @param[out] tag #AES_STORE_TAG_SIZE bytes
+ *
+ * */
+static void pageTag(const struct aes_ctxt *mac, const struct aes_store_header *header, uint32_t page, const uint8_t *in, uint8_t *tag);
+
+/* functions **********************************************************/
+
+size_t MODA_AES_StoreSize(uint32_t count, uint32_t perPage)
+{
+    uint32_t pages;
+
+    ASSERT((perPage > 0U))
+
+    pages = (count / perPage) + (((count % perPage) != 0U) ? 1U : 0U);
+
+    return entryOffset(pages) + ((size_t)count * sizeof(struct aes_store_entry));
+}
+
+bool MODA_AES_StoreFormat(void *image, size_t imageSize, uint32_t count, uint32_t perPage)
+{
+    struct aes_store_header *header = (struct aes_store_header *)image;
+    bool retval = false;
+
+    ASSERT((image != NULL))
+    ASSERT((perPage > 0U))
+    ASSERT((((uintptr_t)image % MODA_AES_ALIGN) == 0U))
+
+    if(imageSize >= MODA_AES_StoreSize(count, perPage)){
+
+        (void)memset(image, 0, MODA_AES_StoreSize(count, perPage));
+
+        (void)memcpy(header->magic, magic, sizeof(magic));
+        header->order = ORDER;
+        header->options = options();
+        header->entrySize = (uint32_t)sizeof(struct aes_store_entry);
+        header->count = count;
+        header->perPage = perPage;
+        header->pages = (count / perPage) + (((count % perPage) != 0U) ? 1U : 0U);
+        header->entryOffset = (uint32_t)entryOffset(header->pages);
+
+        retval = true;
+    }
+
+    return retval;
+}
+
+void MODA_AES_StorePut(void *image, uint32_t index, enum aes_key_size keySize, const uint8_t *key)
+{
+    const struct aes_store_header *header = (const struct aes_store_header *)image;
+    struct aes_store_entry *entry;
+
+    ASSERT((image != NULL))
+    ASSERT((key != NULL))
+    ASSERT((index < header->count))
+
+    entry = &((struct aes_store_entry *)(void *)&((uint8_t *)image)[header->entryOffset])[index];
+
+    MODA_AES_GCM_Init(&entry->gcm, keySize, key);
+}
+
+void MODA_AES_StoreSeal(void *image, const struct aes_ctxt *mac)
+{
+    struct aes_store_header *header = (struct aes_store_header *)image;
+    uint8_t *tags = &((uint8_t *)image)[sizeof(struct aes_store_header)];
+    const uint8_t *entries = &((const uint8_t *)image)[header->entryOffset];
+    uint32_t page;
+
+    ASSERT((image != NULL))
+    ASSERT((mac != NULL))
+
+    MODA_AES_CMAC(mac, (const uint8_t *)header, (uint32_t)offsetof(struct aes_store_header, tag), header->tag, AES_STORE_TAG_SIZE);
+
+    for(page = 0U; page < header->pages; page++){
+
+        pageTag(mac, header, page, &entries[(size_t)page * header->perPage * sizeof(struct aes_store_entry)], &tags[page * AES_STORE_TAG_SIZE]);
+    }
+}
+
+bool MODA_AES_StoreOpen(struct aes_store *store, const void *image, size_t imageSize, const struct aes_ctxt *mac, uint8_t *verified, size_t verifiedSize)
+{
+    const struct aes_store_header *header = (const struct aes_store_header *)image;
+    uint8_t tag[AES_STORE_TAG_SIZE];
+    bool retval = false;
+
+    ASSERT((store != NULL))
+    ASSERT((image != NULL))
+    ASSERT((mac != NULL))
+    ASSERT((verified != NULL))
+    ASSERT((((uintptr_t)image % MODA_AES_ALIGN) == 0U))
+
+    if(imageSize >= sizeof(struct aes_store_header)){
+
+        MODA_AES_CMAC(mac, (const uint8_t *)header, (uint32_t)offsetof(struct aes_store_header, tag), tag, sizeof(tag));
+
+        if((memcmp(tag, header->tag, sizeof(tag)) == 0) &&
+            (memcmp(header->magic, magic, sizeof(magic)) == 0) &&
+            (header->order == ORDER) &&
+            (header->options == options()) &&
+            (header->entrySize == (uint32_t)sizeof(struct aes_store_entry)) &&
+            (header->perPage > 0U) &&
+            (header->pages == ((header->count / header->perPage) + (((header->count % header->perPage) != 0U) ? 1U : 0U))) &&
+            (header->entryOffset == (uint32_t)entryOffset(header->pages)) &&
+            (header->pages <= verifiedSize) &&
+            (imageSize >= MODA_AES_StoreSize(header->count, header->perPage))
+        ){
+
+            store->image = (const uint8_t *)image;
+            store->mac = mac;
+            store->verified = verified;
+            store->count = header->count;
+            store->perPage = header->perPage;
+            store->pages = header->pages;
+            store->entryOffset = header->entryOffset;
+
+            /* one byte per page: stale flags would skip authentication */
+            (void)memset(verified, PAGE_UNCHECKED, header->pages);
+
+            retval = true;
+        }
+    }
+
+    return retval;
+}
+
+const struct aes_store_entry *MODA_AES_StoreGet(struct aes_store *store, uint32_t index)
+{
+    const struct aes_store_entry *entries;
+    const struct aes_store_entry *retval = NULL;
+    uint8_t tag[AES_STORE_TAG_SIZE];
+    uint32_t page;
+    uint8_t state;
+
+    ASSERT((store != NULL))
+
+    if(index < store->count){
+
+        entries = (const struct aes_store_entry *)(const void *)&store->image[store->entryOffset];
+        page = index / store->perPage;
+        state = LOAD_FLAG(&store->verified[page]);
+
+        if(state == PAGE_UNCHECKED){
+
+            pageTag(store->mac, (const struct aes_store_header *)(const void *)store->image, page, (const uint8_t *)&entries[page * store->perPage], tag);
+
+            state = (memcmp(tag, &store->image[sizeof(struct aes_store_header) + ((size_t)page * AES_STORE_TAG_SIZE)], sizeof(tag)) == 0) ? PAGE_GOOD : PAGE_BAD;
+
+            STORE_FLAG(&store->verified[page], state);
+        }
+
+        if(state == PAGE_GOOD){
+
+            retval = &entries[index];
+        }
+    }
+
+    return retval;
+}
+
+/* static functions  **************************************************/
+
+static uint32_t options(void)
+{
+    uint32_t retval = ((uint32_t)MODA_AES_ALIGN << 8U) | ((uint32_t)MODA_WORD_SIZE << 16U);
+
+#if defined(MODA_AES_OTF)
+    retval |= OPT_OTF;
+#endif
+#if defined(MODA_AES_BITSLICE)
+    retval |= OPT_BITSLICE;
+#endif
+#if defined(MODA_AES_DECRYPT_SCHEDULE)
+    retval |= OPT_DS;
+#endif
+#if defined(MODA_AES_SBOX_COMPUTED) && !defined(MODA_AES_OTF)
+    retval |= OPT_SLICED;
+#endif
+
+    /* a run time backend may fill the context differently from the portable engine */
+#if defined(MODA_AES_NI)
+    if(MODA_CPU_HAS(MODA_CPU_AES)){
+
+        retval |= OPT_NI;
+    }
+#endif
+#if defined(MODA_AES_VPERM)
+    if(((retval & OPT_NI) == 0U) && MODA_CPU_HAS(MODA_CPU_SSSE3)){
+
+        retval |= OPT_VPERM;
+    }
+#endif
+#if defined(MODA_GCM_PCLMUL)
+    if(MODA_CPU_HAS(MODA_CPU_PCLMUL)){
+
+        retval |= OPT_PCLMUL;
+    }
+#endif
+
+    return retval;
+}
+
+static size_t entryOffset(uint32_t pages)
+{
+    size_t offset = sizeof(struct aes_store_header) + ((size_t)pages * AES_STORE_TAG_SIZE);
+
+    return ((offset + (AES_STORE_ALIGN - 1U)) / AES_STORE_ALIGN) * AES_STORE_ALIGN;
+}
+
+static void pageTag(const struct aes_ctxt *mac, const struct aes_store_header *header, uint32_t page, const uint8_t *in, uint8_t *tag)
+{
+    uint32_t n = header->count - (page * header->perPage);
+    uint8_t i;
+
+    n = (n < header->perPage) ? n : header->perPage;
+
+    MODA_AES_CMAC(mac, in, n * (uint32_t)sizeof(struct aes_store_entry), tag, AES_STORE_TAG_SIZE);
+
+    for(i = 0U; i < AES_STORE_TAG_SIZE; i++){
+
+        tag[i] ^= header->tag[i];
+    }
+
+    tag[12] ^= (uint8_t)(page >> 24);
+    tag[13] ^= (uint8_t)(page >> 16);
+    tag[14] ^= (uint8_t)(page >> 8);
+    tag[15] ^= (uint8_t)page;
+
+    MODA_AES_Encrypt(mac, tag);
+}
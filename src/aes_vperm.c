@@ -0,0 +1,493 @@
+/* Copyright (c) 2013-2016 Cameron Harper
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * */
+
+/* includes ***********************************************************/
+
+#include "aes.h"
+#include "moda_internal.h"
+
+#if defined(MODA_AES_VPERM)
+
+#include <string.h>
+#include <emmintrin.h>
+#include <tmmintrin.h>
+
+/* defines ************************************************************/
+
+/* compile for SSSE3 without requiring -mssse3 for the whole project */
+#define TARGET __attribute__((target("ssse3")))
+
+#define LOAD(P) _mm_loadu_si128((const __m128i *)(const void *)(P))
+#define STORE(P, V) _mm_storeu_si128((__m128i *)(void *)(P), (V))
+
+/* 16 entry table lookup indexed by the low nibble of each byte (zero if bit 7 is set) */
+#define LOOKUP(T, I) _mm_shuffle_epi8(LOAD(T), (I))
+
+/* move bytes of V as listed in table T */
+#define PERMUTE(V, T) _mm_shuffle_epi8((V), LOAD(T))
+
+/* number of blocks interleaved by the multi-block functions */
+#define LANES 4U
+
+/* static variables ***************************************************/
+
+/*
+ * SubBytes is computed in GF((2^4)^2) where GF(2^4) is GF(2)[z]/(z^4 + z + 1)
+ * and an element is a*y + b with y^2 = y + 0x8. In this field
+ *
+ *      1/(a*y + b) = (a*y + (a + b)) / (0x8*a^2 + b*(a + b))
+ *
+ * so an inversion needs only 16 entry tables indexed by a nibble. GF(2^4)
+ * products are exp(log(x) + log(y)) with log(0) = 0xf0 so that any product
+ * involving zero selects zero.
+ *
+ * Each direction has its own tables for mapping a state byte into the
+ * tower field (split by input nibble) and back (split by `a` and `b`).
+ * The affine transform and its constant are folded into these tables.
+ *
+ * */
+
+/** tables for one direction of the cipher */
+struct basis {
+
+    uint8_t ml[16U];    /**< low input nibble to tower field */
+    uint8_t mh[16U];    /**< high input nibble to tower field */
+    uint8_t oh[16U];    /**< `a` of the inverse to output byte */
+    uint8_t ol[16U];    /**< `b` of the inverse to output byte */
+};
+
+MODA_CONST_PRE static const struct basis encBasis MODA_CONST_POST = {
+    {0x00U, 0x01U, 0x20U, 0x21U, 0x46U, 0x47U, 0x66U, 0x67U, 0x4cU, 0x4dU, 0x6cU, 0x6dU, 0x0aU, 0x0bU, 0x2aU, 0x2bU},
+    {0x00U, 0x3cU, 0xd5U, 0xe9U, 0x34U, 0x08U, 0xe1U, 0xddU, 0xe5U, 0xd9U, 0x30U, 0x0cU, 0xd1U, 0xedU, 0x04U, 0x38U},
+    {0x00U, 0x52U, 0x3eU, 0x6cU, 0x65U, 0x37U, 0x5bU, 0x09U, 0x60U, 0x32U, 0x5eU, 0x0cU, 0x05U, 0x57U, 0x3bU, 0x69U},
+    {0x63U, 0x7cU, 0xd1U, 0xceU, 0xc8U, 0xd7U, 0x7aU, 0x65U, 0x55U, 0x4aU, 0xe7U, 0xf8U, 0xfeU, 0xe1U, 0x4cU, 0x53U}
+};
+
+MODA_CONST_PRE static const struct basis decBasis MODA_CONST_POST = {
+    {0x47U, 0x1fU, 0xd8U, 0x80U, 0xdfU, 0x87U, 0x40U, 0x18U, 0x6fU, 0x37U, 0xf0U, 0xa8U, 0xf7U, 0xafU, 0x68U, 0x30U},
+    {0x00U, 0x76U, 0x79U, 0x0fU, 0xf9U, 0x8fU, 0x80U, 0xf6U, 0x92U, 0xe4U, 0xebU, 0x9dU, 0x6bU, 0x1dU, 0x12U, 0x64U},
+    {0x00U, 0xa2U, 0x02U, 0xa0U, 0xb8U, 0x1aU, 0xbaU, 0x18U, 0xdbU, 0x79U, 0xd9U, 0x7bU, 0x63U, 0xc1U, 0x61U, 0xc3U},
+    {0x00U, 0x01U, 0x5cU, 0x5dU, 0xe0U, 0xe1U, 0xbcU, 0xbdU, 0x50U, 0x51U, 0x0cU, 0x0dU, 0xb0U, 0xb1U, 0xecU, 0xedU}
+};
+
+MODA_CONST_PRE static const uint8_t logTable[16U] MODA_CONST_POST = {
+    0xf0U, 0x00U, 0x01U, 0x04U, 0x02U, 0x08U, 0x05U, 0x0aU, 0x03U, 0x0eU, 0x09U, 0x07U, 0x06U, 0x0dU, 0x0bU, 0x0cU
+};
+
+/* log(1/x) */
+MODA_CONST_PRE static const uint8_t negLogTable[16U] MODA_CONST_POST = {
+    0xf0U, 0x00U, 0x0eU, 0x0bU, 0x0dU, 0x07U, 0x0aU, 0x05U, 0x0cU, 0x01U, 0x06U, 0x08U, 0x09U, 0x02U, 0x04U, 0x03U
+};
+
+MODA_CONST_PRE static const uint8_t expTable[16U] MODA_CONST_POST = {
+    0x01U, 0x02U, 0x04U, 0x08U, 0x03U, 0x06U, 0x0cU, 0x0bU, 0x05U, 0x0aU, 0x07U, 0x0eU, 0x0fU, 0x0dU, 0x09U, 0x00U
+};
+
+/* 0x8*a^2 */
+MODA_CONST_PRE static const uint8_t lambdaSqTable[16U] MODA_CONST_POST = {
+    0x00U, 0x08U, 0x06U, 0x0eU, 0x0bU, 0x03U, 0x0dU, 0x05U, 0x0aU, 0x02U, 0x0cU, 0x04U, 0x01U, 0x09U, 0x07U, 0x0fU
+};
+
+MODA_CONST_PRE static const uint8_t shiftRowsTable[16U] MODA_CONST_POST = {
+    0U, 5U, 10U, 15U, 4U, 9U, 14U, 3U, 8U, 13U, 2U, 7U, 12U, 1U, 6U, 11U
+};
+
+MODA_CONST_PRE static const uint8_t invShiftRowsTable[16U] MODA_CONST_POST = {
+    0U, 13U, 10U, 7U, 4U, 1U, 14U, 11U, 8U, 5U, 2U, 15U, 12U, 9U, 6U, 3U
+};
+
+/* rotate each column by one and two rows */
+MODA_CONST_PRE static const uint8_t rot1Table[16U] MODA_CONST_POST = {
+    1U, 2U, 3U, 0U, 5U, 6U, 7U, 4U, 9U, 10U, 11U, 8U, 13U, 14U, 15U, 12U
+};
+
+MODA_CONST_PRE static const uint8_t rot2Table[16U] MODA_CONST_POST = {
+    2U, 3U, 0U, 1U, 6U, 7U, 4U, 5U, 10U, 11U, 8U, 9U, 14U, 15U, 12U, 13U
+};
+
+/* static function prototypes *****************************************/
+
+/**
+ * exp(x + y) where x and y are GF(2^4) logarithms
+ *
+ * @param[in] x
+ * @param[in] y
+ * @return product
+ *
+ * */
+TARGET static inline __m128i expSum(__m128i x, __m128i y);
+
+/**
+ * SubBytes (or InvSubBytes) of every byte in a vector
+ *
+ * @param[in] x state
+ * @param[in] m tables for the direction
+ * @return substituted state
+ *
+ * */
+TARGET static inline __m128i subBytes(__m128i x, const struct basis *m);
+
+/**
+ * Multiply every byte by x in GF(2^8)
+ *
+ * @param[in] x state
+ * @return product
+ *
+ * */
+TARGET static inline __m128i xtime(__m128i x);
+
+/**
+ * Apply SubWord to #LANES words at once
+ *
+ * @param[in/out] t #LANES words
+ *
+ * */
+TARGET static void subWords(uint32_t *t);
+
+TARGET static inline __m128i mixColumns(__m128i x);
+TARGET static inline __m128i invMixColumns(__m128i x);
+
+/**
+ * Encrypt up to #LANES blocks in lockstep
+ *
+ * @param[in] aes one expanded key per state (all with the same round count)
+ * @param[in/out] s states
+ * @param[in] n number of states
+ *
+ * */
+TARGET static void encrypt(const struct aes_ctxt *const *aes, __m128i *s, size_t n);
+
+/**
+ * Decrypt up to #LANES blocks in lockstep
+ *
+ * @param[in] aes expanded key
+ * @param[in/out] s states
+ * @param[in] n number of states
+ *
+ * */
+TARGET static void decrypt(const struct aes_ctxt *aes, __m128i *s, size_t n);
+
+/* functions **********************************************************/
+
+TARGET void MODA_AES_VPERM_Init(struct aes_ctxt *aes, enum aes_key_size keySize, const uint8_t *key)
+{
+    MODA_AES_VPERM_InitMany(aes, keySize, key, 1U);
+}
+
+TARGET void MODA_AES_VPERM_InitMany(struct aes_ctxt *aes, enum aes_key_size keySize, const uint8_t *key, size_t n)
+{
+    MODA_CONST_PRE static const uint8_t rcon[] MODA_CONST_POST = {
+        0x01U, 0x02U, 0x04U, 0x08U, 0x10U, 0x20U, 0x40U, 0x80U, 0x1bU, 0x36U
+    };
+    uint32_t w[LANES][60U];
+    uint32_t t[LANES];
+    uint8_t nk = (uint8_t)keySize >> 2U;
+    uint8_t nw = (nk + 7U) << 2U;
+    uint8_t i;
+    uint8_t j;
+    uint8_t k;
+    size_t l;
+    size_t m;
+    size_t g;
+
+    (void)memset(t, 0, sizeof(t));
+
+    for(g = 0U; g < n; g += LANES){
+
+        m = ((n - g) < LANES) ? (n - g) : LANES;
+
+        for(l = 0U; l < m; l++){
+
+            (void)memcpy(w[l], &key[(g + l) * (size_t)keySize], (size_t)keySize);
+        }
+
+        j = 0U;
+        k = 0U;
+
+        /* one lane of the vector per schedule */
+        for(i = nk; i < nw; i++){
+
+            for(l = 0U; l < m; l++){
+
+                t[l] = w[l][i - 1U];
+            }
+
+            if(j == 0U){
+
+                /* x86 is little endian so RotWord is a right rotate */
+                for(l = 0U; l < m; l++){
+
+                    t[l] = (t[l] << 24U) | (t[l] >> 8U);
+                }
+
+                subWords(t);
+
+                for(l = 0U; l < m; l++){
+
+                    t[l] ^= rcon[k];
+                }
+            }
+            else if((nk > 6U) && (j == 4U)){
+
+                subWords(t);
+            }
+            else{
+
+                /* no substitution */
+            }
+
+            for(l = 0U; l < m; l++){
+
+                w[l][i] = t[l] ^ w[l][i - nk];
+            }
+
+            j++;
+
+            if(j == nk){
+
+                j = 0U;
+                k++;
+            }
+        }
+
+        for(l = 0U; l < m; l++){
+
+            aes[g + l].r = nk + 6U;
+            (void)memcpy(aes[g + l].k, w[l], (size_t)nw << 2U);
+#if defined(MODA_AES_DECRYPT_SCHEDULE)
+            MODA_AES_TableInitDecrypt(&aes[g + l]);
+#endif
+        }
+    }
+
+    (void)memset(w, 0, sizeof(w));
+    (void)memset(t, 0, sizeof(t));
+}
+
+TARGET void MODA_AES_VPERM_Encrypt(const struct aes_ctxt *aes, uint8_t *s)
+{
+    __m128i x = LOAD(s);
+
+    encrypt(&aes, &x, 1U);
+
+    STORE(s, x);
+}
+
+TARGET void MODA_AES_VPERM_Decrypt(const struct aes_ctxt *aes, uint8_t *s)
+{
+    __m128i x = LOAD(s);
+
+    decrypt(aes, &x, 1U);
+
+    STORE(s, x);
+}
+
+TARGET void MODA_AES_VPERM_EncryptBlocks(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in, size_t n)
+{
+    const struct aes_ctxt *lane[LANES] = {aes, aes, aes, aes};
+    __m128i x[LANES];
+    size_t i;
+    size_t j;
+    size_t len;
+
+    for(i = 0U; i < n; i += LANES){
+
+        len = ((n - i) < LANES) ? (n - i) : LANES;
+
+        for(j = 0U; j < len; j++){
+
+            x[j] = LOAD(&in[(i + j) << 4U]);
+        }
+
+        encrypt(lane, x, len);
+
+        for(j = 0U; j < len; j++){
+
+            STORE(&out[(i + j) << 4U], x[j]);
+        }
+    }
+}
+
+TARGET void MODA_AES_VPERM_EncryptMany(const struct aes_ctxt *const *aes, uint8_t *out, const uint8_t *in, size_t n)
+{
+    __m128i x[LANES];
+    size_t i;
+    size_t j;
+    size_t len;
+
+    for(i = 0U; i < n; i += len){
+
+        /* neighbouring keys of the same size share a pass */
+        for(len = 1U; (len < LANES) && ((i + len) < n) && (aes[i + len]->r == aes[i]->r); len++){
+        }
+
+        for(j = 0U; j < len; j++){
+
+            x[j] = LOAD(&in[(i + j) << 4U]);
+        }
+
+        encrypt(&aes[i], x, len);
+
+        for(j = 0U; j < len; j++){
+
+            STORE(&out[(i + j) << 4U], x[j]);
+        }
+    }
+}
+
+TARGET void MODA_AES_VPERM_DecryptBlocks(const struct aes_ctxt *aes, uint8_t *out, const uint8_t *in, size_t n)
+{
+    __m128i x[LANES];
+    size_t i;
+    size_t j;
+    size_t len;
+
+    for(i = 0U; i < n; i += LANES){
+
+        len = ((n - i) < LANES) ? (n - i) : LANES;
+
+        for(j = 0U; j < len; j++){
+
+            x[j] = LOAD(&in[(i + j) << 4U]);
+        }
+
+        decrypt(aes, x, len);
+
+        for(j = 0U; j < len; j++){
+
+            STORE(&out[(i + j) << 4U], x[j]);
+        }
+    }
+}
+
+/* static functions  **************************************************/
+
+TARGET static inline __m128i expSum(__m128i x, __m128i y)
+{
+    /* saturate so a zero operand stays above 0x80, then reduce mod 15 */
+    __m128i s = _mm_adds_epu8(x, y);
+
+    s = _mm_min_epu8(s, _mm_sub_epi8(s, _mm_set1_epi8(15)));
+
+    return LOOKUP(expTable, s);
+}
+
+TARGET static inline __m128i subBytes(__m128i x, const struct basis *m)
+{
+    __m128i mask = _mm_set1_epi8(0x0f);
+    __m128i t = _mm_xor_si128(LOOKUP(m->ml, _mm_and_si128(x, mask)), LOOKUP(m->mh, _mm_and_si128(_mm_srli_epi16(x, 4), mask)));
+    __m128i a = _mm_and_si128(_mm_srli_epi16(t, 4), mask);
+    __m128i b = _mm_and_si128(t, mask);
+    __m128i c = _mm_xor_si128(a, b);
+    __m128i lc = LOOKUP(logTable, c);
+    __m128i d;
+
+    /* d = 0x8*a^2 + b*(a + b) */
+    d = _mm_xor_si128(expSum(LOOKUP(logTable, b), lc), LOOKUP(lambdaSqTable, a));
+    d = LOOKUP(negLogTable, d);
+
+    return _mm_xor_si128(LOOKUP(m->oh, expSum(LOOKUP(logTable, a), d)), LOOKUP(m->ol, expSum(lc, d)));
+}
+
+TARGET static inline __m128i xtime(__m128i x)
+{
+    __m128i carry = _mm_cmplt_epi8(x, _mm_setzero_si128());
+
+    return _mm_xor_si128(_mm_add_epi8(x, x), _mm_and_si128(carry, _mm_set1_epi8(0x1b)));
+}
+
+TARGET static void subWords(uint32_t *t)
+{
+    STORE(t, subBytes(LOAD(t), &encBasis));
+}
+
+TARGET static inline __m128i mixColumns(__m128i x)
+{
+    __m128i r1 = PERMUTE(x, rot1Table);
+    __m128i t = _mm_xor_si128(x, r1);
+
+    /* 2*(a0 + a1) + a1 + a2 + a3 */
+    return _mm_xor_si128(_mm_xor_si128(xtime(t), r1), PERMUTE(t, rot2Table));
+}
+
+TARGET static inline __m128i invMixColumns(__m128i x)
+{
+    /* InvMixColumns is MixColumns after adding 4*(a0 + a2) to a0 and a2 (and likewise for a1 and a3) */
+    return mixColumns(_mm_xor_si128(x, xtime(xtime(_mm_xor_si128(x, PERMUTE(x, rot2Table))))));
+}
+
+TARGET static void encrypt(const struct aes_ctxt *const *aes, __m128i *s, size_t n)
+{
+    uint8_t r = aes[0]->r;
+    size_t j;
+    uint8_t i;
+
+    for(j = 0U; j < n; j++){
+
+        s[j] = _mm_xor_si128(s[j], LOAD(aes[j]->k));
+    }
+
+    for(i = 1U; i < r; i++){
+
+        for(j = 0U; j < n; j++){
+
+            s[j] = _mm_xor_si128(mixColumns(subBytes(PERMUTE(s[j], shiftRowsTable), &encBasis)), LOAD(&aes[j]->k[i << 4U]));
+        }
+    }
+
+    for(j = 0U; j < n; j++){
+
+        s[j] = _mm_xor_si128(subBytes(PERMUTE(s[j], shiftRowsTable), &encBasis), LOAD(&aes[j]->k[r << 4U]));
+    }
+}
+
+TARGET static void decrypt(const struct aes_ctxt *aes, __m128i *s, size_t n)
+{
+    __m128i k;
+    size_t j;
+    uint8_t i;
+
+    k = LOAD(&aes->k[aes->r << 4U]);
+
+    for(j = 0U; j < n; j++){
+
+        s[j] = _mm_xor_si128(s[j], k);
+    }
+
+    for(i = aes->r - 1U; i > 0U; i--){
+
+        k = LOAD(&aes->k[i << 4U]);
+
+        for(j = 0U; j < n; j++){
+
+            s[j] = invMixColumns(_mm_xor_si128(subBytes(PERMUTE(s[j], invShiftRowsTable), &decBasis), k));
+        }
+    }
+
+    k = LOAD(aes->k);
+
+    for(j = 0U; j < n; j++){
+
+        s[j] = _mm_xor_si128(subBytes(PERMUTE(s[j], invShiftRowsTable), &decBasis), k);
+    }
+}
+
+#endif
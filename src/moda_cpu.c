@@ -0,0 +1,78 @@
+/* Copyright (c) 2013-2016 Cameron Harper
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * */
+
+/* includes ***********************************************************/
+
+#include "moda_internal.h"
+
+#if defined(MODA_CPU_PROBE)
+
+#include <cpuid.h>
+
+/* defines ************************************************************/
+
+/* set once the host has been probed so that zero means unknown */
+#define PROBED 0x80000000U
+
+/* static variables ***************************************************/
+
+/* concurrent first calls race to store the same value */
+static volatile uint32_t features = 0U;
+
+/* functions **********************************************************/
+
+uint32_t MODA_CPU_Features(void)
+{
+    unsigned int eax;
+    unsigned int ebx;
+    unsigned int ecx;
+    unsigned int edx;
+    uint32_t f = features;
+
+    if(f == 0U){
+
+        f = PROBED;
+
+        if(__get_cpuid(1U, &eax, &ebx, &ecx, &edx) != 0){
+
+            if((ecx & bit_AES) != 0U){
+
+                f |= MODA_CPU_AES;
+            }
+
+            if((ecx & bit_SSSE3) != 0U){
+
+                f |= MODA_CPU_SSSE3;
+            }
+
+            if(((ecx & bit_PCLMUL) != 0U) && ((ecx & bit_SSSE3) != 0U)){
+
+                f |= MODA_CPU_PCLMUL;
+            }
+        }
+
+        features = f;
+    }
+
+    return f;
+}
+
+#endif
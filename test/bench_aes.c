@@ -0,0 +1,329 @@
+/* Copyright (c) 2013-2016 Cameron Harper
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * */
+
+/**
+ * @example bench_aes.c
+ *
+ * Block cipher throughput in cycles per byte
+ *
+ * Run `make bench` to compare the engines selectable at build time.
+ *
+ * */
+
+#include "aes.h"
+#include "aes_cmac.h"
+#include "moda_internal.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define CYCLES() ((double)__rdtsc())
+    #define UNIT "cycles/byte"
+    #define UNIT_KEY "cycles"
+#else
+    #define CYCLES() ((double)clock() * (1e9 / (double)CLOCKS_PER_SEC))
+    #define UNIT "ns/byte"
+    #define UNIT_KEY "ns"
+#endif
+
+#define STR(X) #X
+#define XSTR(X) STR(X)
+
+#if defined(MODA_AES_TABLES) && defined(MODA_AES_DECRYPT_SCHEDULE)
+    #define ENGINE "tables (MODA_AES_TABLES=" XSTR(MODA_AES_TABLES) ", MODA_AES_DECRYPT_SCHEDULE)"
+#elif defined(MODA_AES_TABLES)
+    #define ENGINE "tables (MODA_AES_TABLES=" XSTR(MODA_AES_TABLES) ")"
+#elif defined(MODA_AES_BITSLICE)
+    #define ENGINE "bitsliced (MODA_AES_BITSLICE)"
+#elif defined(MODA_AES_OTF)
+    #define ENGINE "byte, round keys on the fly (MODA_AES_OTF)"
+#else
+    #define ENGINE "byte"
+#endif
+
+#if defined(MODA_AES_SBOX_COMPUTED)
+    #define SBOX_SOURCE " computed S-box (MODA_AES_SBOX_COMPUTED)"
+#else
+    #define SBOX_SOURCE ""
+#endif
+
+#if defined(MODA_AES_UNROLL)
+    #define UNROLL " unrolled (MODA_AES_UNROLL)"
+#else
+    #define UNROLL ""
+#endif
+
+#define BLOCKS 100000U
+#define RUNS 5U
+
+static double bench(const struct aes_ctxt *aes, void (*fn)(const struct aes_ctxt *, uint8_t *))
+{
+    uint8_t s[AES_BLOCK_SIZE];
+    double best = 0.0;
+    double start;
+    double cpb;
+    uint32_t i;
+    uint32_t run;
+
+    memset(s, 0x5a, sizeof(s));
+
+    for(run=0U; run < RUNS; run++){
+
+        start = CYCLES();
+
+        for(i=0U; i < BLOCKS; i++){
+
+            fn(aes, s);
+        }
+
+        cpb = (CYCLES() - start) / ((double)BLOCKS * AES_BLOCK_SIZE);
+
+        if((run == 0U) || (cpb < best)){
+
+            best = cpb;
+        }
+    }
+
+    return best;
+}
+
+#define ECB_BLOCKS 64U
+
+static double benchBlocks(const struct aes_ctxt *aes, void (*fn)(const struct aes_ctxt *, uint8_t *, const uint8_t *, size_t))
+{
+    static uint8_t s[ECB_BLOCKS * AES_BLOCK_SIZE];
+    double best = 0.0;
+    double start;
+    double cpb;
+    uint32_t i;
+    uint32_t run;
+
+    memset(s, 0x5a, sizeof(s));
+
+    for(run=0U; run < RUNS; run++){
+
+        start = CYCLES();
+
+        for(i=0U; i < (BLOCKS / ECB_BLOCKS); i++){
+
+            fn(aes, s, s, ECB_BLOCKS);
+        }
+
+        cpb = (CYCLES() - start) / ((double)(BLOCKS / ECB_BLOCKS) * sizeof(s));
+
+        if((run == 0U) || (cpb < best)){
+
+            best = cpb;
+        }
+    }
+
+    return best;
+}
+
+#define KEYS 64U
+
+static double benchMany(enum aes_key_size keySize)
+{
+    static struct aes_ctxt aes[KEYS];
+    static const struct aes_ctxt *lane[KEYS];
+    static uint8_t s[KEYS * AES_BLOCK_SIZE];
+    uint8_t key[AES_KEY_256];
+    double best = 0.0;
+    double start;
+    double cpb;
+    uint32_t i;
+    uint32_t run;
+
+    memset(s, 0x5a, sizeof(s));
+
+    /* every block under its own key */
+    for(i=0U; i < KEYS; i++){
+
+        memset(key, (int)i, sizeof(key));
+        MODA_AES_Init(&aes[i], keySize, key);
+        lane[i] = &aes[i];
+    }
+
+    for(run=0U; run < RUNS; run++){
+
+        start = CYCLES();
+
+        for(i=0U; i < (BLOCKS / KEYS); i++){
+
+            MODA_AES_EncryptMany(lane, s, s, KEYS);
+        }
+
+        cpb = (CYCLES() - start) / ((double)(BLOCKS / KEYS) * sizeof(s));
+
+        if((run == 0U) || (cpb < best)){
+
+            best = cpb;
+        }
+    }
+
+    return best;
+}
+
+static double benchInit(enum aes_key_size keySize, bool many)
+{
+    static struct aes_ctxt aes[KEYS];
+    static uint8_t key[KEYS * AES_KEY_256];
+    double best = 0.0;
+    double start;
+    double cpk;
+    uint32_t i;
+    uint32_t run;
+    uint32_t n;
+
+    memset(key, 0x5a, sizeof(key));
+
+    for(run=0U; run < RUNS; run++){
+
+        start = CYCLES();
+
+        for(i=0U; i < (BLOCKS / KEYS / 10U); i++){
+
+            if(many){
+
+                MODA_AES_InitMany(aes, keySize, key, KEYS);
+            }
+            else{
+
+                for(n=0U; n < KEYS; n++){
+
+                    MODA_AES_Init(&aes[n], keySize, &key[n * (uint32_t)keySize]);
+                }
+            }
+        }
+
+        cpk = (CYCLES() - start) / ((double)(BLOCKS / KEYS / 10U) * KEYS);
+
+        if((run == 0U) || (cpk < best)){
+
+            best = cpk;
+        }
+    }
+
+    return best;
+}
+
+#define CMAC_MSGS 8U
+#define CMAC_SIZE 1024U
+
+static double benchCmac(const struct aes_ctxt *aes, bool many)
+{
+    static uint8_t s[CMAC_MSGS * CMAC_SIZE];
+    static uint8_t t[CMAC_MSGS * AES_BLOCK_SIZE];
+    struct aes_cmac_msg msg[CMAC_MSGS];
+    double best = 0.0;
+    double start;
+    double cpb;
+    uint32_t i;
+    uint32_t n;
+    uint32_t run;
+
+    memset(s, 0x5a, sizeof(s));
+
+    for(n=0U; n < CMAC_MSGS; n++){
+
+        msg[n].aes = aes;
+        msg[n].in = &s[n * CMAC_SIZE];
+        msg[n].inLen = CMAC_SIZE;
+        msg[n].t = &t[n * AES_BLOCK_SIZE];
+        msg[n].tSize = AES_BLOCK_SIZE;
+    }
+
+    for(run=0U; run < RUNS; run++){
+
+        start = CYCLES();
+
+        for(i=0U; i < (BLOCKS / (sizeof(s) / AES_BLOCK_SIZE)); i++){
+
+            if(many){
+
+                MODA_AES_CMAC_Many(msg, CMAC_MSGS);
+            }
+            else{
+
+                for(n=0U; n < CMAC_MSGS; n++){
+
+                    MODA_AES_CMAC(aes, msg[n].in, msg[n].inLen, msg[n].t, msg[n].tSize);
+                }
+            }
+        }
+
+        cpb = (CYCLES() - start) / ((double)(BLOCKS / (sizeof(s) / AES_BLOCK_SIZE)) * sizeof(s));
+
+        if((run == 0U) || (cpb < best)){
+
+            best = cpb;
+        }
+    }
+
+    return best;
+}
+
+int main(void)
+{
+    static const uint8_t key[] = {0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0a,0x0b,0x0c,0x0d,0x0e,0x0f,0x10,0x11,0x12,0x13,0x14,0x15,0x16,0x17,0x18,0x19,0x1a,0x1b,0x1c,0x1d,0x1e,0x1f};
+    static const enum aes_key_size sizes[] = {AES_KEY_128, AES_KEY_192, AES_KEY_256};
+    struct aes_ctxt aes;
+    size_t i;
+
+#if defined(MODA_AES_NI)
+    if(MODA_CPU_HAS(MODA_CPU_AES)){
+
+        printf("engine: AES-NI\n");
+    }
+    else
+#endif
+#if defined(MODA_AES_VPERM)
+    if(MODA_CPU_HAS(MODA_CPU_SSSE3)){
+
+        printf("engine: SSSE3 vector permute\n");
+    }
+    else
+#endif
+    {
+        printf("engine: %s%s%s\n", ENGINE, UNROLL, SBOX_SOURCE);
+    }
+
+    /* memory cost of each key held in RAM */
+    printf("  context: %u bytes/key\n", (unsigned)sizeof(struct aes_ctxt));
+
+    for(i=0U; i < (sizeof(sizes)/sizeof(*sizes)); i++){
+
+        MODA_AES_Init(&aes, sizes[i], key);
+
+        printf("  AES-%u encrypt: %6.1f %s\n", (unsigned)sizes[i] * 8U, bench(&aes, MODA_AES_Encrypt), UNIT);
+        printf("  AES-%u decrypt: %6.1f %s\n", (unsigned)sizes[i] * 8U, bench(&aes, MODA_AES_Decrypt), UNIT);
+        printf("  AES-%u ECB encrypt: %6.1f %s, decrypt: %6.1f %s\n", (unsigned)sizes[i] * 8U, benchBlocks(&aes, MODA_AES_EncryptBlocks), UNIT, benchBlocks(&aes, MODA_AES_DecryptBlocks), UNIT);
+        printf("  AES-%u key agile encrypt: %6.1f %s\n", (unsigned)sizes[i] * 8U, benchMany(sizes[i]), UNIT);
+        printf("  AES-%u CMAC: %6.1f %s, %u messages together: %6.1f %s\n", (unsigned)sizes[i] * 8U, benchCmac(&aes, false), UNIT, CMAC_MSGS, benchCmac(&aes, true), UNIT);
+        printf("  AES-%u key setup: %6.0f %s/key, batched: %6.0f %s/key\n", (unsigned)sizes[i] * 8U, benchInit(sizes[i], false), UNIT_KEY, benchInit(sizes[i], true), UNIT_KEY);
+    }
+
+    return 0;
+}
@@ -0,0 +1,190 @@
+/* Copyright (c) 2013-2016 Cameron Harper
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * */
+
+/**
+ * @example bench_aes_gcm.c
+ *
+ * AES-GCM throughput in cycles per byte
+ *
+ * Run `make bench` to compare the engines selectable at build time.
+ *
+ * */
+
+#include "aes.h"
+#include "aes_gcm.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define CYCLES() ((double)__rdtsc())
+    #define UNIT "cycles/byte"
+#else
+    #define CYCLES() ((double)clock() * (1e9 / (double)CLOCKS_PER_SEC))
+    #define UNIT "ns/byte"
+#endif
+
+/* bytes processed per run */
+#define TOTAL 1600000U
+#define RUNS 5U
+
+/* bytes of additional data per message */
+#define AAD_SIZE 16U
+
+/* packets per burst */
+#define BURST 32U
+
+static double bench(const struct aes_ctxt *aes, const struct aes_gcm_ctxt *gcm, uint32_t size)
+{
+    static uint8_t text[16384U];
+    static const uint8_t iv[12U] = {0};
+    static const uint8_t aad[AAD_SIZE] = {0};
+    uint8_t t[16U];
+    double best = 0.0;
+    double start;
+    double cpb;
+    uint32_t i;
+    uint32_t n = TOTAL / size;
+    uint32_t run;
+
+    memset(text, 0x5a, sizeof(text));
+
+    for(run=0U; run < RUNS; run++){
+
+        start = CYCLES();
+
+        for(i=0U; i < n; i++){
+
+            if(gcm != NULL){
+
+                MODA_AES_GCM_Seal(gcm, iv, sizeof(iv), text, text, size, aad, sizeof(aad), t, sizeof(t));
+            }
+            else{
+
+                MODA_AES_GCM_Encrypt(aes, iv, sizeof(iv), text, text, size, aad, sizeof(aad), t, sizeof(t));
+            }
+        }
+
+        cpb = (CYCLES() - start) / ((double)n * size);
+
+        if((run == 0U) || (cpb < best)){
+
+            best = cpb;
+        }
+    }
+
+    return best;
+}
+
+static double benchBurst(const struct aes_gcm_ctxt *gcm, uint32_t size)
+{
+    static uint8_t text[BURST][1500U];
+    static uint8_t t[BURST][16U];
+    static const uint8_t iv[12U] = {0};
+    static const uint8_t aad[AAD_SIZE] = {0};
+    struct aes_gcm_packet pkt[BURST];
+    double best = 0.0;
+    double start;
+    double cpb;
+    uint32_t i;
+    uint32_t n = TOTAL / (size * BURST);
+    uint32_t run;
+
+    memset(text, 0x5a, sizeof(text));
+
+    for(i=0U; i < BURST; i++){
+
+        pkt[i].iv = iv;
+        pkt[i].ivSize = sizeof(iv);
+        pkt[i].aad = aad;
+        pkt[i].aadSize = sizeof(aad);
+        pkt[i].in = text[i];
+        pkt[i].out = text[i];
+        pkt[i].textSize = size;
+        pkt[i].t = t[i];
+        pkt[i].tSize = sizeof(t[i]);
+    }
+
+    for(run=0U; run < RUNS; run++){
+
+        start = CYCLES();
+
+        for(i=0U; i < n; i++){
+
+            MODA_AES_GCM_SealBurst(gcm, pkt, BURST);
+        }
+
+        cpb = (CYCLES() - start) / ((double)n * size * BURST);
+
+        if((run == 0U) || (cpb < best)){
+
+            best = cpb;
+        }
+    }
+
+    return best;
+}
+
+int main(void)
+{
+    static const uint8_t key[] = {0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0a,0x0b,0x0c,0x0d,0x0e,0x0f};
+    static const uint32_t sizes[] = {64U, 256U, 1500U, 16384U};
+    static const size_t tableSizes[] = {AES_GCM_TABLE_4BIT, AES_GCM_TABLE_8BIT, AES_GCM_TABLE_64K};
+    static uint64_t table[AES_GCM_TABLE_64K / sizeof(uint64_t)];
+    struct aes_gcm_ctxt gcm;
+    struct aes_gcm_ctxt tableGcm;
+    size_t i;
+    size_t j;
+
+    MODA_AES_GCM_Init(&gcm, AES_KEY_128, key);
+
+    printf("GCM (AES-128, %u byte aad)\n", AAD_SIZE);
+
+    for(i=0U; i < (sizeof(sizes)/sizeof(*sizes)); i++){
+
+        printf("  %5u byte message: one step %7.1f %s, with GCM key %7.1f %s\n", (unsigned)sizes[i], bench(&gcm.aes, NULL, sizes[i]), UNIT, bench(NULL, &gcm, sizes[i]), UNIT);
+    }
+
+    printf("GCM burst (%u packets)\n", BURST);
+
+    for(i=0U; i < 3U; i++){
+
+        printf("  %5u byte message: %7.1f %s\n", (unsigned)sizes[i], benchBurst(&gcm, sizes[i]), UNIT);
+    }
+
+    for(j=0U; j < (sizeof(tableSizes)/sizeof(*tableSizes)); j++){
+
+        tableGcm = gcm;
+        MODA_AES_GCM_InitTable(&tableGcm, table, tableSizes[j]);
+
+        printf("GHASH table (%u bytes)\n", (unsigned)tableSizes[j]);
+
+        for(i=0U; i < (sizeof(sizes)/sizeof(*sizes)); i++){
+
+            printf("  %5u byte message: %7.1f %s\n", (unsigned)sizes[i], bench(NULL, &tableGcm, sizes[i]), UNIT);
+        }
+    }
+
+    return 0;
+}
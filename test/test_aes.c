@@ -145,6 +145,261 @@ static void test_MODA_AES_Decrypt_256(void **user)
     assert_memory_equal(pt, out, sizeof(pt));
 }
 
+static void test_MODA_AES_AppendixC(void **user)
+{
+    static const uint8_t key[] = {0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0a,0x0b,0x0c,0x0d,0x0e,0x0f,0x10,0x11,0x12,0x13,0x14,0x15,0x16,0x17,0x18,0x19,0x1a,0x1b,0x1c,0x1d,0x1e,0x1f};
+    static const uint8_t pt[] = {0x00,0x11,0x22,0x33,0x44,0x55,0x66,0x77,0x88,0x99,0xaa,0xbb,0xcc,0xdd,0xee,0xff};
+    static const uint8_t ct[][AES_BLOCK_SIZE] = {
+        {0x69,0xc4,0xe0,0xd8,0x6a,0x7b,0x04,0x30,0xd8,0xcd,0xb7,0x80,0x70,0xb4,0xc5,0x5a},
+        {0xdd,0xa9,0x7c,0xa4,0x86,0x4c,0xdf,0xe0,0x6e,0xaf,0x70,0xa0,0xec,0x0d,0x71,0x91},
+        {0x8e,0xa2,0xb7,0xca,0x51,0x67,0x45,0xbf,0xea,0xfc,0x49,0x90,0x4b,0x49,0x60,0x89}
+    };
+    static const enum aes_key_size keySize[] = {AES_KEY_128, AES_KEY_192, AES_KEY_256};
+
+    struct aes_ctxt aes;
+    uint8_t out[AES_BLOCK_SIZE];
+    size_t i;
+
+    for(i=0U; i < (sizeof(keySize)/sizeof(*keySize)); i++){
+
+        MODA_AES_Init(&aes, keySize[i], key);
+
+        memcpy(out, pt, sizeof(out));
+        MODA_AES_Encrypt(&aes, out);
+        assert_memory_equal(ct[i], out, sizeof(out));
+
+        MODA_AES_Decrypt(&aes, out);
+        assert_memory_equal(pt, out, sizeof(out));
+    }
+}
+
+static void test_MODA_AES_Blocks(void **user)
+{
+    static const uint8_t key[] = {0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0a,0x0b,0x0c,0x0d,0x0e,0x0f,0x10,0x11,0x12,0x13,0x14,0x15,0x16,0x17,0x18,0x19,0x1a,0x1b,0x1c,0x1d,0x1e,0x1f};
+    static const enum aes_key_size keySize[] = {AES_KEY_128, AES_KEY_192, AES_KEY_256};
+
+    /* enough blocks to leave a remainder after every engine's interleave */
+    uint8_t pt[11U * AES_BLOCK_SIZE];
+    uint8_t ct[sizeof(pt)];
+    uint8_t out[sizeof(pt)];
+    struct aes_ctxt aes;
+    size_t i;
+    size_t n;
+
+    for(i=0U; i < sizeof(pt); i++){
+
+        pt[i] = (uint8_t)(i * 7U);
+    }
+
+    for(i=0U; i < (sizeof(keySize)/sizeof(*keySize)); i++){
+
+        MODA_AES_Init(&aes, keySize[i], key);
+
+        memcpy(ct, pt, sizeof(ct));
+
+        for(n=0U; n < (sizeof(pt) / AES_BLOCK_SIZE); n++){
+
+            MODA_AES_Encrypt(&aes, &ct[n * AES_BLOCK_SIZE]);
+        }
+
+        /* out of place */
+        memset(out, 0, sizeof(out));
+        MODA_AES_EncryptBlocks(&aes, out, pt, sizeof(pt) / AES_BLOCK_SIZE);
+        assert_memory_equal(ct, out, sizeof(out));
+
+        memset(out, 0, sizeof(out));
+        MODA_AES_DecryptBlocks(&aes, out, ct, sizeof(ct) / AES_BLOCK_SIZE);
+        assert_memory_equal(pt, out, sizeof(out));
+
+        /* in place, every length */
+        for(n=0U; n <= (sizeof(pt) / AES_BLOCK_SIZE); n++){
+
+            memcpy(out, pt, sizeof(out));
+            MODA_AES_EncryptBlocks(&aes, out, out, n);
+            assert_memory_equal(ct, out, n * AES_BLOCK_SIZE);
+            assert_memory_equal(&pt[n * AES_BLOCK_SIZE], &out[n * AES_BLOCK_SIZE], sizeof(out) - (n * AES_BLOCK_SIZE));
+
+            MODA_AES_DecryptBlocks(&aes, out, out, n);
+            assert_memory_equal(pt, out, sizeof(out));
+        }
+    }
+}
+
+static void test_MODA_AES_InitMany(void **user)
+{
+    static const enum aes_key_size keySize[] = {AES_KEY_128, AES_KEY_192, AES_KEY_256};
+
+    /* enough keys to leave a remainder after every engine's interleave */
+    struct aes_ctxt aes[37U];
+    struct aes_ctxt ref;
+    uint8_t key[sizeof(aes)/sizeof(*aes) * AES_KEY_256];
+    size_t i;
+    size_t n;
+
+    for(i=0U; i < sizeof(key); i++){
+
+        key[i] = (uint8_t)((i * 13U) ^ (i >> 3U));
+    }
+
+    for(i=0U; i < (sizeof(keySize)/sizeof(*keySize)); i++){
+
+        /* parts of the context an engine does not use stay zero */
+        memset(aes, 0, sizeof(aes));
+        MODA_AES_InitMany(aes, keySize[i], key, sizeof(aes)/sizeof(*aes));
+
+        for(n=0U; n < (sizeof(aes)/sizeof(*aes)); n++){
+
+            memset(&ref, 0, sizeof(ref));
+            MODA_AES_Init(&ref, keySize[i], &key[n * keySize[i]]);
+
+            assert_int_equal(ref.r, aes[n].r);
+#if defined(MODA_AES_OTF)
+            assert_memory_equal(ref.k, aes[n].k, keySize[i]);
+#else
+            assert_memory_equal(ref.k, aes[n].k, (ref.r + 1U) * AES_BLOCK_SIZE);
+#endif
+#if defined(MODA_AES_DECRYPT_SCHEDULE)
+            assert_memory_equal(ref.dk, aes[n].dk, (ref.r + 1U) * AES_BLOCK_SIZE);
+#endif
+#if defined(MODA_AES_BITSLICE)
+            assert_memory_equal(ref.sk, aes[n].sk, (ref.r + 1U) * 2U * sizeof(*ref.sk));
+#endif
+        }
+    }
+
+    MODA_AES_InitMany(NULL, AES_KEY_128, NULL, 0U);
+}
+
+static void test_MODA_AES_EncryptMany(void **user)
+{
+    static const enum aes_key_size keySize[] = {AES_KEY_128, AES_KEY_192, AES_KEY_256};
+
+    /* runs of one key size longer and shorter than every engine's interleave */
+    struct aes_ctxt aes[37U];
+    const struct aes_ctxt *lane[sizeof(aes)/sizeof(*aes) + 3U];
+    uint8_t key[AES_KEY_256];
+    uint8_t pt[sizeof(lane)/sizeof(*lane) * AES_BLOCK_SIZE];
+    uint8_t ct[sizeof(pt)];
+    uint8_t out[sizeof(pt)];
+    size_t i;
+    size_t n;
+
+    for(i=0U; i < (sizeof(aes)/sizeof(*aes)); i++){
+
+        for(n=0U; n < sizeof(key); n++){
+
+            key[n] = (uint8_t)((i * 31U) + n);
+        }
+
+        MODA_AES_Init(&aes[i], keySize[(i < 20U) ? (i / 10U) : (i % 3U)], key);
+        lane[i] = &aes[i];
+    }
+
+    /* the same key may appear more than once */
+    lane[i] = &aes[0];
+    lane[i + 1U] = &aes[0];
+    lane[i + 2U] = &aes[0];
+
+    for(i=0U; i < sizeof(pt); i++){
+
+        pt[i] = (uint8_t)(i * 7U);
+    }
+
+    memcpy(ct, pt, sizeof(ct));
+
+    for(i=0U; i < (sizeof(lane)/sizeof(*lane)); i++){
+
+        MODA_AES_Encrypt(lane[i], &ct[i * AES_BLOCK_SIZE]);
+    }
+
+    /* out of place */
+    memset(out, 0, sizeof(out));
+    MODA_AES_EncryptMany(lane, out, pt, sizeof(lane)/sizeof(*lane));
+    assert_memory_equal(ct, out, sizeof(out));
+
+    /* in place, every length */
+    for(n=0U; n <= (sizeof(lane)/sizeof(*lane)); n++){
+
+        memcpy(out, pt, sizeof(out));
+        MODA_AES_EncryptMany(lane, out, out, n);
+        assert_memory_equal(ct, out, n * AES_BLOCK_SIZE);
+        assert_memory_equal(&pt[n * AES_BLOCK_SIZE], &out[n * AES_BLOCK_SIZE], sizeof(out) - (n * AES_BLOCK_SIZE));
+    }
+}
+
+#if defined(MODA_AES_OTF)
+static void test_MODA_AES_ContextSize(void **user)
+{
+    /* the key and round count, nothing else */
+    assert_true(sizeof(struct aes_ctxt) <= (AES_KEY_256 + 1U));
+}
+#else
+static void test_MODA_AES_Alignment(void **user)
+{
+    struct aes_ctxt aes[2];
+
+    assert_int_equal(0, (uintptr_t)aes[0].k % MODA_AES_ALIGN);
+    assert_int_equal(0, (uintptr_t)aes[1].k % MODA_AES_ALIGN);
+#if defined(MODA_AES_DECRYPT_SCHEDULE)
+    assert_int_equal(0, (uintptr_t)aes[0].dk % MODA_AES_ALIGN);
+    assert_int_equal(0, (uintptr_t)aes[1].dk % MODA_AES_ALIGN);
+#endif
+}
+#endif
+
+#if defined(MODA_AES_UNROLL)
+static void test_MODA_AES_Unrolled(void **user)
+{
+    static const uint8_t key[] = {0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0a,0x0b,0x0c,0x0d,0x0e,0x0f,0x10,0x11,0x12,0x13,0x14,0x15,0x16,0x17,0x18,0x19,0x1a,0x1b,0x1c,0x1d,0x1e,0x1f};
+    static const uint8_t pt[] = {0x00,0x11,0x22,0x33,0x44,0x55,0x66,0x77,0x88,0x99,0xaa,0xbb,0xcc,0xdd,0xee,0xff};
+    static const uint8_t ct[][AES_BLOCK_SIZE] = {
+        {0x69,0xc4,0xe0,0xd8,0x6a,0x7b,0x04,0x30,0xd8,0xcd,0xb7,0x80,0x70,0xb4,0xc5,0x5a},
+        {0xdd,0xa9,0x7c,0xa4,0x86,0x4c,0xdf,0xe0,0x6e,0xaf,0x70,0xa0,0xec,0x0d,0x71,0x91},
+        {0x8e,0xa2,0xb7,0xca,0x51,0x67,0x45,0xbf,0xea,0xfc,0x49,0x90,0x4b,0x49,0x60,0x89}
+    };
+    static void (*const init[])(struct aes_ctxt *, const uint8_t *) = {MODA_AES128_Init, MODA_AES192_Init, MODA_AES256_Init};
+    static void (*const encrypt[])(const struct aes_ctxt *, uint8_t *) = {MODA_AES128_Encrypt, MODA_AES192_Encrypt, MODA_AES256_Encrypt};
+    static void (*const decrypt[])(const struct aes_ctxt *, uint8_t *) = {MODA_AES128_Decrypt, MODA_AES192_Decrypt, MODA_AES256_Decrypt};
+    static const enum aes_key_size keySize[] = {AES_KEY_128, AES_KEY_192, AES_KEY_256};
+
+    struct aes_ctxt aes;
+    struct aes_ctxt ref;
+    uint8_t out[AES_BLOCK_SIZE];
+    size_t i;
+
+    for(i=0U; i < (sizeof(keySize)/sizeof(*keySize)); i++){
+
+        init[i](&aes, key);
+
+        memcpy(out, pt, sizeof(out));
+        encrypt[i](&aes, out);
+        assert_memory_equal(ct[i], out, sizeof(out));
+
+        decrypt[i](&aes, out);
+        assert_memory_equal(pt, out, sizeof(out));
+
+        /* same schedule as the generic interface */
+        MODA_AES_Init(&ref, keySize[i], key);
+        assert_int_equal(ref.r, aes.r);
+        assert_memory_equal(ref.k, aes.k, (ref.r + 1U) * AES_BLOCK_SIZE);
+#if defined(MODA_AES_DECRYPT_SCHEDULE)
+        assert_memory_equal(ref.dk, aes.dk, (ref.r + 1U) * AES_BLOCK_SIZE);
+#endif
+#if defined(MODA_AES_SBOX_COMPUTED)
+        assert_memory_equal(ref.sk, aes.sk, (ref.r + 1U) * 8U * sizeof(*ref.sk));
+#endif
+
+        /* whichever backend MODA_AES_Init() picked, the direct calls accept its key */
+        memcpy(out, pt, sizeof(out));
+        encrypt[i](&ref, out);
+        assert_memory_equal(ct[i], out, sizeof(out));
+
+        decrypt[i](&ref, out);
+        assert_memory_equal(pt, out, sizeof(out));
+    }
+}
+#endif
+
 int main(void)
 {
     const struct CMUnitTest tests[] = {
@@ -154,7 +409,19 @@ int main(void)
         cmocka_unit_test(test_MODA_AES_Encrypt_256),        
         cmocka_unit_test(test_MODA_AES_Decrypt_128),        
         cmocka_unit_test(test_MODA_AES_Decrypt_192),        
-        cmocka_unit_test(test_MODA_AES_Decrypt_256)     
+        cmocka_unit_test(test_MODA_AES_Decrypt_256),
+        cmocka_unit_test(test_MODA_AES_AppendixC),
+        cmocka_unit_test(test_MODA_AES_Blocks),
+        cmocka_unit_test(test_MODA_AES_InitMany),
+        cmocka_unit_test(test_MODA_AES_EncryptMany),
+#if defined(MODA_AES_OTF)
+        cmocka_unit_test(test_MODA_AES_ContextSize),
+#else
+        cmocka_unit_test(test_MODA_AES_Alignment),
+#endif
+#if defined(MODA_AES_UNROLL)
+        cmocka_unit_test(test_MODA_AES_Unrolled),
+#endif
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -0,0 +1,274 @@
+/* Copyright (c) 2014 Cameron Harper
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * */
+
+/**
+ * @example test_aes_cache.c
+ *
+ * Expanded key cache
+ *
+ * */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+
+#include "cmocka.h"
+
+#include "aes.h"
+#include "aes_cache.h"
+#include "aes_gcm.h"
+
+/* room for a few keys per shard */
+static MODA_ALIGN(MODA_AES_ALIGN) uint8_t mem[(sizeof(struct aes_cache_entry) + sizeof(uint32_t)) * MODA_AES_CACHE_SHARDS * 2U];
+
+static struct aes_cache cache;
+
+static void makeKey(uint8_t *key, uint32_t n)
+{
+    uint8_t i;
+
+    for(i = 0U; i < 32U; i++){
+
+        key[i] = (uint8_t)((i * 7U) ^ (n >> ((i % 4U) * 8U)));
+    }
+}
+
+static bool inMem(const uint8_t *pattern, size_t size)
+{
+    size_t i;
+
+    for(i = 0U; (i + size) <= sizeof(mem); i++){
+
+        if(memcmp(&mem[i], pattern, size) == 0){
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void test_MODA_AES_CacheInit(void **user)
+{
+    assert_int_equal(MODA_AES_CACHE_SHARDS * 2U, MODA_AES_CacheInit(&cache, mem, sizeof(mem)));
+    assert_int_equal(0U, MODA_AES_CacheInit(&cache, mem, sizeof(struct aes_cache_entry)));
+}
+
+static void test_MODA_AES_CacheGet(void **user)
+{
+    static const enum aes_key_size sizes[] = {AES_KEY_128, AES_KEY_192, AES_KEY_256};
+    static const uint8_t id[] = "key-one";
+    struct aes_ctxt expected;
+    struct aes_ctxt aes;
+    uint8_t key[32U];
+    size_t i;
+
+    (void)MODA_AES_CacheInit(&cache, mem, sizeof(mem));
+
+    for(i = 0U; i < (sizeof(sizes) / sizeof(*sizes)); i++){
+
+        makeKey(key, (uint32_t)i);
+
+        (void)memset(&expected, 0, sizeof(expected));
+        MODA_AES_Init(&expected, sizes[i], key);
+
+        /* key as its own identifier */
+        (void)memset(&aes, 0, sizeof(aes));
+        assert_false(MODA_AES_CacheGet(&cache, NULL, 0U, sizes[i], key, &aes));
+        assert_memory_equal(&expected, &aes, sizeof(aes));
+
+        (void)memset(&aes, 0, sizeof(aes));
+        assert_true(MODA_AES_CacheGet(&cache, NULL, 0U, sizes[i], key, &aes));
+        assert_memory_equal(&expected, &aes, sizeof(aes));
+    }
+
+    /* caller identifier */
+    makeKey(key, 100U);
+    (void)memset(&expected, 0, sizeof(expected));
+    MODA_AES_Init(&expected, AES_KEY_128, key);
+
+    (void)memset(&aes, 0, sizeof(aes));
+    assert_false(MODA_AES_CacheGet(&cache, id, sizeof(id), AES_KEY_128, key, &aes));
+    assert_true(MODA_AES_CacheGet(&cache, id, sizeof(id), AES_KEY_128, key, &aes));
+    assert_memory_equal(&expected, &aes, sizeof(aes));
+
+    /* identifier names the key, not the other way round */
+    assert_false(MODA_AES_CacheGet(&cache, NULL, 0U, AES_KEY_128, key, &aes));
+}
+
+static void test_MODA_AES_CacheGetGCM(void **user)
+{
+    static const uint8_t id[] = "gcm-key";
+    static const uint8_t iv[] = {0xca,0xfe,0xba,0xbe,0xfa,0xce,0xdb,0xad,0xde,0xca,0xf8,0x88};
+    static const uint8_t aad[] = "header";
+    struct aes_gcm_ctxt expected;
+    struct aes_gcm_ctxt gcm;
+    struct aes_ctxt aes;
+    uint8_t key[32U];
+    uint8_t pt[100U];
+    uint8_t expectedText[sizeof(pt)];
+    uint8_t expectedTag[AES_BLOCK_SIZE];
+    uint8_t outText[sizeof(pt)];
+    uint8_t outTag[AES_BLOCK_SIZE];
+
+    (void)MODA_AES_CacheInit(&cache, mem, sizeof(mem));
+
+    makeKey(key, 7U);
+    (void)memset(pt, 0x42, sizeof(pt));
+
+    (void)memset(&expected, 0, sizeof(expected));
+    MODA_AES_GCM_Init(&expected, AES_KEY_256, key);
+    MODA_AES_GCM_Seal(&expected, iv, sizeof(iv), expectedText, pt, sizeof(pt), aad, sizeof(aad), expectedTag, sizeof(expectedTag));
+
+    assert_false(MODA_AES_CacheGetGCM(&cache, id, sizeof(id), AES_KEY_256, key, &gcm));
+
+    /* a hit neither expands nor encrypts H: the key is not even read */
+    (void)memset(key, 0, sizeof(key));
+    (void)memset(&gcm, 0, sizeof(gcm));
+    assert_true(MODA_AES_CacheGetGCM(&cache, id, sizeof(id), AES_KEY_256, key, &gcm));
+
+    MODA_AES_GCM_Seal(&gcm, iv, sizeof(iv), outText, pt, sizeof(pt), aad, sizeof(aad), outTag, sizeof(outTag));
+    assert_memory_equal(expectedTag, outTag, sizeof(outTag));
+    assert_memory_equal(expectedText, outText, sizeof(outText));
+
+    assert_true(MODA_AES_GCM_Open(&gcm, iv, sizeof(iv), outText, expectedText, sizeof(pt), aad, sizeof(aad), expectedTag, sizeof(expectedTag)));
+    assert_memory_equal(pt, outText, sizeof(outText));
+
+    /* the same entry serves the block cipher alone */
+    assert_true(MODA_AES_CacheGet(&cache, id, sizeof(id), AES_KEY_256, key, &aes));
+    assert_memory_equal(&expected.aes, &aes, sizeof(aes));
+}
+
+static void test_MODA_AES_CacheGet_evict(void **user)
+{
+    struct aes_ctxt expected;
+    struct aes_ctxt aes;
+    uint8_t key[32U];
+    size_t capacity;
+    size_t hits = 0U;
+    uint8_t a[AES_BLOCK_SIZE];
+    uint8_t b[AES_BLOCK_SIZE];
+    bool present;
+    bool hit;
+    uint32_t i;
+
+    capacity = MODA_AES_CacheInit(&cache, mem, sizeof(mem));
+
+    for(i = 0U; i < 1000U; i++){
+
+        makeKey(key, i);
+        (void)MODA_AES_CacheGet(&cache, NULL, 0U, AES_KEY_128, key, &aes);
+
+        /* the most recent key always survives */
+        assert_true(MODA_AES_CacheGet(&cache, NULL, 0U, AES_KEY_128, key, &aes));
+    }
+
+    /* newest first, so each survivor is met before it can be evicted */
+    for(i = 1000U; i > 0U; i--){
+
+        makeKey(key, i - 1U);
+        MODA_AES_Init(&expected, AES_KEY_128, key);
+
+        /* evicted keys leave nothing behind */
+        present = inMem(key, AES_KEY_128);
+
+        hit = MODA_AES_CacheGet(&cache, NULL, 0U, AES_KEY_128, key, &aes);
+
+        assert_int_equal(present, hit);
+
+        (void)memset(a, (int)i, sizeof(a));
+        (void)memset(b, (int)i, sizeof(b));
+        MODA_AES_Encrypt(&expected, a);
+        MODA_AES_Encrypt(&aes, b);
+        assert_memory_equal(a, b, sizeof(a));
+
+        if(hit){
+
+            hits++;
+        }
+    }
+
+    assert_int_equal(capacity, hits);
+}
+
+static void test_MODA_AES_CacheRemove(void **user)
+{
+    static const uint8_t id[] = "key-two";
+    struct aes_ctxt aes;
+    uint8_t key[32U];
+
+    (void)MODA_AES_CacheInit(&cache, mem, sizeof(mem));
+
+    makeKey(key, 7U);
+
+    assert_false(MODA_AES_CacheRemove(&cache, id, sizeof(id)));
+
+    assert_false(MODA_AES_CacheGet(&cache, id, sizeof(id), AES_KEY_256, key, &aes));
+    assert_true(inMem(key, AES_KEY_256));
+
+    assert_true(MODA_AES_CacheRemove(&cache, id, sizeof(id)));
+    assert_false(inMem(key, AES_KEY_256));
+    assert_false(inMem(id, sizeof(id)));
+
+    assert_false(MODA_AES_CacheGet(&cache, id, sizeof(id), AES_KEY_256, key, &aes));
+    assert_true(MODA_AES_CacheGet(&cache, id, sizeof(id), AES_KEY_256, key, &aes));
+}
+
+static void test_MODA_AES_CacheClear(void **user)
+{
+    struct aes_ctxt aes;
+    uint8_t key[32U];
+    uint32_t i;
+
+    (void)MODA_AES_CacheInit(&cache, mem, sizeof(mem));
+
+    for(i = 0U; i < 8U; i++){
+
+        makeKey(key, i);
+        (void)MODA_AES_CacheGet(&cache, NULL, 0U, AES_KEY_192, key, &aes);
+    }
+
+    MODA_AES_CacheClear(&cache);
+
+    for(i = 0U; i < 8U; i++){
+
+        makeKey(key, i);
+        assert_false(inMem(key, AES_KEY_192));
+    }
+
+    makeKey(key, 0U);
+    assert_false(MODA_AES_CacheGet(&cache, NULL, 0U, AES_KEY_192, key, &aes));
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_MODA_AES_CacheInit),
+        cmocka_unit_test(test_MODA_AES_CacheGet),
+        cmocka_unit_test(test_MODA_AES_CacheGetGCM),
+        cmocka_unit_test(test_MODA_AES_CacheGet_evict),
+        cmocka_unit_test(test_MODA_AES_CacheRemove),
+        cmocka_unit_test(test_MODA_AES_CacheClear)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -29,6 +29,7 @@
 #include <stdarg.h>
 #include <stddef.h>
 #include <setjmp.h>
+#include <string.h>
 
 #include "cmocka.h"
 
@@ -169,6 +170,69 @@ static void test_MODA_AES_GCM_Encrypt_oddiv(void **user)
     assert_memory_equal(ct, outText, sizeof(outText));
 }
 
+static void test_MODA_AES_GCM_Encrypt_long(void **user)
+{
+    static const uint8_t key[] = {0xd4,0x41,0x36,0x94,0x5e,0x87,0x31,0x09,0xcc,0x7a,0xf8,0xf5,0x16,0x91,0x34,0xf2};
+    static const uint8_t iv[] = {0xc7,0x3f,0x3e,0x5c,0x68,0xf0,0x6a,0xab,0xae,0xc2,0x17,0x94};
+    static const uint8_t pt[] = {
+        0x0e,0x27,0xe4,0x44,0x26,0xf1,0x97,0x60,0xa7,0xb8,0x15,0x6c,0x41,0xba,0xe8,0xd0,
+        0xc8,0x7f,0x5a,0x84,0xa0,0xd7,0xc0,0x70,0xe4,0x95,0x8b,0x82,0x59,0x0c,0x0d,0x91,
+        0x16,0x4d,0x0a,0xf5,0xef,0x1f,0x06,0xe2,0xa6,0xbb,0x49,0x89,0xd0,0x4c,0xb2,0xed,
+        0x88,0x29,0x41,0x85,0xd7,0xd0,0x62,0x97,0xdf,0xa2,0xfa,0x4f,0xca,0x61,0x33,0xa2,
+        0x74,0x69,0x08,0xe5,0xda,0xb1,0x8f,0x2b,0x42,0x81,0x09,0x63,0x28,0xf1,0xab,0x2e,
+        0xec,0x25,0x2a,0x82,0x3d,0x4a,0x09,0x00,0x43,0x4f,0xa2,0x15,0x8f,0x64,0xf6,0xd2,
+        0xc3,0x33,0x34,0x8c,0x01,0xe1,0x0b,0x33,0x14,0xc3,0xaf,0x73,0x61,0xe0,0xad,0x8c,
+        0x8b,0x2b,0x6f,0xf2,0xe9,0x7d,0x8f,0xa4,0xa9,0x54,0xdc,0x4c,0xc1,0x4e,0x2d,0x1c,
+        0x99,0x63,0xe8,0x63,0x79,0xe5,0x50,0xf1,0xb4,0x39,0x93,0x30,0x92,0x53,0x8f,0xff,
+        0xff,0xf3,0x68,0x4d,0xf4,0xa1,0xca,0x7a,0xa9,0x69,0xff,0x6d,0x77,0x57,0xb0,0x75,
+        0x8f,0xb1,0x7a,0xe1,0x5d,0xf7,0x38,0x5e,0xba,0x9b,0x0b,0x13,0xd4,0x80,0x29,0x7e,
+        0xdd,0x35,0x6b,0x0c,0x76,0xee,0x94,0x7b,0xda,0x46,0x62,0xf0,0xcb,0xb7,0x57,0xd7,
+        0x3c,0xd5,0x44,0x7e,0xc3,0x4d,0x9a,0x71,0xbd,0xa1,0x70,0x93,0x3e,0xa1,0x54,0x01,
+        0xc0,0xa8,0xd2,0xa6,0x87,0x9c,0xc5,0x9e,0xd5,0xa3,0x60,0x4c,0xd3,0xa6,0xfa,0x3a,
+        0x3a,0x86,0x9e,0xb3,0xc4,0x21,0x4e,0x22,0x56,0x03,0x1b,0x29,0xea,0xec,0xe6,0x81,
+        0x3e,0x06,0xf3,0x94,0x3e,0xe3,0x33,0xdc,0x32,0x38,0x4e,0xf9,0xa7,0x5b,0x72,0x95,
+        0x1f,0x7e,0xde,0xf8,0x78,0xa9,0x2d,0x6a,0x1c,0x79,0x63,0x4c,0xee,0x9a,0xb9,0xf5,
+        0xf0,0x05,0x28,0x4d,0xb4,0xfa,0xb7,0x2c,0x88,0xbd,0x85,0x70,0x61,0x10,0x96,0xe0,
+        0x83,0x73,0x5d,0xc4,0xf6,0x1e,0x0d,0x40,0xa9,0xbb,0xa0,0x74
+    };
+    static const uint8_t aad[] = {
+        0x62,0x04,0x77,0xdf,0x14,0x6f,0x1f,0x07,0x7f,0x26,0x4d,0x93,0xbb,0x6f,0xfd,0x37,
+        0x25,0x2f,0xaa,0xa9
+    };
+    static const uint8_t ct[] = {
+        0xfc,0x9d,0xc6,0xaf,0x24,0x86,0x62,0xf4,0xf9,0x55,0x84,0x81,0x0b,0xa2,0x81,0x7e,
+        0xb2,0x2b,0x43,0xe5,0x10,0x12,0xe7,0x4a,0x26,0x34,0x8c,0x60,0x41,0x0a,0x07,0xbd,
+        0xc6,0x64,0x48,0x01,0x64,0x6f,0xbb,0x29,0x91,0x10,0xf2,0x93,0x7c,0x0e,0x9b,0x05,
+        0x8e,0xbe,0x84,0xa6,0x47,0x0f,0xf9,0xc4,0x10,0xa0,0x3a,0x86,0xa8,0xf1,0x19,0x1c,
+        0xc2,0xf3,0x4d,0xb3,0x3d,0x47,0xd2,0xb3,0xd5,0x16,0x06,0x75,0x3b,0x4b,0x6d,0x97,
+        0xcc,0xea,0x8e,0x97,0xc1,0xb0,0xfe,0xd8,0xc2,0xb0,0x5c,0x4f,0x30,0xf7,0x13,0x6c,
+        0xac,0x60,0x10,0x77,0x84,0x05,0x24,0x34,0x19,0x85,0xc0,0x7f,0x88,0x28,0x05,0x48,
+        0xcb,0xdd,0xbf,0x52,0x3c,0x0c,0xd9,0x60,0x26,0xb7,0x8a,0x8d,0x77,0xb2,0x39,0xef,
+        0x0a,0xf5,0xb1,0x9d,0x9f,0x48,0xce,0x9e,0x3b,0x25,0xf5,0xf1,0x2d,0x8e,0xb6,0x49,
+        0x2d,0x86,0x23,0xf6,0xb8,0x8a,0x34,0xe4,0x02,0xc4,0x18,0x57,0xb0,0x20,0x38,0xaf,
+        0xe0,0x97,0x81,0x26,0xb7,0xd2,0x56,0xc4,0x2b,0x46,0x93,0x54,0x47,0x4a,0x2a,0x3a,
+        0xe5,0xf4,0xe0,0x14,0x73,0x05,0x96,0x55,0xc2,0x3a,0x90,0x2e,0x5f,0x6a,0xa6,0x8e,
+        0xd0,0xfd,0x07,0x57,0x84,0x30,0x3d,0xcd,0xbb,0x97,0x56,0x7d,0x24,0xde,0xd4,0x37,
+        0xdb,0x26,0x2f,0xb8,0x06,0x61,0x48,0xb2,0x84,0x87,0xce,0x4b,0x47,0x24,0x18,0x7a,
+        0x4e,0x36,0x89,0xe4,0xec,0x0a,0xb6,0x57,0x56,0x99,0xe4,0xf5,0xdc,0x99,0xf2,0x53,
+        0x7f,0x62,0xff,0x34,0x6f,0x62,0xf7,0x71,0x35,0x42,0x41,0x14,0xbe,0x8b,0xe3,0xee,
+        0x2d,0x21,0x8f,0x04,0x21,0xd1,0xb7,0x3a,0x7e,0xfd,0x11,0xbc,0x5b,0xd8,0xb4,0xda,
+        0xe6,0xee,0x63,0xbf,0x7e,0x83,0x77,0x2d,0x53,0xb9,0x68,0x26,0x70,0xce,0x70,0xdd,
+        0x95,0x6a,0x57,0x48,0x60,0x97,0x63,0xc4,0x15,0xe3,0x65,0x7c
+    };
+    static const uint8_t tag[] = {0x39,0xbb,0xb3,0x3f,0x4a,0xd0,0x79,0x12,0x20,0xcc,0xe1,0xa2,0xd0,0xd3,0xc9,0x2a};
+
+    struct aes_ctxt aes;
+    uint8_t outText[sizeof(pt)];
+    uint8_t outTag[sizeof(tag)];
+
+    MODA_AES_Init(&aes, AES_KEY_128, key);
+    MODA_AES_GCM_Encrypt(&aes, iv, sizeof(iv), outText, pt, sizeof(pt), aad, sizeof(aad), outTag, sizeof(outTag));
+
+    assert_memory_equal(tag, outTag, sizeof(outTag));
+    assert_memory_equal(ct, outText, sizeof(outText));
+}
+
 static void test_MODA_AES_GCM_Decrypt_notext_noaad(void **user)
 {
     bool retval;
@@ -320,6 +384,496 @@ static void test_MODA_AES_GCM_Decrypt_oddiv(void **user)
     assert_false(retval);        
 }
 
+static void test_MODA_AES_GCM_Decrypt_long(void **user)
+{
+    bool retval;
+    static const uint8_t key[] = {0xd4,0x41,0x36,0x94,0x5e,0x87,0x31,0x09,0xcc,0x7a,0xf8,0xf5,0x16,0x91,0x34,0xf2};
+    static const uint8_t iv[] = {0xc7,0x3f,0x3e,0x5c,0x68,0xf0,0x6a,0xab,0xae,0xc2,0x17,0x94};
+    static const uint8_t pt[] = {
+        0x0e,0x27,0xe4,0x44,0x26,0xf1,0x97,0x60,0xa7,0xb8,0x15,0x6c,0x41,0xba,0xe8,0xd0,
+        0xc8,0x7f,0x5a,0x84,0xa0,0xd7,0xc0,0x70,0xe4,0x95,0x8b,0x82,0x59,0x0c,0x0d,0x91,
+        0x16,0x4d,0x0a,0xf5,0xef,0x1f,0x06,0xe2,0xa6,0xbb,0x49,0x89,0xd0,0x4c,0xb2,0xed,
+        0x88,0x29,0x41,0x85,0xd7,0xd0,0x62,0x97,0xdf,0xa2,0xfa,0x4f,0xca,0x61,0x33,0xa2,
+        0x74,0x69,0x08,0xe5,0xda,0xb1,0x8f,0x2b,0x42,0x81,0x09,0x63,0x28,0xf1,0xab,0x2e,
+        0xec,0x25,0x2a,0x82,0x3d,0x4a,0x09,0x00,0x43,0x4f,0xa2,0x15,0x8f,0x64,0xf6,0xd2,
+        0xc3,0x33,0x34,0x8c,0x01,0xe1,0x0b,0x33,0x14,0xc3,0xaf,0x73,0x61,0xe0,0xad,0x8c,
+        0x8b,0x2b,0x6f,0xf2,0xe9,0x7d,0x8f,0xa4,0xa9,0x54,0xdc,0x4c,0xc1,0x4e,0x2d,0x1c,
+        0x99,0x63,0xe8,0x63,0x79,0xe5,0x50,0xf1,0xb4,0x39,0x93,0x30,0x92,0x53,0x8f,0xff,
+        0xff,0xf3,0x68,0x4d,0xf4,0xa1,0xca,0x7a,0xa9,0x69,0xff,0x6d,0x77,0x57,0xb0,0x75,
+        0x8f,0xb1,0x7a,0xe1,0x5d,0xf7,0x38,0x5e,0xba,0x9b,0x0b,0x13,0xd4,0x80,0x29,0x7e,
+        0xdd,0x35,0x6b,0x0c,0x76,0xee,0x94,0x7b,0xda,0x46,0x62,0xf0,0xcb,0xb7,0x57,0xd7,
+        0x3c,0xd5,0x44,0x7e,0xc3,0x4d,0x9a,0x71,0xbd,0xa1,0x70,0x93,0x3e,0xa1,0x54,0x01,
+        0xc0,0xa8,0xd2,0xa6,0x87,0x9c,0xc5,0x9e,0xd5,0xa3,0x60,0x4c,0xd3,0xa6,0xfa,0x3a,
+        0x3a,0x86,0x9e,0xb3,0xc4,0x21,0x4e,0x22,0x56,0x03,0x1b,0x29,0xea,0xec,0xe6,0x81,
+        0x3e,0x06,0xf3,0x94,0x3e,0xe3,0x33,0xdc,0x32,0x38,0x4e,0xf9,0xa7,0x5b,0x72,0x95,
+        0x1f,0x7e,0xde,0xf8,0x78,0xa9,0x2d,0x6a,0x1c,0x79,0x63,0x4c,0xee,0x9a,0xb9,0xf5,
+        0xf0,0x05,0x28,0x4d,0xb4,0xfa,0xb7,0x2c,0x88,0xbd,0x85,0x70,0x61,0x10,0x96,0xe0,
+        0x83,0x73,0x5d,0xc4,0xf6,0x1e,0x0d,0x40,0xa9,0xbb,0xa0,0x74
+    };
+    static const uint8_t aad[] = {
+        0x62,0x04,0x77,0xdf,0x14,0x6f,0x1f,0x07,0x7f,0x26,0x4d,0x93,0xbb,0x6f,0xfd,0x37,
+        0x25,0x2f,0xaa,0xa9
+    };
+    static const uint8_t ct[] = {
+        0xfc,0x9d,0xc6,0xaf,0x24,0x86,0x62,0xf4,0xf9,0x55,0x84,0x81,0x0b,0xa2,0x81,0x7e,
+        0xb2,0x2b,0x43,0xe5,0x10,0x12,0xe7,0x4a,0x26,0x34,0x8c,0x60,0x41,0x0a,0x07,0xbd,
+        0xc6,0x64,0x48,0x01,0x64,0x6f,0xbb,0x29,0x91,0x10,0xf2,0x93,0x7c,0x0e,0x9b,0x05,
+        0x8e,0xbe,0x84,0xa6,0x47,0x0f,0xf9,0xc4,0x10,0xa0,0x3a,0x86,0xa8,0xf1,0x19,0x1c,
+        0xc2,0xf3,0x4d,0xb3,0x3d,0x47,0xd2,0xb3,0xd5,0x16,0x06,0x75,0x3b,0x4b,0x6d,0x97,
+        0xcc,0xea,0x8e,0x97,0xc1,0xb0,0xfe,0xd8,0xc2,0xb0,0x5c,0x4f,0x30,0xf7,0x13,0x6c,
+        0xac,0x60,0x10,0x77,0x84,0x05,0x24,0x34,0x19,0x85,0xc0,0x7f,0x88,0x28,0x05,0x48,
+        0xcb,0xdd,0xbf,0x52,0x3c,0x0c,0xd9,0x60,0x26,0xb7,0x8a,0x8d,0x77,0xb2,0x39,0xef,
+        0x0a,0xf5,0xb1,0x9d,0x9f,0x48,0xce,0x9e,0x3b,0x25,0xf5,0xf1,0x2d,0x8e,0xb6,0x49,
+        0x2d,0x86,0x23,0xf6,0xb8,0x8a,0x34,0xe4,0x02,0xc4,0x18,0x57,0xb0,0x20,0x38,0xaf,
+        0xe0,0x97,0x81,0x26,0xb7,0xd2,0x56,0xc4,0x2b,0x46,0x93,0x54,0x47,0x4a,0x2a,0x3a,
+        0xe5,0xf4,0xe0,0x14,0x73,0x05,0x96,0x55,0xc2,0x3a,0x90,0x2e,0x5f,0x6a,0xa6,0x8e,
+        0xd0,0xfd,0x07,0x57,0x84,0x30,0x3d,0xcd,0xbb,0x97,0x56,0x7d,0x24,0xde,0xd4,0x37,
+        0xdb,0x26,0x2f,0xb8,0x06,0x61,0x48,0xb2,0x84,0x87,0xce,0x4b,0x47,0x24,0x18,0x7a,
+        0x4e,0x36,0x89,0xe4,0xec,0x0a,0xb6,0x57,0x56,0x99,0xe4,0xf5,0xdc,0x99,0xf2,0x53,
+        0x7f,0x62,0xff,0x34,0x6f,0x62,0xf7,0x71,0x35,0x42,0x41,0x14,0xbe,0x8b,0xe3,0xee,
+        0x2d,0x21,0x8f,0x04,0x21,0xd1,0xb7,0x3a,0x7e,0xfd,0x11,0xbc,0x5b,0xd8,0xb4,0xda,
+        0xe6,0xee,0x63,0xbf,0x7e,0x83,0x77,0x2d,0x53,0xb9,0x68,0x26,0x70,0xce,0x70,0xdd,
+        0x95,0x6a,0x57,0x48,0x60,0x97,0x63,0xc4,0x15,0xe3,0x65,0x7c
+    };
+    static const uint8_t tag[] = {0x39,0xbb,0xb3,0x3f,0x4a,0xd0,0x79,0x12,0x20,0xcc,0xe1,0xa2,0xd0,0xd3,0xc9,0x2a};
+
+    struct aes_ctxt aes;
+    uint8_t outText[sizeof(pt)];
+    
+    MODA_AES_Init(&aes, AES_KEY_128, key);
+    retval = MODA_AES_GCM_Decrypt(&aes, iv, sizeof(iv), outText, ct, sizeof(ct), aad, sizeof(aad), tag, sizeof(tag));
+    assert_true(retval);
+    assert_memory_equal(pt, outText, sizeof(outText));
+}
+
+static void test_MODA_AES_GCM_Seal(void **user)
+{
+    static const uint8_t key[] = {0xc9,0x39,0xcc,0x13,0x39,0x7c,0x1d,0x37,0xde,0x6a,0xe0,0xe1,0xcb,0x7c,0x42,0x3c};
+    static const uint8_t iv[] = {0xb3,0xd8,0xcc,0x01,0x7c,0xbb,0x89,0xb3,0x9e,0x0f,0x67,0xe2};
+    static const uint8_t oddiv[] = {0xcf};
+    static const uint8_t pt[] = {0xc3,0xb3,0xc4,0x1f,0x11,0x3a,0x31,0xb7,0x3d,0x9a,0x5c,0xd4,0x32,0x10,0x30,0x69};
+    static const uint8_t aad[] = {0x24,0x82,0x56,0x02,0xbd,0x12,0xa9,0x84,0xe0,0x09,0x2d,0x3e,0x44,0x8e,0xda,0x5f};
+    static const uint8_t ct[] = {0x93,0xfe,0x7d,0x9e,0x9b,0xfd,0x10,0x34,0x8a,0x56,0x06,0xe5,0xca,0xfa,0x73,0x54};
+    static const uint8_t tag[] = {0x00,0x32,0xa1,0xdc,0x85,0xf1,0xc9,0x78,0x69,0x25,0xa2,0xe7,0x1d,0x82,0x72,0xdd};
+
+    struct aes_gcm_ctxt gcm;
+    struct aes_ctxt aes;
+    uint8_t outText[sizeof(pt)];
+    uint8_t outTag[sizeof(tag)];
+    uint8_t expectedText[sizeof(pt)];
+    uint8_t expectedTag[sizeof(tag)];
+    uint32_t i;
+
+    MODA_AES_GCM_Init(&gcm, AES_KEY_128, key);
+
+    /* the key is reused for every message */
+    for(i = 0U; i < 3U; i++){
+
+        MODA_AES_GCM_Seal(&gcm, iv, sizeof(iv), outText, pt, sizeof(pt), aad, sizeof(aad), outTag, sizeof(outTag));
+
+        assert_memory_equal(tag, outTag, sizeof(outTag));
+        assert_memory_equal(ct, outText, sizeof(outText));
+    }
+
+    /* same as the one step interface for every text size and a non-nominal IV */
+    MODA_AES_Init(&aes, AES_KEY_128, key);
+
+    for(i = 0U; i <= sizeof(pt); i++){
+
+        MODA_AES_GCM_Encrypt(&aes, oddiv, sizeof(oddiv), expectedText, pt, i, aad, i, expectedTag, sizeof(expectedTag));
+        MODA_AES_GCM_Seal(&gcm, oddiv, sizeof(oddiv), outText, pt, i, aad, i, outTag, sizeof(outTag));
+
+        assert_memory_equal(expectedTag, outTag, sizeof(outTag));
+        assert_memory_equal(expectedText, outText, i);
+    }
+}
+
+static void test_MODA_AES_GCM_Open(void **user)
+{
+    static const uint8_t key[] = {0xc9,0x39,0xcc,0x13,0x39,0x7c,0x1d,0x37,0xde,0x6a,0xe0,0xe1,0xcb,0x7c,0x42,0x3c};
+    static const uint8_t iv[] = {0xb3,0xd8,0xcc,0x01,0x7c,0xbb,0x89,0xb3,0x9e,0x0f,0x67,0xe2};
+    static const uint8_t pt[] = {0xc3,0xb3,0xc4,0x1f,0x11,0x3a,0x31,0xb7,0x3d,0x9a,0x5c,0xd4,0x32,0x10,0x30,0x69};
+    static const uint8_t aad[] = {0x24,0x82,0x56,0x02,0xbd,0x12,0xa9,0x84,0xe0,0x09,0x2d,0x3e,0x44,0x8e,0xda,0x5f};
+    static const uint8_t ct[] = {0x93,0xfe,0x7d,0x9e,0x9b,0xfd,0x10,0x34,0x8a,0x56,0x06,0xe5,0xca,0xfa,0x73,0x54};
+    static const uint8_t tag[] = {0x00,0x32,0xa1,0xdc,0x85,0xf1,0xc9,0x78,0x69,0x25,0xa2,0xe7,0x1d,0x82,0x72,0xdd};
+    static const uint8_t badTag[] = {0x00,0x32,0xa1,0xdc,0x85,0xf1,0xc9,0x78,0x69,0x25,0xa2,0xe7,0x1d,0x82,0x72,0xdc};
+
+    struct aes_gcm_ctxt gcm;
+    uint8_t outText[sizeof(pt)];
+
+    MODA_AES_GCM_Init(&gcm, AES_KEY_128, key);
+
+    assert_true(MODA_AES_GCM_Open(&gcm, iv, sizeof(iv), outText, ct, sizeof(ct), aad, sizeof(aad), tag, sizeof(tag)));
+    assert_memory_equal(pt, outText, sizeof(outText));
+
+    assert_false(MODA_AES_GCM_Open(&gcm, iv, sizeof(iv), outText, ct, sizeof(ct), aad, sizeof(aad), badTag, sizeof(badTag)));
+
+    assert_true(MODA_AES_GCM_Open(&gcm, iv, sizeof(iv), outText, ct, sizeof(ct), aad, sizeof(aad), tag, sizeof(tag)));
+    assert_memory_equal(pt, outText, sizeof(outText));
+}
+
+/* key of the generated fixture below, and the tag OpenSSL gives for all of it */
+static const uint8_t fixtureKey[] = {0xc9,0x39,0xcc,0x13,0x39,0x7c,0x1d,0x37,0xde,0x6a,0xe0,0xe1,0xcb,0x7c,0x42,0x3c};
+static const uint8_t fixtureTag[] = {0x6b,0xb0,0x29,0x13,0x35,0x17,0x28,0x7c,0xdd,0x27,0xa8,0xbd,0x52,0xcd,0x81,0x76};
+
+/* generated text, aad and iv shared by the longer tests (any may be NULL) */
+static void fill(uint8_t *pt, size_t ptSize, uint8_t *aad, size_t aadSize, uint8_t *iv, size_t ivSize)
+{
+    size_t i;
+
+    for(i = 0U; i < ptSize; i++){
+
+        pt[i] = (uint8_t)((i * 37U) + 11U);
+    }
+
+    for(i = 0U; i < aadSize; i++){
+
+        aad[i] = (uint8_t)((i * 91U) + 5U);
+    }
+
+    for(i = 0U; i < ivSize; i++){
+
+        iv[i] = (uint8_t)((i * 53U) + 7U);
+    }
+}
+
+/* size of the next piece of a message split into pieces of varied size */
+static size_t piece(size_t n, size_t pos, size_t size)
+{
+    static const size_t pieces[] = {1U, 15U, 16U, 17U, 3U, 0U, 40U, 7U, 130U};
+    size_t retval = pieces[n % (sizeof(pieces)/sizeof(*pieces))];
+
+    return ((size - pos) < retval) ? (size - pos) : retval;
+}
+
+static void test_MODA_AES_GCM_Seal_multiblock(void **user)
+{
+    /* tag from OpenSSL for the fill() fixture with a 12 byte iv */
+    static const uint8_t tag12[] = {0xd3,0x45,0x82,0x51,0x17,0xfd,0xcd,0xf8,0xcd,0x35,0x9a,0x1b,0xce,0x66,0xa9,0x75};
+
+    struct aes_gcm_ctxt gcm;
+    uint8_t iv[17];
+    uint8_t aad[77];
+    uint8_t pt[1000];
+    uint8_t ct[sizeof(pt)];
+    uint8_t outText[sizeof(pt)];
+    uint8_t outTag[sizeof(fixtureTag)];
+
+    fill(pt, sizeof(pt), aad, sizeof(aad), iv, sizeof(iv));
+
+    MODA_AES_GCM_Init(&gcm, AES_KEY_128, fixtureKey);
+
+    MODA_AES_GCM_Seal(&gcm, iv, sizeof(iv), ct, pt, sizeof(pt), aad, sizeof(aad), outTag, sizeof(outTag));
+    assert_memory_equal(fixtureTag, outTag, sizeof(outTag));
+
+    assert_true(MODA_AES_GCM_Open(&gcm, iv, sizeof(iv), outText, ct, sizeof(ct), aad, sizeof(aad), fixtureTag, sizeof(fixtureTag)));
+    assert_memory_equal(pt, outText, sizeof(outText));
+
+    /* in place */
+    (void)memcpy(outText, pt, sizeof(pt));
+    MODA_AES_GCM_Seal(&gcm, iv, 12U, outText, outText, sizeof(pt), aad, sizeof(aad), outTag, sizeof(outTag));
+    assert_memory_equal(tag12, outTag, sizeof(outTag));
+
+    assert_true(MODA_AES_GCM_Open(&gcm, iv, 12U, outText, outText, sizeof(pt), aad, sizeof(aad), tag12, sizeof(tag12)));
+    assert_memory_equal(pt, outText, sizeof(outText));
+}
+
+static void test_MODA_AES_GCM_InitTable(void **user)
+{
+    static const uint8_t iv[] = {0xb3,0xd8,0xcc,0x01,0x7c,0xbb,0x89,0xb3,0x9e,0x0f,0x67,0xe2};
+    static const uint8_t oddiv[] = {0xcf,0x20,0x41,0x62,0x83,0xa4,0xc5,0xe6,0x07,0x28,0x49,0x6a,0x8b,0xac,0xcd,0xee,0x0f};
+    static const size_t tableSize[] = {AES_GCM_TABLE_4BIT, AES_GCM_TABLE_8BIT, AES_GCM_TABLE_64K};
+    static uint64_t table[AES_GCM_TABLE_64K / sizeof(uint64_t)];
+
+    struct aes_gcm_ctxt gcm;
+    struct aes_ctxt aes;
+    uint8_t pt[67];
+    uint8_t aad[35];
+    uint8_t outText[sizeof(pt)];
+    uint8_t outTag[AES_BLOCK_SIZE];
+    uint8_t expectedText[sizeof(pt)];
+    uint8_t expectedTag[AES_BLOCK_SIZE];
+    uint32_t i;
+    uint32_t j;
+
+    fill(pt, sizeof(pt), aad, sizeof(aad), NULL, 0U);
+
+    MODA_AES_Init(&aes, AES_KEY_128, fixtureKey);
+    MODA_AES_GCM_Init(&gcm, AES_KEY_128, fixtureKey);
+
+    /* every table gives the same tags as the table-less GHASH */
+    for(j = 0U; j < (sizeof(tableSize)/sizeof(*tableSize)); j++){
+
+        MODA_AES_GCM_InitTable(&gcm, table, tableSize[j]);
+
+        for(i = 0U; i <= sizeof(pt); i++){
+
+            MODA_AES_GCM_Encrypt(&aes, iv, sizeof(iv), expectedText, pt, i, aad, i % sizeof(aad), expectedTag, sizeof(expectedTag));
+            MODA_AES_GCM_Seal(&gcm, iv, sizeof(iv), outText, pt, i, aad, i % sizeof(aad), outTag, sizeof(outTag));
+
+            assert_memory_equal(expectedTag, outTag, sizeof(outTag));
+            assert_memory_equal(expectedText, outText, i);
+
+            MODA_AES_GCM_Encrypt(&aes, oddiv, (i % sizeof(oddiv)) + 1U, expectedText, pt, i, aad, i % sizeof(aad), expectedTag, sizeof(expectedTag));
+            MODA_AES_GCM_Seal(&gcm, oddiv, (i % sizeof(oddiv)) + 1U, outText, pt, i, aad, i % sizeof(aad), outTag, sizeof(outTag));
+
+            assert_memory_equal(expectedTag, outTag, sizeof(outTag));
+            assert_memory_equal(expectedText, outText, i);
+
+            assert_true(MODA_AES_GCM_Open(&gcm, oddiv, (i % sizeof(oddiv)) + 1U, outText, expectedText, i, aad, i % sizeof(aad), expectedTag, sizeof(expectedTag)));
+            assert_memory_equal(pt, outText, i);
+
+            expectedTag[i % sizeof(expectedTag)] ^= 0x01U;
+            assert_false(MODA_AES_GCM_Open(&gcm, oddiv, (i % sizeof(oddiv)) + 1U, outText, expectedText, i, aad, i % sizeof(aad), expectedTag, sizeof(expectedTag)));
+        }
+    }
+}
+
+static void test_MODA_AES_GCM_Stream(void **user)
+{
+    static const uint32_t ivSizes[] = {12U, 1U, 17U};
+
+    struct aes_gcm_ctxt gcm;
+    struct aes_gcm_stream stream;
+    uint8_t iv[17];
+    uint8_t aad[77];
+    uint8_t pt[300];
+    uint8_t expectedText[sizeof(pt)];
+    uint8_t expectedTag[AES_BLOCK_SIZE];
+    uint8_t outText[sizeof(pt)];
+    uint8_t outTag[AES_BLOCK_SIZE];
+    size_t pos;
+    size_t n;
+    uint32_t i;
+    uint32_t j;
+    uint32_t k;
+
+    fill(pt, sizeof(pt), aad, sizeof(aad), iv, sizeof(iv));
+
+    MODA_AES_GCM_Init(&gcm, AES_KEY_128, fixtureKey);
+
+    /* text and aad split differently for every offset into the piece sizes */
+    for(k = 0U; k < 9U; k++){
+
+        for(j = 0U; j < (sizeof(ivSizes)/sizeof(*ivSizes)); j++){
+
+            for(i = 0U; i < 3U; i++){
+
+                uint32_t aadSize = (i == 0U) ? 0U : ((i == 1U) ? 16U : sizeof(aad));
+                uint32_t textSize = sizeof(pt) - (k * 7U) - i;
+
+                MODA_AES_GCM_Seal(&gcm, iv, ivSizes[j], expectedText, pt, textSize, aad, aadSize, expectedTag, sizeof(expectedTag));
+
+                /* encrypt */
+                MODA_AES_GCM_StreamInit(&stream, &gcm, iv, ivSizes[j], true);
+
+                for(pos = 0U, n = k; pos < aadSize; pos += piece(n, pos, aadSize), n++){
+
+                    MODA_AES_GCM_StreamAAD(&stream, &aad[pos], piece(n, pos, aadSize));
+                }
+
+                for(pos = 0U, n = k; pos < textSize; pos += piece(n, pos, textSize), n++){
+
+                    MODA_AES_GCM_StreamUpdate(&stream, &outText[pos], &pt[pos], piece(n, pos, textSize));
+                }
+
+                MODA_AES_GCM_StreamFinal(&stream, outTag, sizeof(outTag));
+
+                assert_memory_equal(expectedTag, outTag, sizeof(outTag));
+                assert_memory_equal(expectedText, outText, textSize);
+
+                /* decrypt in place */
+                MODA_AES_GCM_StreamInit(&stream, &gcm, iv, ivSizes[j], false);
+
+                for(pos = 0U, n = k + 1U; pos < aadSize; pos += piece(n, pos, aadSize), n++){
+
+                    MODA_AES_GCM_StreamAAD(&stream, &aad[pos], piece(n, pos, aadSize));
+                }
+
+                for(pos = 0U, n = k + 1U; pos < textSize; pos += piece(n, pos, textSize), n++){
+
+                    MODA_AES_GCM_StreamUpdate(&stream, &outText[pos], &outText[pos], piece(n, pos, textSize));
+                }
+
+                assert_true(MODA_AES_GCM_StreamCheck(&stream, expectedTag, sizeof(expectedTag)));
+                assert_memory_equal(pt, outText, textSize);
+            }
+        }
+    }
+
+    /* a modified tag is rejected */
+    MODA_AES_GCM_StreamInit(&stream, &gcm, iv, 12U, false);
+    MODA_AES_GCM_StreamAAD(&stream, aad, sizeof(aad));
+    MODA_AES_GCM_StreamUpdate(&stream, outText, expectedText, 5U);
+    expectedTag[0] ^= 0x80U;
+    assert_false(MODA_AES_GCM_StreamCheck(&stream, expectedTag, sizeof(expectedTag)));
+}
+
+static void test_MODA_AES_GCM_Parallel(void **user)
+{
+    static const size_t sizes[] = {0U, 1U, 16U, 17U, 129U, 1000U};
+
+    struct aes_gcm_ctxt gcm;
+    struct aes_gcm_parallel p;
+    struct aes_gcm_share share[9];
+    uint8_t iv[17];
+    uint8_t aad[77];
+    uint8_t pt[1000];
+    uint8_t ct[sizeof(pt)];
+    uint8_t outText[sizeof(pt)];
+    uint8_t expectedTag[sizeof(fixtureTag)];
+    uint8_t outTag[sizeof(fixtureTag)];
+    size_t threads;
+    size_t n;
+    size_t i;
+    size_t j;
+
+    fill(pt, sizeof(pt), aad, sizeof(aad), iv, sizeof(iv));
+
+    MODA_AES_GCM_Init(&gcm, AES_KEY_128, fixtureKey);
+
+    for(j = 0U; j < (sizeof(sizes)/sizeof(*sizes)); j++){
+
+        MODA_AES_GCM_Seal(&gcm, iv, sizeof(iv), ct, pt, sizes[j], aad, sizeof(aad), expectedTag, sizeof(expectedTag));
+
+        for(threads = 1U; threads <= (sizeof(share)/sizeof(*share)); threads++){
+
+            /* shares done out of order as a pool might */
+            n = MODA_AES_GCM_ParallelInit(&p, &gcm, iv, sizeof(iv), aad, sizeof(aad), sizes[j], threads, true);
+            assert_true(n <= threads);
+
+            for(i = n; i > 0U; i--){
+
+                MODA_AES_GCM_ParallelShare(&p, i - 1U, outText, pt, &share[i - 1U]);
+            }
+
+            MODA_AES_GCM_ParallelFinal(&p, share, outTag, sizeof(outTag));
+            assert_memory_equal(expectedTag, outTag, sizeof(outTag));
+            assert_memory_equal(ct, outText, sizes[j]);
+
+            /* decrypt in place */
+            n = MODA_AES_GCM_ParallelInit(&p, &gcm, iv, sizeof(iv), aad, sizeof(aad), sizes[j], threads, false);
+
+            for(i = 0U; i < n; i++){
+
+                MODA_AES_GCM_ParallelShare(&p, i, outText, outText, &share[i]);
+            }
+
+            assert_true(MODA_AES_GCM_ParallelCheck(&p, share, expectedTag, sizeof(expectedTag)));
+            assert_memory_equal(pt, outText, sizes[j]);
+        }
+    }
+
+    assert_memory_equal(fixtureTag, expectedTag, sizeof(fixtureTag));
+
+    /* one bad bit */
+    expectedTag[0] ^= 1U;
+    assert_false(MODA_AES_GCM_ParallelCheck(&p, share, expectedTag, sizeof(expectedTag)));
+}
+
+static void test_MODA_AES_GCM_Burst(void **user)
+{
+    static const uint32_t sizes[] = {0U, 1U, 15U, 16U, 17U, 64U, 100U, 1000U};
+
+    struct aes_gcm_ctxt gcm;
+    struct aes_gcm_packet pkt[21];
+    uint8_t iv[17];
+    uint8_t aad[77];
+    uint8_t pt[1000];
+    uint8_t ct[sizeof(pkt)/sizeof(*pkt)][sizeof(pt)];
+    uint8_t outText[sizeof(pkt)/sizeof(*pkt)][sizeof(pt)];
+    uint8_t expectedTag[sizeof(pkt)/sizeof(*pkt)][16];
+    uint8_t outTag[sizeof(pkt)/sizeof(*pkt)][16];
+    size_t i;
+
+    fill(pt, sizeof(pt), aad, sizeof(aad), iv, sizeof(iv));
+
+    MODA_AES_GCM_Init(&gcm, AES_KEY_128, fixtureKey);
+
+    /* more packets than one group, with mixed sizes and IVs */
+    for(i = 0U; i < (sizeof(pkt)/sizeof(*pkt)); i++){
+
+        pkt[i].iv = &iv[i % 5U];
+        pkt[i].ivSize = ((i % 3U) == 0U) ? 12U : 1U + (uint32_t)(i % 12U);
+        pkt[i].aad = aad;
+        pkt[i].aadSize = (uint32_t)((i * 7U) % sizeof(aad));
+        pkt[i].in = pt;
+        pkt[i].out = outText[i];
+        pkt[i].textSize = sizes[i % (sizeof(sizes)/sizeof(*sizes))];
+        pkt[i].t = outTag[i];
+        pkt[i].tSize = (uint8_t)(16U - (i % 5U));
+
+        MODA_AES_GCM_Seal(&gcm, pkt[i].iv, pkt[i].ivSize, ct[i], pt, pkt[i].textSize, aad, pkt[i].aadSize, expectedTag[i], pkt[i].tSize);
+    }
+
+    MODA_AES_GCM_SealBurst(&gcm, pkt, sizeof(pkt)/sizeof(*pkt));
+
+    for(i = 0U; i < (sizeof(pkt)/sizeof(*pkt)); i++){
+
+        assert_memory_equal(ct[i], outText[i], pkt[i].textSize);
+        assert_memory_equal(expectedTag[i], outTag[i], pkt[i].tSize);
+
+        /* open in place */
+        pkt[i].in = outText[i];
+    }
+
+    /* one bad tag */
+    outTag[9][0] ^= 1U;
+
+    assert_int_equal((sizeof(pkt)/sizeof(*pkt)) - 1U, MODA_AES_GCM_OpenBurst(&gcm, pkt, sizeof(pkt)/sizeof(*pkt)));
+
+    for(i = 0U; i < (sizeof(pkt)/sizeof(*pkt)); i++){
+
+        assert_true(pkt[i].valid == (i != 9U));
+        assert_memory_equal(pt, outText[i], pkt[i].textSize);
+    }
+
+    assert_int_equal(0U, MODA_AES_GCM_OpenBurst(&gcm, pkt, 0U));
+}
+
+static void test_MODA_AES_GCM_OpenVerified(void **user)
+{
+    struct aes_gcm_ctxt gcm;
+    uint8_t iv[17];
+    uint8_t aad[77];
+    uint8_t pt[1000];
+    uint8_t ct[sizeof(pt)];
+    uint8_t outText[sizeof(pt)];
+    uint8_t untouched[sizeof(pt)];
+    uint8_t badTag[sizeof(fixtureTag)];
+    uint32_t rejected;
+
+    fill(pt, sizeof(pt), aad, sizeof(aad), iv, sizeof(iv));
+
+    MODA_AES_GCM_Init(&gcm, AES_KEY_128, fixtureKey);
+    MODA_AES_GCM_Seal(&gcm, iv, sizeof(iv), ct, pt, sizeof(pt), aad, sizeof(aad), badTag, sizeof(badTag));
+
+    rejected = MODA_AES_GCM_Rejected();
+
+    assert_true(MODA_AES_GCM_OpenVerified(&gcm, iv, sizeof(iv), outText, ct, sizeof(ct), aad, sizeof(aad), fixtureTag, sizeof(fixtureTag)));
+    assert_memory_equal(pt, outText, sizeof(outText));
+    assert_int_equal(rejected, MODA_AES_GCM_Rejected());
+
+    /* forgeries leave the output alone */
+    (void)memset(outText, 0xa5, sizeof(outText));
+    (void)memcpy(untouched, outText, sizeof(untouched));
+
+    badTag[15] ^= 0x80U;
+    assert_false(MODA_AES_GCM_OpenVerified(&gcm, iv, sizeof(iv), outText, ct, sizeof(ct), aad, sizeof(aad), badTag, sizeof(badTag)));
+    assert_memory_equal(untouched, outText, sizeof(outText));
+
+    ct[500] ^= 1U;
+    assert_false(MODA_AES_GCM_OpenVerified(&gcm, iv, sizeof(iv), outText, ct, sizeof(ct), aad, sizeof(aad), fixtureTag, sizeof(fixtureTag)));
+    assert_memory_equal(untouched, outText, sizeof(outText));
+    ct[500] ^= 1U;
+
+    assert_int_equal(rejected + 2U, MODA_AES_GCM_Rejected());
+
+    /* in place */
+    assert_true(MODA_AES_GCM_OpenVerified(&gcm, iv, sizeof(iv), ct, ct, sizeof(ct), aad, sizeof(aad), fixtureTag, sizeof(fixtureTag)));
+    assert_memory_equal(pt, ct, sizeof(ct));
+}
+
 int main(void)
 {
     const struct CMUnitTest tests[] = {
@@ -330,6 +884,7 @@ int main(void)
         cmocka_unit_test(test_MODA_AES_GCM_Encrypt_parttext_noaad),     
         cmocka_unit_test(test_MODA_AES_GCM_Encrypt),     
         cmocka_unit_test(test_MODA_AES_GCM_Encrypt_oddiv),     
+        cmocka_unit_test(test_MODA_AES_GCM_Encrypt_long),     
         cmocka_unit_test(test_MODA_AES_GCM_Decrypt_notext),             
         cmocka_unit_test(test_MODA_AES_GCM_Decrypt_notext_noaad),             
         cmocka_unit_test(test_MODA_AES_GCM_Decrypt_notext_partaad),             
@@ -337,6 +892,15 @@ int main(void)
         cmocka_unit_test(test_MODA_AES_GCM_Decrypt_parttext_noaad),             
         cmocka_unit_test(test_MODA_AES_GCM_Decrypt),             
         cmocka_unit_test(test_MODA_AES_GCM_Decrypt_oddiv),             
+        cmocka_unit_test(test_MODA_AES_GCM_Decrypt_long),             
+        cmocka_unit_test(test_MODA_AES_GCM_Seal),
+        cmocka_unit_test(test_MODA_AES_GCM_Open),
+        cmocka_unit_test(test_MODA_AES_GCM_Seal_multiblock),
+        cmocka_unit_test(test_MODA_AES_GCM_InitTable),
+        cmocka_unit_test(test_MODA_AES_GCM_Stream),
+        cmocka_unit_test(test_MODA_AES_GCM_Parallel),
+        cmocka_unit_test(test_MODA_AES_GCM_Burst),
+        cmocka_unit_test(test_MODA_AES_GCM_OpenVerified),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -0,0 +1,133 @@
+/* Copyright (c) 2014 Cameron Harper
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * */
+
+/**
+ * @example test_aes_handle.c
+ *
+ * Rotating key handle
+ *
+ * */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+
+#include "cmocka.h"
+
+#include "aes.h"
+#include "aes_handle.h"
+
+static const uint8_t key1[16U] = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+static const uint8_t key2[24U] = {0x8e, 0x73, 0xb0, 0xf7, 0xda, 0x0e, 0x64, 0x52, 0xc8, 0x10, 0xf3, 0x2b, 0x80, 0x90, 0x79, 0xe5, 0x62, 0xf8, 0xea, 0xd2, 0x52, 0x2c, 0x6b, 0x7b};
+static const uint8_t key3[32U] = {0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81, 0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4};
+
+static struct aes_handle handle;
+static struct aes_handle_reader reader[2U];
+
+static void assert_key(const struct aes_ctxt *aes, enum aes_key_size keySize, const uint8_t *key)
+{
+    struct aes_ctxt expected;
+    uint8_t a[AES_BLOCK_SIZE];
+    uint8_t b[AES_BLOCK_SIZE];
+
+    assert_non_null(aes);
+
+    MODA_AES_Init(&expected, keySize, key);
+
+    (void)memset(a, 0x5a, sizeof(a));
+    (void)memset(b, 0x5a, sizeof(b));
+
+    MODA_AES_Encrypt(&expected, a);
+    MODA_AES_Encrypt(aes, b);
+
+    assert_memory_equal(a, b, sizeof(a));
+}
+
+static void test_MODA_AES_HandleEnter(void **user)
+{
+    uint32_t epoch = 0U;
+
+    MODA_AES_HandleInit(&handle, reader, 2U, AES_KEY_128, key1);
+
+    assert_key(MODA_AES_HandleEnter(&handle, &reader[0], &epoch), AES_KEY_128, key1);
+    assert_int_equal(1U, epoch);
+    MODA_AES_HandleExit(&handle, &reader[0]);
+
+    assert_null(MODA_AES_HandleEnterEpoch(&handle, &reader[0], 2U));
+    assert_null(MODA_AES_HandleEnterEpoch(&handle, &reader[0], 0U));
+    assert_int_equal(0U, reader[0].epoch);
+}
+
+static void test_MODA_AES_HandleRotate(void **user)
+{
+    uint32_t epoch = 0U;
+    uint32_t i;
+
+    MODA_AES_HandleInit(&handle, reader, 2U, AES_KEY_128, key1);
+
+    /* reader 0 holds epoch 1 across rotations */
+    assert_key(MODA_AES_HandleEnter(&handle, &reader[0], NULL), AES_KEY_128, key1);
+
+    /* fill every slot */
+    for(i = 1U; i < MODA_AES_HANDLE_VERSIONS; i++){
+
+        assert_true(MODA_AES_HandleRotate(&handle, AES_KEY_192, key2));
+    }
+
+    assert_key(MODA_AES_HandleEnter(&handle, &reader[1], &epoch), AES_KEY_192, key2);
+    assert_int_equal(MODA_AES_HANDLE_VERSIONS, epoch);
+    MODA_AES_HandleExit(&handle, &reader[1]);
+
+    /* earlier epochs are still there for decryption */
+    assert_key(MODA_AES_HandleEnterEpoch(&handle, &reader[1], 1U), AES_KEY_128, key1);
+    MODA_AES_HandleExit(&handle, &reader[1]);
+
+    /* epoch 1's slot is needed but still held */
+    assert_false(MODA_AES_HandleRotate(&handle, AES_KEY_256, key3));
+
+    /* retired: no new readers, the old one is undisturbed */
+    assert_null(MODA_AES_HandleEnterEpoch(&handle, &reader[1], 1U));
+    assert_key(MODA_AES_HandleEnter(&handle, &reader[1], &epoch), AES_KEY_192, key2);
+    assert_int_equal(MODA_AES_HANDLE_VERSIONS, epoch);
+    MODA_AES_HandleExit(&handle, &reader[1]);
+
+    MODA_AES_HandleExit(&handle, &reader[0]);
+
+    assert_true(MODA_AES_HandleRotate(&handle, AES_KEY_256, key3));
+
+    assert_key(MODA_AES_HandleEnter(&handle, &reader[0], &epoch), AES_KEY_256, key3);
+    assert_int_equal(MODA_AES_HANDLE_VERSIONS + 1U, epoch);
+    MODA_AES_HandleExit(&handle, &reader[0]);
+
+    assert_key(MODA_AES_HandleEnterEpoch(&handle, &reader[0], MODA_AES_HANDLE_VERSIONS), AES_KEY_192, key2);
+    MODA_AES_HandleExit(&handle, &reader[0]);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_MODA_AES_HandleEnter),
+        cmocka_unit_test(test_MODA_AES_HandleRotate)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
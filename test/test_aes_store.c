@@ -0,0 +1,231 @@
+/* Copyright (c) 2014 Cameron Harper
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * */
+
+/**
+ * @example test_aes_store.c
+ *
+ * Expanded key store
+ *
+ * */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+
+#include "cmocka.h"
+
+#include "aes.h"
+#include "aes_store.h"
+#include "aes_gcm.h"
+
+#define COUNT 40U
+#define PER_PAGE 15U
+#define PAGES 3U
+
+static MODA_ALIGN(MODA_AES_ALIGN) uint8_t image[AES_STORE_ALIGN + (COUNT * sizeof(struct aes_store_entry))];
+
+static uint8_t verified[PAGES];
+
+static struct aes_ctxt mac;
+
+static const enum aes_key_size sizes[] = {AES_KEY_128, AES_KEY_192, AES_KEY_256};
+
+static void makeKey(uint8_t *key, uint32_t n)
+{
+    uint8_t i;
+
+    for(i = 0U; i < 32U; i++){
+
+        key[i] = (uint8_t)((i * 5U) ^ n);
+    }
+}
+
+static int setup(void **user)
+{
+    static const uint8_t macKey[] = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+    uint8_t key[32U];
+    uint32_t i;
+
+    MODA_AES_Init(&mac, AES_KEY_128, macKey);
+
+    if(!MODA_AES_StoreFormat(image, sizeof(image), COUNT, PER_PAGE)){
+
+        return -1;
+    }
+
+    for(i = 0U; i < COUNT; i++){
+
+        makeKey(key, i);
+        MODA_AES_StorePut(image, i, sizes[i % 3U], key);
+    }
+
+    MODA_AES_StoreSeal(image, &mac);
+
+    return 0;
+}
+
+static void test_MODA_AES_StoreSize(void **user)
+{
+    assert_int_equal(sizeof(image), MODA_AES_StoreSize(COUNT, PER_PAGE));
+    assert_false(MODA_AES_StoreFormat(image, sizeof(image) - 1U, COUNT, PER_PAGE));
+}
+
+static void test_MODA_AES_StoreGet(void **user)
+{
+    struct aes_store store;
+    const struct aes_store_entry *entry;
+    static const uint8_t iv[] = {0xca,0xfe,0xba,0xbe,0xfa,0xce,0xdb,0xad,0xde,0xca,0xf8,0x88};
+    struct aes_gcm_ctxt gcm;
+    uint8_t key[32U];
+    uint8_t expected[AES_BLOCK_SIZE];
+    uint8_t expectedTag[AES_BLOCK_SIZE];
+    uint8_t tag[AES_BLOCK_SIZE];
+    uint8_t s[AES_BLOCK_SIZE];
+    uint8_t ct[AES_BLOCK_SIZE];
+    uint32_t i;
+
+    assert_true(MODA_AES_StoreOpen(&store, image, sizeof(image), &mac, verified, sizeof(verified)));
+
+    /* nothing is checked until it is used */
+    assert_int_equal(0U, verified[0]);
+    assert_int_equal(0U, verified[1]);
+    assert_int_equal(0U, verified[2]);
+
+    assert_non_null(MODA_AES_StoreGet(&store, 20U));
+
+    assert_int_equal(0U, verified[0]);
+    assert_int_not_equal(0U, verified[1]);
+    assert_int_equal(0U, verified[2]);
+
+    for(i = 0U; i < COUNT; i++){
+
+        makeKey(key, i);
+        MODA_AES_GCM_Init(&gcm, sizes[i % 3U], key);
+
+        (void)memset(expected, (int)i, sizeof(expected));
+        (void)memcpy(s, expected, sizeof(s));
+
+        MODA_AES_GCM_Seal(&gcm, iv, sizeof(iv), ct, s, sizeof(s), NULL, 0U, expectedTag, sizeof(expectedTag));
+        MODA_AES_Encrypt(&gcm.aes, expected);
+
+        entry = MODA_AES_StoreGet(&store, i);
+
+        assert_non_null(entry);
+#if !defined(MODA_AES_OTF)
+        assert_int_equal(0U, ((uintptr_t)&entry->gcm.aes) % MODA_AES_ALIGN);
+#endif
+
+        /* GCM straight from the image, no key expansion or H */
+        MODA_AES_GCM_Seal(&entry->gcm, iv, sizeof(iv), ct, s, sizeof(s), NULL, 0U, tag, sizeof(tag));
+        assert_memory_equal(expectedTag, tag, sizeof(tag));
+
+        MODA_AES_Encrypt(&entry->gcm.aes, s);
+        assert_memory_equal(expected, s, sizeof(s));
+    }
+
+    assert_null(MODA_AES_StoreGet(&store, COUNT));
+}
+
+static void test_MODA_AES_StoreGet_corrupt(void **user)
+{
+    struct aes_store store;
+    const struct aes_store_entry *entry;
+    uint8_t *b;
+
+    assert_true(MODA_AES_StoreOpen(&store, image, sizeof(image), &mac, verified, sizeof(verified)));
+
+    entry = MODA_AES_StoreGet(&store, 17U);
+    assert_non_null(entry);
+
+    /* flip a round key bit in the last page */
+    b = (uint8_t *)&entry[COUNT - 17U - 1U].gcm.aes.k[5];
+    *b ^= 0x01U;
+
+    assert_true(MODA_AES_StoreOpen(&store, image, sizeof(image), &mac, verified, sizeof(verified)));
+
+    assert_non_null(MODA_AES_StoreGet(&store, 0U));
+    assert_non_null(MODA_AES_StoreGet(&store, 29U));
+    assert_null(MODA_AES_StoreGet(&store, 30U));
+    assert_null(MODA_AES_StoreGet(&store, COUNT - 1U));
+
+    *b ^= 0x01U;
+
+    assert_true(MODA_AES_StoreOpen(&store, image, sizeof(image), &mac, verified, sizeof(verified)));
+    assert_non_null(MODA_AES_StoreGet(&store, COUNT - 1U));
+}
+
+static void test_MODA_AES_StoreOpen_reject(void **user)
+{
+    static const uint8_t otherKey[16U] = {0};
+    struct aes_store store;
+    struct aes_ctxt other;
+    struct aes_store_header *header = (struct aes_store_header *)(void *)image;
+
+    MODA_AES_Init(&other, AES_KEY_128, otherKey);
+
+    /* wrong key */
+    assert_false(MODA_AES_StoreOpen(&store, image, sizeof(image), &other, verified, sizeof(verified)));
+
+    /* truncated */
+    assert_false(MODA_AES_StoreOpen(&store, image, sizeof(image) - 1U, &mac, verified, sizeof(verified)));
+
+    /* not enough verification state */
+    assert_false(MODA_AES_StoreOpen(&store, image, sizeof(image), &mac, verified, sizeof(verified) - 1U));
+
+    /* header tampered */
+    header->count++;
+    assert_false(MODA_AES_StoreOpen(&store, image, sizeof(image), &mac, verified, sizeof(verified)));
+    header->count--;
+
+    /* swapped page tags */
+    {
+        uint8_t *tags = &image[sizeof(struct aes_store_header)];
+        uint8_t t[AES_STORE_TAG_SIZE];
+
+        (void)memcpy(t, tags, sizeof(t));
+        (void)memcpy(tags, &tags[AES_STORE_TAG_SIZE], sizeof(t));
+        (void)memcpy(&tags[AES_STORE_TAG_SIZE], t, sizeof(t));
+
+        assert_true(MODA_AES_StoreOpen(&store, image, sizeof(image), &mac, verified, sizeof(verified)));
+        assert_null(MODA_AES_StoreGet(&store, 0U));
+        assert_null(MODA_AES_StoreGet(&store, PER_PAGE));
+        assert_non_null(MODA_AES_StoreGet(&store, 2U * PER_PAGE));
+
+        (void)memcpy(&tags[AES_STORE_TAG_SIZE], tags, sizeof(t));
+        (void)memcpy(tags, t, sizeof(t));
+    }
+
+    assert_true(MODA_AES_StoreOpen(&store, image, sizeof(image), &mac, verified, sizeof(verified)));
+    assert_non_null(MODA_AES_StoreGet(&store, 0U));
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_MODA_AES_StoreSize),
+        cmocka_unit_test(test_MODA_AES_StoreGet),
+        cmocka_unit_test(test_MODA_AES_StoreGet_corrupt),
+        cmocka_unit_test(test_MODA_AES_StoreOpen_reject)
+    };
+
+    return cmocka_run_group_tests(tests, setup, NULL);
+}